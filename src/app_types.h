@@ -30,7 +30,9 @@ typedef struct {
 typedef struct {
     GtkWidget *entry;
     GtkWidget *button;
-    GtkWidget *list;
+    GtkWidget *list;             // 搜索结果 GtkListView
+    GListStore *results_store;   // 搜索结果条目（YgoCardItem）
+    GHashTable *pending_thumb_targets; // img_id -> 等待加载缩略图的行控件数组（弱引用）
     SoupSession *session;
     GtkStack *left_stack;
     GtkPicture *left_picture;
@@ -60,11 +62,15 @@ typedef struct {
     // 搜索结果图片加载队列
     GPtrArray *search_image_queue;
     guint search_image_loader_id;
+    gboolean image_queue_dirty;  // 有新条目入队或视口滚动，取下一批前需要按视口重新排序
+    guint thumb_reprioritize_id; // 滚动后重排下载队列的 idle ID
     // 批量渲染队列
     GPtrArray *pending_results;  // 存储待渲染的JsonObject
     guint batch_render_id;       // idle callback的ID
     // 搜索代次计数器（每次搜索递增，用于检测过期回调）
     guint64 search_generation;
+    // 当前后台搜索的取消句柄（新搜索开始时取消）
+    GCancellable *search_cancellable;
     // 窗口引用（用于显示对话框）
     AdwApplicationWindow *window;
     // Toast overlay（用于显示通知）
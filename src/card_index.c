@@ -0,0 +1,257 @@
+#include "card_index.h"
+#include "search_keys.h"
+#include <stdlib.h>
+#include <string.h>
+
+// n-gram 编码：Unicode 码点最多 21 位，三字正好放进 63 位；双字额外置最高位区分。
+#define GRAM_BIGRAM_TAG ((guint64)1 << 63)
+#define GRAM_BIGRAM(a, b) (GRAM_BIGRAM_TAG | ((guint64)(a) << 21) | (guint64)(b))
+#define GRAM_TRIGRAM(a, b, c) (((guint64)(a) << 42) | ((guint64)(b) << 21) | (guint64)(c))
+
+struct CardSearchIndex {
+    gint ref_count;
+    SearchKeys *keys;   // 与卡片顺序对齐的折叠搜索键
+    guint64 *grams;     // 升序排列的 n-gram
+    guint32 *offsets;   // grams[i] 的倒排表为 postings[offsets[i], offsets[i+1])
+    guint32 *postings;  // 卡片下标，每个倒排表内升序
+    guint n_grams;
+};
+
+typedef struct {
+    guint64 gram;
+    guint32 card;
+} GramPosting;
+
+// 参与搜索的字段：卡名 + 效果描述（pdesc/types 不参与）
+static const CardStoreStringField indexed_fields[] = {
+    CARD_STORE_STR_CN_NAME, CARD_STORE_STR_SC_NAME, CARD_STORE_STR_MD_NAME,
+    CARD_STORE_STR_JP_NAME, CARD_STORE_STR_EN_NAME, CARD_STORE_STR_NWBBS_N,
+    CARD_STORE_STR_CNOCG_N, CARD_STORE_STR_DESC
+};
+
+static gboolean is_wide_char(gunichar c) {
+    return g_unichar_iswide(c);
+}
+
+// 生成文本的全部 n-gram：窗口内含等宽字符时取双字，否则取三字；跨越字段分隔符的窗口跳过
+static void append_grams(const char *text_folded, GArray *out) {
+    glong n = 0;
+    gunichar *cps = g_utf8_to_ucs4_fast(text_folded, -1, &n);
+    if (!cps) return;
+
+    for (glong i = 0; i + 1 < n; i++) {
+        if (cps[i] == SEARCH_KEY_FIELD_SEP || cps[i + 1] == SEARCH_KEY_FIELD_SEP) continue;
+        gboolean w0 = is_wide_char(cps[i]);
+        gboolean w1 = is_wide_char(cps[i + 1]);
+        if (w0 || w1) {
+            guint64 gram = GRAM_BIGRAM(cps[i], cps[i + 1]);
+            g_array_append_val(out, gram);
+        } else if (i + 2 < n && cps[i + 2] != SEARCH_KEY_FIELD_SEP && !is_wide_char(cps[i + 2])) {
+            guint64 gram = GRAM_TRIGRAM(cps[i], cps[i + 1], cps[i + 2]);
+            g_array_append_val(out, gram);
+        }
+    }
+    g_free(cps);
+}
+
+static int compare_gram(const void *a, const void *b) {
+    guint64 x = *(const guint64 *)a;
+    guint64 y = *(const guint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_posting(const void *a, const void *b) {
+    const GramPosting *x = (const GramPosting *)a;
+    const GramPosting *y = (const GramPosting *)b;
+    if (x->gram != y->gram) return (x->gram > y->gram) - (x->gram < y->gram);
+    return (x->card > y->card) - (x->card < y->card);
+}
+
+// 排序并去重（原地）
+static void sort_unique_grams(GArray *grams) {
+    if (grams->len < 2) return;
+    qsort(grams->data, grams->len, sizeof(guint64), compare_gram);
+    guint64 *g = (guint64 *)grams->data;
+    guint w = 1;
+    for (guint r = 1; r < grams->len; r++) {
+        if (g[r] != g[w - 1]) g[w++] = g[r];
+    }
+    g_array_set_size(grams, w);
+}
+
+CardSearchIndex* card_search_index_build(const CardStore *store) {
+    if (!store) return NULL;
+    gint64 start_us = g_get_monotonic_time();
+
+    guint count = card_store_get_count(store);
+    SearchKeys *keys = search_keys_new(count);
+    GArray *pairs = g_array_sized_new(FALSE, FALSE, sizeof(GramPosting), count * 128);
+    GArray *card_grams = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+    for (guint i = 0; i < count; i++) {
+        const char *fields[G_N_ELEMENTS(indexed_fields)];
+        for (guint f = 0; f < G_N_ELEMENTS(indexed_fields); f++) {
+            fields[f] = card_store_get_string(store, i, indexed_fields[f]);
+        }
+        // 折叠一次写入键区，n-gram 直接取自折叠后的键，保证与查询侧一致
+        search_keys_append(keys, fields, G_N_ELEMENTS(indexed_fields));
+
+        g_array_set_size(card_grams, 0);
+        append_grams(search_keys_get(keys, i, NULL), card_grams);
+        // 同一张卡内的重复 n-gram 只记录一次
+        sort_unique_grams(card_grams);
+        for (guint k = 0; k < card_grams->len; k++) {
+            GramPosting p = { g_array_index(card_grams, guint64, k), i };
+            g_array_append_val(pairs, p);
+        }
+    }
+    g_array_unref(card_grams);
+
+    qsort(pairs->data, pairs->len, sizeof(GramPosting), compare_posting);
+
+    CardSearchIndex *index = g_new0(CardSearchIndex, 1);
+    index->ref_count = 1;
+    index->keys = keys;
+    index->postings = g_new(guint32, MAX(pairs->len, 1));
+
+    // 统计不同 n-gram 数量后一次性分配
+    guint n_grams = 0;
+    for (guint k = 0; k < pairs->len; k++) {
+        if (k == 0 || g_array_index(pairs, GramPosting, k).gram != g_array_index(pairs, GramPosting, k - 1).gram) {
+            n_grams++;
+        }
+    }
+    index->grams = g_new(guint64, MAX(n_grams, 1));
+    index->offsets = g_new(guint32, n_grams + 1);
+    index->n_grams = n_grams;
+
+    guint g = 0;
+    for (guint k = 0; k < pairs->len; k++) {
+        const GramPosting *p = &g_array_index(pairs, GramPosting, k);
+        if (k == 0 || p->gram != index->grams[g - 1]) {
+            index->grams[g] = p->gram;
+            index->offsets[g] = k;
+            g++;
+        }
+        index->postings[k] = p->card;
+    }
+    index->offsets[n_grams] = pairs->len;
+
+    g_message("Card search index built: %u cards, %u grams, %u postings in %.1f ms",
+              count, n_grams, pairs->len, (g_get_monotonic_time() - start_us) / 1000.0);
+    g_array_unref(pairs);
+    return index;
+}
+
+CardSearchIndex* card_search_index_ref(CardSearchIndex *index) {
+    if (index) g_atomic_int_inc(&index->ref_count);
+    return index;
+}
+
+void card_search_index_unref(CardSearchIndex *index) {
+    if (!index) return;
+    if (g_atomic_int_dec_and_test(&index->ref_count)) {
+        search_keys_free(index->keys);
+        g_free(index->grams);
+        g_free(index->offsets);
+        g_free(index->postings);
+        g_free(index);
+    }
+}
+
+const SearchKeys* card_search_index_get_keys(const CardSearchIndex *index) {
+    return index ? index->keys : NULL;
+}
+
+// 二分查找 n-gram 的倒排表；不存在返回 FALSE
+static gboolean find_posting_list(const CardSearchIndex *index, guint64 gram,
+                                  const guint32 **list, guint *len) {
+    guint lo = 0, hi = index->n_grams;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (index->grams[mid] < gram) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo >= index->n_grams || index->grams[lo] != gram) return FALSE;
+    *list = index->postings + index->offsets[lo];
+    *len = index->offsets[lo + 1] - index->offsets[lo];
+    return TRUE;
+}
+
+typedef struct {
+    const guint32 *list;
+    guint len;
+} PostingList;
+
+static int compare_posting_list_len(const void *a, const void *b) {
+    guint x = ((const PostingList *)a)->len;
+    guint y = ((const PostingList *)b)->len;
+    return (x > y) - (x < y);
+}
+
+// 在升序数组 list[from, len) 中查找第一个 >= value 的位置（倍增 + 二分）
+static guint gallop_lower_bound(const guint32 *list, guint from, guint len, guint32 value) {
+    guint step = 1;
+    guint hi = from;
+    while (hi < len && list[hi] < value) {
+        from = hi + 1;
+        hi += step;
+        step <<= 1;
+    }
+    if (hi > len) hi = len;
+    while (from < hi) {
+        guint mid = from + (hi - from) / 2;
+        if (list[mid] < value) from = mid + 1;
+        else hi = mid;
+    }
+    return from;
+}
+
+GArray* card_search_index_lookup(const CardSearchIndex *index, const char *query_folded) {
+    if (!index || !query_folded || query_folded[0] == '\0') return NULL;
+
+    GArray *grams = g_array_new(FALSE, FALSE, sizeof(guint64));
+    append_grams(query_folded, grams);
+    sort_unique_grams(grams);
+    if (grams->len == 0) {
+        g_array_unref(grams);
+        return NULL;
+    }
+
+    GArray *result = g_array_new(FALSE, FALSE, sizeof(guint32));
+    PostingList *lists = g_new(PostingList, grams->len);
+    guint n_lists = grams->len;
+    for (guint i = 0; i < n_lists; i++) {
+        if (!find_posting_list(index, g_array_index(grams, guint64, i), &lists[i].list, &lists[i].len)) {
+            // 任一 n-gram 不存在则不可能命中
+            g_free(lists);
+            g_array_unref(grams);
+            return result;
+        }
+    }
+    g_array_unref(grams);
+
+    // 从最短的倒排表出发，依次在其余表中倍增查找
+    qsort(lists, n_lists, sizeof(PostingList), compare_posting_list_len);
+    guint *cursor = g_new0(guint, n_lists);
+    gboolean exhausted = FALSE;
+    for (guint k = 0; k < lists[0].len && !exhausted; k++) {
+        guint32 card = lists[0].list[k];
+        gboolean in_all = TRUE;
+        for (guint j = 1; j < n_lists && in_all; j++) {
+            cursor[j] = gallop_lower_bound(lists[j].list, cursor[j], lists[j].len, card);
+            if (cursor[j] >= lists[j].len) {
+                // 该表已耗尽，后续不可能再有交集
+                exhausted = TRUE;
+                in_all = FALSE;
+            } else if (lists[j].list[cursor[j]] != card) {
+                in_all = FALSE;
+            }
+        }
+        if (in_all) g_array_append_val(result, card);
+    }
+
+    g_free(cursor);
+    g_free(lists);
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef CARD_INDEX_H
+#define CARD_INDEX_H
+
+#include <glib.h>
+#include "card_store.h"
+#include "search_keys.h"
+
+// 离线卡片 n-gram 倒排索引：对卡名字段和效果描述（折叠为搜索键后）建立
+// 中日韩等宽字符的双字（bigram）与拉丁等窄字符的三字（trigram）索引。
+// 每个 n-gram 只由窗口内的字符决定，因此查询串的所有 n-gram 一定出现在
+// 包含该查询串的文本中；求交集得到的候选集再做一次子串校验即可得到精确结果。
+
+typedef struct CardSearchIndex CardSearchIndex;
+
+/**
+ * 为离线卡片存储建立倒排索引（较耗时，应在后台线程调用）
+ * @param store 离线卡片存储
+ * @return 索引对象（引用计数为 1），调用者需要 card_search_index_unref 释放
+ */
+CardSearchIndex* card_search_index_build(const CardStore *store);
+
+CardSearchIndex* card_search_index_ref(CardSearchIndex *index);
+void card_search_index_unref(CardSearchIndex *index);
+
+/**
+ * 获取与卡片顺序对齐的折叠搜索键（由索引持有，随索引释放）
+ */
+const SearchKeys* card_search_index_get_keys(const CardSearchIndex *index);
+
+/**
+ * 查询候选卡片
+ * @param index 倒排索引
+ * @param query_folded 已用 search_key_fold 折叠的查询串
+ * @return 按存储顺序升序排列的候选下标数组（guint32），需要 g_array_unref 释放；
+ *         查询串过短无法生成 n-gram 时返回 NULL，调用者应退化为全量扫描
+ */
+GArray* card_search_index_lookup(const CardSearchIndex *index, const char *query_folded);
+
+#endif // CARD_INDEX_H
@@ -1,10 +1,12 @@
 // card_info.c
 // 用于分解卡片类别信息
 #include "card_info.h"
+#include "app_path.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 // constant.lua TYPE 部分参考
 #define TYPE_MONSTER      0x1
@@ -378,26 +380,67 @@ uint32_t get_race_from_string(const char* race) {
     return 0;
 }
 
-// 获取strings.conf文件路径
+// strings.conf 中 !setname 的解析缓存：首次使用时读取一次，文件 mtime 变化
+// 或离线数据更新（card_info_invalidate_setnames）后重新加载。
+typedef struct {
+    guint64 code;       // !setname 中的原始代码
+    guint32 name_off;   // 字段名在 setname_names 中的起始位置
+} SetnameEntry;
+
+static GMutex setname_mutex;
+static GHashTable *setname_table = NULL;   // 字段名 -> GArray<guint64>（同名可能对应多个代码）
+static GString *setname_names = NULL;      // 所有字段名依次拼接，以 '\n' 分隔，用于子串查找
+static GArray *setname_entries = NULL;     // SetnameEntry，按 name_off 升序
+static gint64 setname_mtime = 0;
+static guint setname_generation = 0;       // 每次失效加一，供已编译的筛选谓词判断是否过期
+
+// 获取strings.conf文件路径（与离线数据目录一致，区分便携模式）
 static gchar* get_strings_conf_path(void) {
-    // 从offline_data模块获取cards目录路径
-    // 这里需要包含app_path.h和offline_data相关的逻辑
+    if (is_portable_mode()) {
+        const char *prog_dir = get_program_directory();
+        return g_build_filename(prog_dir, "data", "cards", "strings.conf", NULL);
+    }
     const char *data_home = g_get_user_data_dir();
     return g_build_filename(data_home, "ygo-deck-builder", "cards", "strings.conf", NULL);
 }
 
-// 从字段名字符串获取对应的setcode值（十进制）
-uint64_t get_setcode_from_field_name(const char* field_name) {
-    if (!field_name || field_name[0] == '\0') {
-        return 0;
+static void setname_clear_locked(void) {
+    g_clear_pointer(&setname_table, g_hash_table_destroy);
+    if (setname_names) {
+        g_string_free(setname_names, TRUE);
+        setname_names = NULL;
     }
-    
+    g_clear_pointer(&setname_entries, g_array_unref);
+    setname_mtime = 0;
+}
+
+void card_info_invalidate_setnames(void) {
+    g_mutex_lock(&setname_mutex);
+    setname_clear_locked();
+    g_mutex_unlock(&setname_mutex);
+    g_atomic_int_inc((gint*)&setname_generation);
+}
+
+guint card_info_setnames_generation(void) {
+    return (guint)g_atomic_int_get((gint*)&setname_generation);
+}
+
+static gboolean setname_ensure_loaded_locked(void) {
     gchar *strings_path = get_strings_conf_path();
-    if (!strings_path || !g_file_test(strings_path, G_FILE_TEST_EXISTS)) {
+    GStatBuf st;
+    if (!strings_path || g_stat(strings_path, &st) != 0) {
         g_free(strings_path);
-        return 0;
+        setname_clear_locked();
+        return FALSE;
     }
-    
+
+    gint64 mtime = (gint64)st.st_mtime;
+    if (setname_table && setname_mtime == mtime) {
+        g_free(strings_path);
+        return TRUE;
+    }
+    setname_clear_locked();
+
     // 读取strings.conf文件
     gchar *content = NULL;
     GError *error = NULL;
@@ -407,81 +450,167 @@ uint64_t get_setcode_from_field_name(const char* field_name) {
             g_error_free(error);
         }
         g_free(strings_path);
-        return 0;
+        return FALSE;
     }
     g_free(strings_path);
-    
+
+    setname_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+    setname_names = g_string_new(NULL);
+    setname_entries = g_array_new(FALSE, FALSE, sizeof(SetnameEntry));
+
     // 逐行解析文件
     gchar **lines = g_strsplit(content, "\n", -1);
     g_free(content);
-    
-    uint64_t result = 0;
+
     for (int i = 0; lines[i] != NULL; i++) {
         gchar *line = g_strstrip(lines[i]);
-        
-        // 跳过空行和注释
-        if (line[0] == '\0' || line[0] == '#') {
+
+        // 只处理以"!setname"开头的行，格式：!setname 0x十六进制 字段名
+        if (!g_str_has_prefix(line, "!setname")) {
             continue;
         }
-        
-        // 查找以"!setname"开头的行
-        if (g_str_has_prefix(line, "!setname")) {
-            // 格式：!setname 0x十六进制 字段名
-            gchar **parts = g_strsplit(line, " ", 3);
-            if (g_strv_length(parts) >= 3) {
-                const gchar *hex_str = parts[1];
-                const gchar *name = parts[2];
-                
-                // 检查字段名是否匹配
-                if (name && strstr(name, field_name) != NULL) {
-                    // 解析十六进制数（去掉"0x"前缀）
-                    if (g_str_has_prefix(hex_str, "0x") || g_str_has_prefix(hex_str, "0X")) {
-                        result = g_ascii_strtoull(hex_str + 2, NULL, 16);
-                        g_strfreev(parts);
-                        break;
-                    }
+        gchar **parts = g_strsplit(line, " ", 3);
+        if (g_strv_length(parts) >= 3 &&
+            (g_str_has_prefix(parts[1], "0x") || g_str_has_prefix(parts[1], "0X"))) {
+            guint64 code = g_ascii_strtoull(parts[1] + 2, NULL, 16);
+            const gchar *name = parts[2];
+            if (code != 0 && name[0] != '\0') {
+                GArray *codes = g_hash_table_lookup(setname_table, name);
+                if (!codes) {
+                    codes = g_array_new(FALSE, FALSE, sizeof(guint64));
+                    g_hash_table_insert(setname_table, g_strdup(name), codes);
                 }
+                g_array_append_val(codes, code);
+
+                SetnameEntry entry = { code, (guint32)setname_names->len };
+                g_array_append_val(setname_entries, entry);
+                g_string_append(setname_names, name);
+                g_string_append_c(setname_names, '\n');
             }
-            g_strfreev(parts);
         }
+        g_strfreev(parts);
     }
-    
     g_strfreev(lines);
+
+    setname_mtime = mtime;
+    g_message("Loaded %u setnames from strings.conf", setname_entries->len);
+    return TRUE;
+}
+
+// 根据 setname_names 中的位置找到所属条目下标
+static guint setname_entry_at(guint32 pos) {
+    guint lo = 0, hi = setname_entries->len;
+    while (hi - lo > 1) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(setname_entries, SetnameEntry, mid).name_off <= pos) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// 在已加载的表中查找所有名称包含 field_name 的条目；first_only 时只取第一个
+static void setname_collect_locked(const char *field_name, gboolean first_only, GArray *out_codes) {
+    // 精确命中时直接使用哈希表
+    GArray *exact = g_hash_table_lookup(setname_table, field_name);
+    if (exact && first_only) {
+        g_array_append_val(out_codes, g_array_index(exact, guint64, 0));
+        return;
+    }
+
+    // 子串查找：在拼接后的名称区上连续 strstr，每命中一次跳到下一个条目
+    const char *base = setname_names->str;
+    const char *p = base;
+    while ((p = strstr(p, field_name)) != NULL) {
+        guint idx = setname_entry_at((guint32)(p - base));
+        const SetnameEntry *entry = &g_array_index(setname_entries, SetnameEntry, idx);
+        g_array_append_val(out_codes, entry->code);
+        if (first_only) return;
+        if (idx + 1 >= setname_entries->len) break;
+        p = base + g_array_index(setname_entries, SetnameEntry, idx + 1).name_off;
+    }
+}
+
+// 从字段名字符串获取对应的setcode值（十进制）
+uint64_t get_setcode_from_field_name(const char* field_name) {
+    if (!field_name || field_name[0] == '\0') {
+        return 0;
+    }
+
+    uint64_t result = 0;
+    GArray *codes = g_array_new(FALSE, FALSE, sizeof(guint64));
+    g_mutex_lock(&setname_mutex);
+    if (setname_ensure_loaded_locked()) {
+        setname_collect_locked(field_name, TRUE, codes);
+    }
+    g_mutex_unlock(&setname_mutex);
+    if (codes->len > 0) {
+        result = g_array_index(codes, guint64, 0);
+    }
+    g_array_unref(codes);
     return result;
 }
 
-// 检查卡片的setcode是否匹配给定的字段名
-gboolean match_setcode_with_field(uint64_t card_setcode, const char* field_name) {
+GArray* resolve_setcodes_for_field(const char* field_name) {
+    GArray *result = g_array_new(FALSE, FALSE, sizeof(guint16));
     if (!field_name || field_name[0] == '\0') {
-        return TRUE;  // 空字段名视为不筛选
+        return result;
     }
-    
-    if (card_setcode == 0) {
-        return FALSE;  // 卡片没有setcode
+
+    GArray *codes = g_array_new(FALSE, FALSE, sizeof(guint64));
+    g_mutex_lock(&setname_mutex);
+    if (setname_ensure_loaded_locked()) {
+        setname_collect_locked(field_name, FALSE, codes);
     }
-    
-    // 获取字段名对应的setcode
-    uint64_t target_setcode = get_setcode_from_field_name(field_name);
-    if (target_setcode == 0) {
-        return FALSE;  // 未找到对应的字段
+    g_mutex_unlock(&setname_mutex);
+
+    // 取低12位作为实际代码并去重
+    for (guint i = 0; i < codes->len; i++) {
+        guint16 code = (guint16)(g_array_index(codes, guint64, i) & 0xFFF);
+        gboolean seen = FALSE;
+        for (guint j = 0; j < result->len && !seen; j++) {
+            seen = (g_array_index(result, guint16, j) == code);
+        }
+        if (!seen) g_array_append_val(result, code);
     }
-    
+    g_array_unref(codes);
+    return result;
+}
+
+gboolean match_setcode_with_codes(uint64_t card_setcode, const GArray* codes) {
+    if (!codes || codes->len == 0 || card_setcode == 0) {
+        return FALSE;
+    }
+
     // setcode是64位整数，可能包含多个字段代码（每16位一个）
-    // 需要逐个检查
     for (int shift = 0; shift < 64; shift += 16) {
         uint64_t code_part = (card_setcode >> shift) & 0xFFFF;
         if (code_part == 0) {
             break;  // 没有更多字段代码
         }
-        
-        // 检查是否匹配（考虑掩码）
-        uint64_t target_masked = target_setcode & 0xFFF;  // 取低12位作为实际代码
-        uint64_t card_masked = code_part & 0xFFF;
-        
-        if (card_masked == target_masked) {
-            return TRUE;
+        guint16 card_masked = (guint16)(code_part & 0xFFF);
+        for (guint i = 0; i < codes->len; i++) {
+            if (g_array_index(codes, guint16, i) == card_masked) {
+                return TRUE;
+            }
         }
     }
-    
+
     return FALSE;
 }
+
+// 检查卡片的setcode是否匹配给定的字段名
+gboolean match_setcode_with_field(uint64_t card_setcode, const char* field_name) {
+    if (!field_name || field_name[0] == '\0') {
+        return TRUE;  // 空字段名视为不筛选
+    }
+    
+    if (card_setcode == 0) {
+        return FALSE;  // 卡片没有setcode
+    }
+    
+    // 按字段名解析出全部字段代码（读取缓存的 strings.conf 表，不再访问磁盘）
+    GArray *codes = resolve_setcodes_for_field(field_name);
+    gboolean match = match_setcode_with_codes(card_setcode, codes);
+    g_array_unref(codes);
+    return match;
+}
@@ -54,4 +54,18 @@ uint64_t get_setcode_from_field_name(const char* field_name);
 // 返回值：TRUE表示匹配，FALSE表示不匹配
 gboolean match_setcode_with_field(uint64_t card_setcode, const char* field_name);
 
+// 将字段名解析为所有名称包含该字符串的字段代码（低12位，已去重）
+// 每次搜索只需解析一次，之后用 match_setcode_with_codes 逐卡做整数比较
+// 返回值：guint16 数组，需要调用者使用 g_array_unref 释放；未找到时为空数组
+GArray* resolve_setcodes_for_field(const char* field_name);
+
+// 检查卡片的setcode是否包含 codes 中任意一个字段代码
+gboolean match_setcode_with_codes(uint64_t card_setcode, const GArray* codes);
+
+// 清空 strings.conf 字段名缓存（离线数据更新/清理后调用）
+void card_info_invalidate_setnames(void);
+
+// 字段名缓存的失效代次（可在任意线程调用），变化后需重新解析已缓存的字段代码
+guint card_info_setnames_generation(void);
+
 #endif // CARD_INFO_H
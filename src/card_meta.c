@@ -0,0 +1,182 @@
+#include "card_meta.h"
+#include "offline_data.h"
+#include "prerelease.h"
+#include <json-glib/json-glib.h>
+
+// 在线查询结果缓存（只在主线程访问）：card id -> CardMeta*
+static GHashTable *online_meta_cache = NULL;
+
+// 一次批量解析
+typedef struct {
+    CardMeta *metas;
+    guint n_metas;
+    guint pending;          // 未完成的在线请求数（发起请求期间额外持有 1）
+    CardMetaResolvedFunc callback;
+    gpointer user_data;
+    gint64 started_at;
+} CardMetaBatch;
+
+typedef struct {
+    CardMetaBatch *batch;
+    int id;
+} CardMetaRequest;
+
+// 同一ID在卡组中可能出现多次，全部填上
+static void card_meta_batch_fill(CardMetaBatch *batch, int id, guint32 type, gint32 level) {
+    for (guint i = 0; i < batch->n_metas; i++) {
+        CardMeta *meta = &batch->metas[i];
+        if (meta->id == id && !meta->resolved) {
+            meta->type = type;
+            meta->level = level;
+            meta->resolved = TRUE;
+        }
+    }
+}
+
+static void card_meta_batch_release(CardMetaBatch *batch) {
+    if (--batch->pending > 0) {
+        return;
+    }
+
+    guint unresolved = 0;
+    for (guint i = 0; i < batch->n_metas; i++) {
+        if (!batch->metas[i].resolved) unresolved++;
+    }
+    g_message("Card metadata resolved: %u cards, %u unresolved, %.1f ms",
+              batch->n_metas, unresolved,
+              (g_get_monotonic_time() - batch->started_at) / 1000.0);
+
+    batch->callback(batch->metas, batch->n_metas, batch->user_data);
+    g_free(batch->metas);
+    g_free(batch);
+}
+
+static void card_meta_response_cb(GObject *source, GAsyncResult *res, gpointer user_data) {
+    CardMetaRequest *req = (CardMetaRequest *)user_data;
+    GError *err = NULL;
+    GBytes *body = soup_session_send_and_read_finish(SOUP_SESSION(source), res, &err);
+
+    if (!body) {
+        g_warning("Failed to fetch card %d metadata: %s", req->id, err ? err->message : "unknown error");
+        g_clear_error(&err);
+    } else {
+        gsize len = 0;
+        const char *data = g_bytes_get_data(body, &len);
+        JsonParser *parser = json_parser_new();
+        if (len > 0 && json_parser_load_from_data(parser, data, (gssize)len, NULL)) {
+            JsonNode *root = json_parser_get_root(parser);
+            if (root && JSON_NODE_HOLDS_OBJECT(root)) {
+                JsonObject *obj = json_node_get_object(root);
+                // type/level 位于 data 对象中
+                JsonObject *data_obj = json_object_has_member(obj, "data")
+                    ? json_object_get_object_member(obj, "data") : NULL;
+                if (data_obj) {
+                    CardMeta *meta = g_new0(CardMeta, 1);
+                    meta->id = req->id;
+                    if (json_object_has_member(data_obj, "type")) {
+                        meta->type = (guint32)json_object_get_int_member(data_obj, "type");
+                    }
+                    if (json_object_has_member(data_obj, "level")) {
+                        meta->level = (gint32)json_object_get_int_member(data_obj, "level");
+                    }
+                    meta->resolved = TRUE;
+                    card_meta_batch_fill(req->batch, meta->id, meta->type, meta->level);
+
+                    if (!online_meta_cache) {
+                        online_meta_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+                    }
+                    g_hash_table_replace(online_meta_cache, GINT_TO_POINTER(meta->id), meta);
+                }
+            }
+        }
+        g_object_unref(parser);
+        g_bytes_unref(body);
+    }
+
+    card_meta_batch_release(req->batch);
+    g_free(req);
+}
+
+void card_meta_resolve_async(SoupSession *session, const int *card_ids, guint n_ids,
+                             CardMetaResolvedFunc callback, gpointer user_data) {
+    if (!callback) return;
+
+    CardMetaBatch *batch = g_new0(CardMetaBatch, 1);
+    batch->metas = g_new0(CardMeta, MAX(n_ids, 1));
+    batch->n_metas = n_ids;
+    batch->callback = callback;
+    batch->user_data = user_data;
+    batch->started_at = g_get_monotonic_time();
+    // 发起请求期间持有一个计数，避免请求在循环中完成时提前回调
+    batch->pending = 1;
+
+    for (guint i = 0; i < n_ids; i++) {
+        batch->metas[i].id = card_ids ? card_ids[i] : 0;
+    }
+
+    // 1. 离线数据：整批一次加锁，直接读取数值列
+    if (n_ids > 0 && card_ids) {
+        CardNumericFields *fields = g_new0(CardNumericFields, n_ids);
+        gboolean *found = g_new0(gboolean, n_ids);
+        if (get_card_numeric_fields_offline(card_ids, n_ids, fields, found)) {
+            for (guint i = 0; i < n_ids; i++) {
+                if (found[i]) {
+                    batch->metas[i].type = fields[i].type;
+                    batch->metas[i].level = fields[i].level;
+                    batch->metas[i].resolved = TRUE;
+                }
+            }
+        }
+        g_free(fields);
+        g_free(found);
+    }
+
+    // 2. 先行卡索引和在线结果缓存
+    for (guint i = 0; i < n_ids; i++) {
+        CardMeta *meta = &batch->metas[i];
+        if (meta->resolved || meta->id <= 0) continue;
+
+        JsonObject *prerelease_card = find_prerelease_card_by_id(meta->id);
+        if (prerelease_card) {
+            guint32 type = json_object_has_member(prerelease_card, "type")
+                ? (guint32)json_object_get_int_member(prerelease_card, "type") : 0;
+            gint32 level = json_object_has_member(prerelease_card, "level")
+                ? (gint32)json_object_get_int_member(prerelease_card, "level") : 0;
+            card_meta_batch_fill(batch, meta->id, type, level);
+            json_object_unref(prerelease_card);
+            continue;
+        }
+
+        CardMeta *cached = online_meta_cache
+            ? g_hash_table_lookup(online_meta_cache, GINT_TO_POINTER(meta->id)) : NULL;
+        if (cached) {
+            card_meta_batch_fill(batch, meta->id, cached->type, cached->level);
+        }
+    }
+
+    // 3. 其余ID去重后并发请求在线API
+    if (session) {
+        GHashTable *requested = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (guint i = 0; i < n_ids; i++) {
+            CardMeta *meta = &batch->metas[i];
+            if (meta->resolved || meta->id <= 0) continue;
+            if (g_hash_table_contains(requested, GINT_TO_POINTER(meta->id))) continue;
+            g_hash_table_add(requested, GINT_TO_POINTER(meta->id));
+
+            char url[256];
+            g_snprintf(url, sizeof url, "https://ygocdb.com/api/v0/card/%d", meta->id);
+            SoupMessage *msg = soup_message_new("GET", url);
+            if (!msg) continue;
+
+            CardMetaRequest *req = g_new0(CardMetaRequest, 1);
+            req->batch = batch;
+            req->id = meta->id;
+            batch->pending++;
+            soup_session_send_and_read_async(session, msg, G_PRIORITY_DEFAULT, NULL, card_meta_response_cb, req);
+            g_object_unref(msg);
+        }
+        g_hash_table_destroy(requested);
+    }
+
+    card_meta_batch_release(batch);
+}
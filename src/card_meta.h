@@ -0,0 +1,36 @@
+#ifndef CARD_META_H
+#define CARD_META_H
+
+#include <glib.h>
+#include <libsoup/soup.h>
+
+// 卡片元数据（排序所需的类型与等级）批量解析：依次查询离线数据、先行卡索引和在线结果缓存，
+// 剩余的ID去重后通过共享的 SoupSession 并发请求 ygocdb.com，全部到齐后一次性回调。
+
+typedef struct {
+    int id;
+    guint32 type;
+    gint32 level;
+    gboolean resolved;   // FALSE 表示所有来源都没有该卡（type/level 为 0）
+} CardMeta;
+
+/**
+ * 批量解析完成回调（在主线程调用）
+ * @param metas 与请求的ID一一对应的元数据数组，回调返回后释放
+ * @param n_metas 数组长度
+ */
+typedef void (*CardMetaResolvedFunc)(const CardMeta *metas, guint n_metas, gpointer user_data);
+
+/**
+ * 批量解析卡片元数据（在主线程调用）
+ * 全部ID都能在本地解析时在返回前直接调用回调；否则并发请求其余ID，全部完成后调用回调
+ * @param session 共享的 libsoup 会话；为 NULL 时不请求在线数据
+ * @param card_ids 卡片ID数组
+ * @param n_ids 数组长度
+ * @param callback 完成回调
+ * @param user_data 传给回调的数据
+ */
+void card_meta_resolve_async(SoupSession *session, const int *card_ids, guint n_ids,
+                             CardMetaResolvedFunc callback, gpointer user_data);
+
+#endif // CARD_META_H
@@ -1,8 +1,6 @@
 #include "card_sort.h"
+#include "card_meta.h"
 #include "deck_slot.h"
-#include "prerelease.h"
-#include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
 
 // 卡片排序数据结构
 typedef struct {
@@ -134,109 +132,30 @@ static gint compare_extra_cards(gconstpointer a, gconstpointer b) {
     return card_a->img_id - card_b->img_id;
 }
 
-// 从API或先行卡数据获取卡片信息（同步方式，简化处理）
-static CardSortData* fetch_card_data_sync(int img_id, GdkPixbuf *pixbuf, gboolean is_extra) {
-    CardSortData *data = g_new0(CardSortData, 1);
-    data->img_id = img_id;
-    data->card_id = img_id;
-    data->is_extra = is_extra;
-    data->pixbuf = pixbuf ? g_object_ref(pixbuf) : NULL;
-    data->level = 0;
-    data->type = 0;
-    
-    // 首先尝试从先行卡中查找
-    JsonObject *prerelease_card = find_prerelease_card_by_id(img_id);
-    if (prerelease_card) {
-        // 获取type
-        if (json_object_has_member(prerelease_card, "type")) {
-            data->type = (uint32_t)json_object_get_int_member(prerelease_card, "type");
-        }
-        // 获取level
-        if (json_object_has_member(prerelease_card, "level")) {
-            data->level = json_object_get_int_member(prerelease_card, "level");
-        }
-        json_object_unref(prerelease_card);
-        return data;
-    }
-    
-    // 如果不是先行卡，则从在线API获取（这里使用同步方式）
-    // 注意：在实际应用中，这可能会阻塞UI，但为了简化实现，暂时使用同步方式
-    char url[256];
-    g_snprintf(url, sizeof url, "https://ygocdb.com/api/v0/card/%d", img_id);
-    
-    SoupSession *session = soup_session_new();
-    SoupMessage *msg = soup_message_new("GET", url);
-    if (msg) {
-        GInputStream *in = soup_session_send(session, msg, NULL, NULL);
-        if (in) {
-            GByteArray *ba = g_byte_array_new();
-            guint8 bufread[4096];
-            gssize n;
-            while ((n = g_input_stream_read(in, bufread, sizeof bufread, NULL, NULL)) > 0) {
-                g_byte_array_append(ba, bufread, (guint)n);
-            }
-            
-            if (ba->len > 0) {
-                JsonParser *parser = json_parser_new();
-                if (json_parser_load_from_data(parser, (const char*)ba->data, (gssize)ba->len, NULL)) {
-                    JsonNode *root = json_parser_get_root(parser);
-                    if (root && JSON_NODE_HOLDS_OBJECT(root)) {
-                        JsonObject *obj = json_node_get_object(root);
-                        
-                        // 获取type - 从data对象中读取
-                        if (json_object_has_member(obj, "data")) {
-                            JsonObject *data_obj = json_object_get_object_member(obj, "data");
-                            if (data_obj) {
-                                if (json_object_has_member(data_obj, "type")) {
-                                    data->type = (uint32_t)json_object_get_int_member(data_obj, "type");
-                                }
-                                if (json_object_has_member(data_obj, "level")) {
-                                    data->level = json_object_get_int_member(data_obj, "level");
-                                }
-                            }
-                        }
-                    }
-                }
-                g_object_unref(parser);
-            }
-            
-            g_byte_array_free(ba, TRUE);
-            g_object_unref(in);
-        }
-        g_object_unref(msg);
-    }
-    g_object_unref(session);
-    
-    return data;
-}
-
-// 对指定区域的卡片进行排序
-void sort_deck_region(GPtrArray *pics, int *count, GtkLabel *count_label) {
-    if (!pics || !count || *count <= 0) return;
-    
-    // 收集所有非空槽位的卡片数据
+// 收集区域内所有非空槽位的卡片（type/level 由元数据填充）
+static GPtrArray* collect_region_cards(GPtrArray *pics, int count) {
     GPtrArray *cards = g_ptr_array_new_with_free_func((GDestroyNotify)free_card_sort_data);
     
-    for (int i = 0; i < *count && i < (int)pics->len; i++) {
+    for (int i = 0; i < count && i < (int)pics->len; i++) {
         GtkWidget *pic = GTK_WIDGET(g_ptr_array_index(pics, i));
         int img_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "img_id"));
         
         if (img_id > 0) {
             GdkPixbuf *pixbuf = slot_get_pixbuf(pic);
-            gboolean is_extra = slot_get_is_extra(pic);
-            
-            // 获取卡片完整信息
-            CardSortData *card_data = fetch_card_data_sync(img_id, pixbuf, is_extra);
-            if (card_data) {
-                card_data->card_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "card_id"));
-                g_ptr_array_add(cards, card_data);
-            }
+            CardSortData *card_data = g_new0(CardSortData, 1);
+            card_data->img_id = img_id;
+            card_data->card_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "card_id"));
+            card_data->is_extra = slot_get_is_extra(pic);
+            card_data->pixbuf = pixbuf ? g_object_ref(pixbuf) : NULL;
+            g_ptr_array_add(cards, card_data);
         }
     }
     
-    // 排序
-    g_ptr_array_sort(cards, compare_cards);
-    
+    return cards;
+}
+
+// 按排序后的顺序写回槽位
+static void apply_sorted_cards(GPtrArray *pics, int *count, GtkLabel *count_label, GPtrArray *cards) {
     // 清空原槽位
     for (int i = 0; i < (int)pics->len; i++) {
         GtkWidget *pic = GTK_WIDGET(g_ptr_array_index(pics, i));
@@ -261,61 +180,76 @@ void sort_deck_region(GPtrArray *pics, int *count, GtkLabel *count_label) {
     
     *count = cards->len;
     update_count_label(count_label, *count);
-    
-    g_ptr_array_free(cards, TRUE);
 }
 
-// 对Extra区域的卡片进行排序（使用Extra专用排序规则）
-void sort_extra_region(GPtrArray *pics, int *count, GtkLabel *count_label) {
-    if (!pics || !count || *count <= 0) return;
-    
-    // 收集所有非空槽位的卡片数据
-    GPtrArray *cards = g_ptr_array_new_with_free_func((GDestroyNotify)free_card_sort_data);
-    
-    for (int i = 0; i < *count && i < (int)pics->len; i++) {
-        GtkWidget *pic = GTK_WIDGET(g_ptr_array_index(pics, i));
-        int img_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "img_id"));
-        
-        if (img_id > 0) {
-            GdkPixbuf *pixbuf = slot_get_pixbuf(pic);
-            gboolean is_extra = slot_get_is_extra(pic);
-            
-            // 获取卡片完整信息
-            CardSortData *card_data = fetch_card_data_sync(img_id, pixbuf, is_extra);
-            if (card_data) {
-                card_data->card_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "card_id"));
-                g_ptr_array_add(cards, card_data);
-            }
+// 一次整理请求：等待元数据期间持有槽位数组和计数标签
+typedef struct {
+    GPtrArray *pics;
+    int *count;
+    GtkLabel *count_label;
+    GCompareFunc compare;
+} SortRequest;
+
+// 元数据到齐后排序（主线程）
+static void on_sort_metadata_ready(const CardMeta *metas, guint n_metas, gpointer user_data) {
+    SortRequest *req = (SortRequest*)user_data;
+    
+    // 重新读取槽位（等待期间可能加载完了卡图），并确认卡组没有被修改
+    GPtrArray *cards = collect_region_cards(req->pics, *req->count);
+    gboolean unchanged = (cards->len == n_metas);
+    for (guint i = 0; unchanged && i < cards->len; i++) {
+        CardSortData *card = g_ptr_array_index(cards, i);
+        if (card->img_id != metas[i].id) {
+            unchanged = FALSE;
+        } else {
+            card->type = metas[i].type;
+            card->level = metas[i].level;
         }
     }
     
-    // 使用Extra专用排序函数排序
-    g_ptr_array_sort(cards, compare_extra_cards);
-    
-    // 清空原槽位
-    for (int i = 0; i < (int)pics->len; i++) {
-        GtkWidget *pic = GTK_WIDGET(g_ptr_array_index(pics, i));
-        slot_set_pixbuf(pic, NULL);
-        slot_set_is_extra(pic, FALSE);
-        g_object_set_data(G_OBJECT(pic), "card_id", GINT_TO_POINTER(0));
-        g_object_set_data(G_OBJECT(pic), "img_id", GINT_TO_POINTER(0));
+    if (unchanged) {
+        g_ptr_array_sort(cards, req->compare);
+        apply_sorted_cards(req->pics, req->count, req->count_label, cards);
+    } else {
+        // 等待期间增删或拖动了卡片，放弃这次整理，避免覆盖用户的改动
+        g_message("Deck changed while resolving card metadata, sort skipped");
     }
     
-    // 按排序后的顺序重新放置卡片
-    for (guint i = 0; i < cards->len && i < pics->len; i++) {
+    g_ptr_array_free(cards, TRUE);
+    g_ptr_array_unref(req->pics);
+    if (req->count_label) g_object_unref(req->count_label);
+    g_free(req);
+}
+
+// 收集区域内的卡片ID，批量解析元数据后按 compare 排序
+static void sort_region(GPtrArray *pics, int *count, GtkLabel *count_label,
+                        SoupSession *session, GCompareFunc compare) {
+    if (!pics || !count || *count <= 0) return;
+    
+    GPtrArray *cards = collect_region_cards(pics, *count);
+    GArray *ids = g_array_sized_new(FALSE, FALSE, sizeof(int), cards->len);
+    for (guint i = 0; i < cards->len; i++) {
         CardSortData *card = g_ptr_array_index(cards, i);
-        GtkWidget *pic = GTK_WIDGET(g_ptr_array_index(pics, i));
-        
-        if (card->pixbuf) {
-            slot_set_pixbuf(pic, card->pixbuf);
-        }
-        slot_set_is_extra(pic, card->is_extra);
-        g_object_set_data(G_OBJECT(pic), "card_id", GINT_TO_POINTER(card->card_id));
-        g_object_set_data(G_OBJECT(pic), "img_id", GINT_TO_POINTER(card->img_id));
+        g_array_append_val(ids, card->img_id);
     }
+    g_ptr_array_free(cards, TRUE);
     
-    *count = cards->len;
-    update_count_label(count_label, *count);
+    SortRequest *req = g_new0(SortRequest, 1);
+    req->pics = g_ptr_array_ref(pics);
+    req->count = count;
+    req->count_label = count_label ? g_object_ref(count_label) : NULL;
+    req->compare = compare;
     
-    g_ptr_array_free(cards, TRUE);
+    card_meta_resolve_async(session, (const int*)ids->data, ids->len, on_sort_metadata_ready, req);
+    g_array_free(ids, TRUE);
+}
+
+// 对指定区域的卡片进行排序
+void sort_deck_region(GPtrArray *pics, int *count, GtkLabel *count_label, SoupSession *session) {
+    sort_region(pics, count, count_label, session, compare_cards);
+}
+
+// 对Extra区域的卡片进行排序（使用Extra专用排序规则）
+void sort_extra_region(GPtrArray *pics, int *count, GtkLabel *count_label, SoupSession *session) {
+    sort_region(pics, count, count_label, session, compare_extra_cards);
 }
@@ -3,25 +3,31 @@
 
 #include <gtk/gtk.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <libsoup/soup.h>
 
 /**
  * 对指定区域的卡片按类型和等级排序
  * 排序规则：怪兽-魔法-陷阱，怪兽按等级降序，魔法陷阱按子类型排序
+ * 卡片类型和等级批量解析（离线数据、先行卡、在线API），全部到齐后才排序；
+ * 全部能在本地解析时在返回前完成，等待期间卡组被修改则放弃这次排序
  * 
  * @param pics 槽位数组
  * @param count 当前卡片数量指针
  * @param count_label 显示计数的标签
+ * @param session 共享的 libsoup 会话，用于查询本地没有的卡片
  */
-void sort_deck_region(GPtrArray *pics, int *count, GtkLabel *count_label);
+void sort_deck_region(GPtrArray *pics, int *count, GtkLabel *count_label, SoupSession *session);
 
 /**
  * 对Extra区域的卡片排序
  * 排序规则：融合-同调-超量-连接，同类按等级降序
+ * 元数据的解析方式同 sort_deck_region
  * 
  * @param pics 槽位数组
  * @param count 当前卡片数量指针
  * @param count_label 显示计数的标签
+ * @param session 共享的 libsoup 会话，用于查询本地没有的卡片
  */
-void sort_extra_region(GPtrArray *pics, int *count, GtkLabel *count_label);
+void sort_extra_region(GPtrArray *pics, int *count, GtkLabel *count_label, SoupSession *session);
 
 #endif // CARD_SORT_H
@@ -0,0 +1,424 @@
+#include "card_store.h"
+#include <string.h>
+#include <glib/gstdio.h>
+
+// cards.bin 文件格式（本机字节序，所有列按 8 字节对齐）：
+//   [CardStoreHeader，填充到 64 字节]
+//   [9 个 gint32 数值列，每列 count 个元素]
+//   [setcode 列，gint64 × count]
+//   [CARD_STORE_STR_COUNT 个字符串偏移列，guint32 × count，不存在为 CARD_STORE_NO_STRING]
+//   [字符串区，'\0' 结尾的 UTF-8 字符串]
+#define CARD_STORE_MAGIC "YGOCSTOR"
+#define CARD_STORE_VERSION 1
+#define CARD_STORE_BYTE_ORDER 0x01020304u
+#define CARD_STORE_HEADER_SIZE 64
+#define CARD_STORE_NO_STRING G_MAXUINT32
+
+typedef enum {
+    COL_ID = 0,
+    COL_CID,
+    COL_OT,
+    COL_TYPE,
+    COL_ATK,
+    COL_DEF,
+    COL_LEVEL,
+    COL_RACE,
+    COL_ATTRIBUTE,
+    COL_INT_COUNT
+} CardStoreIntColumn;
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 card_count;
+    guint32 string_field_count;
+    gint64 source_mtime;
+    gint64 source_size;
+    guint64 arena_offset;
+    guint64 arena_size;
+} CardStoreHeader;
+
+G_STATIC_ASSERT(sizeof(CardStoreHeader) <= CARD_STORE_HEADER_SIZE);
+
+typedef struct {
+    guint64 int_col[COL_INT_COUNT];
+    guint64 setcode_col;
+    guint64 str_col[CARD_STORE_STR_COUNT];
+    guint64 arena;
+} CardStoreLayout;
+
+struct CardStore {
+    gint ref_count;
+    GMappedFile *mapped;
+    guint count;
+    const gint32 *int_cols[COL_INT_COUNT];
+    const gint64 *setcode;
+    const guint32 *str_cols[CARD_STORE_STR_COUNT];
+    const char *arena;
+    guint64 arena_size;
+    GHashTable *id_index; // id -> 下标 + 1
+};
+
+// 与 CardStoreStringField 一一对应的 JSON 字段名
+static const char *string_field_keys[CARD_STORE_STR_COUNT] = {
+    "cn_name", "sc_name", "md_name", "jp_name", "en_name", "nwbbs_n", "cnocg_n",
+    "types", "pdesc", "desc"
+};
+
+// 与 CardStoreIntColumn 中 data{} 部分对应的 JSON 字段名（id/cid 在顶层）
+static const char *data_field_keys[COL_INT_COUNT] = {
+    NULL, NULL, "ot", "type", "atk", "def", "level", "race", "attribute"
+};
+
+static guint64 align8(guint64 v) {
+    return (v + 7) & ~(guint64)7;
+}
+
+static void layout_compute(guint count, CardStoreLayout *layout) {
+    guint64 off = CARD_STORE_HEADER_SIZE;
+    for (int i = 0; i < COL_INT_COUNT; i++) {
+        layout->int_col[i] = off;
+        off = align8(off + (guint64)count * sizeof(gint32));
+    }
+    layout->setcode_col = off;
+    off += (guint64)count * sizeof(gint64);
+    for (int i = 0; i < CARD_STORE_STR_COUNT; i++) {
+        layout->str_col[i] = off;
+        off = align8(off + (guint64)count * sizeof(guint32));
+    }
+    layout->arena = off;
+}
+
+static gboolean stat_source(const char *path, gint64 *mtime, gint64 *size) {
+    GStatBuf st;
+    if (!path || g_stat(path, &st) != 0) return FALSE;
+    *mtime = (gint64)st.st_mtime;
+    *size = (gint64)st.st_size;
+    return TRUE;
+}
+
+static gint64 json_get_int(JsonObject *obj, const char *name) {
+    if (!obj || !name) return 0;
+    JsonNode *node = json_object_get_member(obj, name);
+    if (!node || !JSON_NODE_HOLDS_VALUE(node)) return 0;
+    return json_node_get_int(node);
+}
+
+static const char *json_get_string(JsonObject *obj, const char *name) {
+    if (!obj || !name) return NULL;
+    JsonNode *node = json_object_get_member(obj, name);
+    if (!node || !JSON_NODE_HOLDS_VALUE(node)) return NULL;
+    if (json_node_get_value_type(node) != G_TYPE_STRING) return NULL;
+    return json_node_get_string(node);
+}
+
+static guint32 arena_append(GByteArray *arena, const char *s) {
+    if (!s) return CARD_STORE_NO_STRING;
+    guint32 off = arena->len;
+    g_byte_array_append(arena, (const guint8 *)s, (guint)strlen(s) + 1);
+    return off;
+}
+
+gboolean card_store_compile(const char *json_path, const char *bin_path) {
+    if (!json_path || !bin_path) return FALSE;
+
+    gint64 src_mtime = 0, src_size = 0;
+    if (!stat_source(json_path, &src_mtime, &src_size)) {
+        g_warning("Card store: cards.json not found: %s", json_path);
+        return FALSE;
+    }
+
+    gint64 start_us = g_get_monotonic_time();
+
+    JsonParser *parser = json_parser_new();
+    GError *error = NULL;
+    if (!json_parser_load_from_file(parser, json_path, &error)) {
+        g_warning("Card store: failed to parse cards.json: %s", error ? error->message : "unknown error");
+        if (error) g_error_free(error);
+        g_object_unref(parser);
+        return FALSE;
+    }
+
+    JsonNode *root = json_parser_get_root(parser);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
+        g_warning("Card store: invalid JSON structure in cards.json");
+        g_object_unref(parser);
+        return FALSE;
+    }
+    JsonObject *root_obj = json_node_get_object(root);
+    guint capacity = json_object_get_size(root_obj);
+
+    GArray *int_cols[COL_INT_COUNT];
+    for (int i = 0; i < COL_INT_COUNT; i++) {
+        int_cols[i] = g_array_sized_new(FALSE, FALSE, sizeof(gint32), capacity);
+    }
+    GArray *setcodes = g_array_sized_new(FALSE, FALSE, sizeof(gint64), capacity);
+    GArray *str_cols[CARD_STORE_STR_COUNT];
+    for (int i = 0; i < CARD_STORE_STR_COUNT; i++) {
+        str_cols[i] = g_array_sized_new(FALSE, FALSE, sizeof(guint32), capacity);
+    }
+    GByteArray *arena = g_byte_array_sized_new(capacity * 512);
+
+    JsonObjectIter iter;
+    json_object_iter_init(&iter, root_obj);
+    const gchar *member_name = NULL;
+    JsonNode *card_node = NULL;
+    while (json_object_iter_next(&iter, &member_name, &card_node)) {
+        if (!card_node || !JSON_NODE_HOLDS_OBJECT(card_node)) continue;
+        JsonObject *card = json_node_get_object(card_node);
+        if (!card) continue;
+
+        JsonObject *data = NULL;
+        JsonNode *data_node = json_object_get_member(card, "data");
+        if (data_node && JSON_NODE_HOLDS_OBJECT(data_node)) data = json_node_get_object(data_node);
+        JsonObject *text = NULL;
+        JsonNode *text_node = json_object_get_member(card, "text");
+        if (text_node && JSON_NODE_HOLDS_OBJECT(text_node)) text = json_node_get_object(text_node);
+
+        gint32 id = (gint32)json_get_int(card, "id");
+        if (id <= 0 && member_name) id = (gint32)g_ascii_strtoll(member_name, NULL, 10);
+
+        gint32 values[COL_INT_COUNT];
+        values[COL_ID] = id;
+        values[COL_CID] = (gint32)json_get_int(card, "cid");
+        for (int i = COL_OT; i < COL_INT_COUNT; i++) {
+            values[i] = (gint32)json_get_int(data, data_field_keys[i]);
+        }
+        for (int i = 0; i < COL_INT_COUNT; i++) {
+            g_array_append_val(int_cols[i], values[i]);
+        }
+
+        gint64 setcode = json_get_int(data, "setcode");
+        g_array_append_val(setcodes, setcode);
+
+        for (int i = 0; i < CARD_STORE_STR_COUNT; i++) {
+            JsonObject *owner = (i < CARD_STORE_NAME_FIELD_COUNT) ? card : text;
+            guint32 off = arena_append(arena, json_get_string(owner, string_field_keys[i]));
+            g_array_append_val(str_cols[i], off);
+        }
+    }
+    g_object_unref(parser);
+
+    guint count = setcodes->len;
+    CardStoreLayout layout;
+    layout_compute(count, &layout);
+    gsize total = (gsize)(layout.arena + arena->len);
+
+    guint8 *buf = g_malloc0(total);
+    CardStoreHeader *header = (CardStoreHeader *)buf;
+    memcpy(header->magic, CARD_STORE_MAGIC, sizeof(header->magic));
+    header->version = CARD_STORE_VERSION;
+    header->byte_order = CARD_STORE_BYTE_ORDER;
+    header->card_count = count;
+    header->string_field_count = CARD_STORE_STR_COUNT;
+    header->source_mtime = src_mtime;
+    header->source_size = src_size;
+    header->arena_offset = layout.arena;
+    header->arena_size = arena->len;
+
+    for (int i = 0; i < COL_INT_COUNT; i++) {
+        if (count > 0) memcpy(buf + layout.int_col[i], int_cols[i]->data, (gsize)count * sizeof(gint32));
+        g_array_free(int_cols[i], TRUE);
+    }
+    if (count > 0) memcpy(buf + layout.setcode_col, setcodes->data, (gsize)count * sizeof(gint64));
+    g_array_free(setcodes, TRUE);
+    for (int i = 0; i < CARD_STORE_STR_COUNT; i++) {
+        if (count > 0) memcpy(buf + layout.str_col[i], str_cols[i]->data, (gsize)count * sizeof(guint32));
+        g_array_free(str_cols[i], TRUE);
+    }
+    if (arena->len > 0) memcpy(buf + layout.arena, arena->data, arena->len);
+    g_byte_array_free(arena, TRUE);
+
+    gboolean ok = g_file_set_contents(bin_path, (const gchar *)buf, (gssize)total, &error);
+    if (!ok) {
+        g_warning("Card store: failed to write %s: %s", bin_path, error ? error->message : "unknown error");
+        if (error) g_error_free(error);
+    } else {
+        g_message("Card store compiled: %u cards, %" G_GSIZE_FORMAT " bytes in %.1f ms",
+                  count, total, (g_get_monotonic_time() - start_us) / 1000.0);
+    }
+    g_free(buf);
+    return ok;
+}
+
+CardStore* card_store_open(const char *bin_path, const char *json_path) {
+    if (!bin_path || !g_file_test(bin_path, G_FILE_TEST_EXISTS)) return NULL;
+
+    GError *error = NULL;
+    GMappedFile *mapped = g_mapped_file_new(bin_path, FALSE, &error);
+    if (!mapped) {
+        g_warning("Card store: failed to map %s: %s", bin_path, error ? error->message : "unknown error");
+        if (error) g_error_free(error);
+        return NULL;
+    }
+
+    const char *base = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    if (!base || length < CARD_STORE_HEADER_SIZE) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    CardStoreHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, CARD_STORE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CARD_STORE_VERSION ||
+        header.byte_order != CARD_STORE_BYTE_ORDER ||
+        header.string_field_count != CARD_STORE_STR_COUNT) {
+        g_message("Card store: %s has an incompatible format, will rebuild", bin_path);
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    // 校验是否与当前 cards.json 对应（更新离线数据后会失配）
+    if (json_path) {
+        gint64 src_mtime = 0, src_size = 0;
+        if (!stat_source(json_path, &src_mtime, &src_size) ||
+            src_mtime != header.source_mtime || src_size != header.source_size) {
+            g_mapped_file_unref(mapped);
+            return NULL;
+        }
+    }
+
+    CardStoreLayout layout;
+    layout_compute(header.card_count, &layout);
+    if (header.arena_offset != layout.arena ||
+        layout.arena + header.arena_size > length ||
+        (header.arena_size > 0 && base[layout.arena + header.arena_size - 1] != '\0')) {
+        g_warning("Card store: %s is truncated or corrupted", bin_path);
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    CardStore *store = g_new0(CardStore, 1);
+    store->ref_count = 1;
+    store->mapped = mapped;
+    store->count = header.card_count;
+    for (int i = 0; i < COL_INT_COUNT; i++) {
+        store->int_cols[i] = (const gint32 *)(base + layout.int_col[i]);
+    }
+    store->setcode = (const gint64 *)(base + layout.setcode_col);
+    for (int i = 0; i < CARD_STORE_STR_COUNT; i++) {
+        store->str_cols[i] = (const guint32 *)(base + layout.str_col[i]);
+    }
+    store->arena = base + layout.arena;
+    store->arena_size = header.arena_size;
+
+    // 与存储同生共死的 id 索引：存储被替换/释放时索引随之失效
+    store->id_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    const gint32 *ids = store->int_cols[COL_ID];
+    for (guint i = 0; i < store->count; i++) {
+        g_hash_table_insert(store->id_index, GINT_TO_POINTER(ids[i]), GUINT_TO_POINTER(i + 1));
+    }
+    return store;
+}
+
+CardStore* card_store_ref(CardStore *store) {
+    if (store) g_atomic_int_inc(&store->ref_count);
+    return store;
+}
+
+void card_store_unref(CardStore *store) {
+    if (!store) return;
+    if (g_atomic_int_dec_and_test(&store->ref_count)) {
+        g_hash_table_destroy(store->id_index);
+        g_mapped_file_unref(store->mapped);
+        g_free(store);
+    }
+}
+
+guint card_store_get_count(const CardStore *store) {
+    return store ? store->count : 0;
+}
+
+gint card_store_find_by_id(const CardStore *store, gint32 card_id) {
+    if (!store || !store->id_index) return -1;
+    guint slot = GPOINTER_TO_UINT(g_hash_table_lookup(store->id_index, GINT_TO_POINTER(card_id)));
+    return slot > 0 ? (gint)(slot - 1) : -1;
+}
+
+gint32 card_store_get_id(const CardStore *store, guint index) {
+    return store->int_cols[COL_ID][index];
+}
+
+gint32 card_store_get_cid(const CardStore *store, guint index) {
+    return store->int_cols[COL_CID][index];
+}
+
+gint32 card_store_get_ot(const CardStore *store, guint index) {
+    return store->int_cols[COL_OT][index];
+}
+
+guint32 card_store_get_type(const CardStore *store, guint index) {
+    return (guint32)store->int_cols[COL_TYPE][index];
+}
+
+gint32 card_store_get_atk(const CardStore *store, guint index) {
+    return store->int_cols[COL_ATK][index];
+}
+
+gint32 card_store_get_def(const CardStore *store, guint index) {
+    return store->int_cols[COL_DEF][index];
+}
+
+gint32 card_store_get_level(const CardStore *store, guint index) {
+    return store->int_cols[COL_LEVEL][index];
+}
+
+gint32 card_store_get_race(const CardStore *store, guint index) {
+    return store->int_cols[COL_RACE][index];
+}
+
+gint32 card_store_get_attribute(const CardStore *store, guint index) {
+    return store->int_cols[COL_ATTRIBUTE][index];
+}
+
+gint64 card_store_get_setcode(const CardStore *store, guint index) {
+    return store->setcode[index];
+}
+
+void card_store_get_numeric_fields(const CardStore *store, guint index, CardNumericFields *out) {
+    out->type = (guint32)store->int_cols[COL_TYPE][index];
+    out->atk = store->int_cols[COL_ATK][index];
+    out->def = store->int_cols[COL_DEF][index];
+    out->level = store->int_cols[COL_LEVEL][index];
+    out->race = store->int_cols[COL_RACE][index];
+    out->attribute = store->int_cols[COL_ATTRIBUTE][index];
+    out->setcode = store->setcode[index];
+}
+
+const char* card_store_get_string(const CardStore *store, guint index, CardStoreStringField field) {
+    if (!store || index >= store->count || (guint)field >= CARD_STORE_STR_COUNT) return NULL;
+    guint32 off = store->str_cols[field][index];
+    if (off == CARD_STORE_NO_STRING || off >= store->arena_size) return NULL;
+    return store->arena + off;
+}
+
+JsonObject* card_store_build_json(const CardStore *store, guint index) {
+    if (!store || index >= store->count) return NULL;
+
+    JsonObject *card = json_object_new();
+    json_object_set_int_member(card, "id", card_store_get_id(store, index));
+    json_object_set_int_member(card, "cid", card_store_get_cid(store, index));
+    for (int i = 0; i < CARD_STORE_NAME_FIELD_COUNT; i++) {
+        const char *s = card_store_get_string(store, index, (CardStoreStringField)i);
+        if (s) json_object_set_string_member(card, string_field_keys[i], s);
+    }
+
+    JsonObject *data = json_object_new();
+    for (int i = COL_OT; i < COL_INT_COUNT; i++) {
+        json_object_set_int_member(data, data_field_keys[i], store->int_cols[i][index]);
+    }
+    json_object_set_int_member(data, "setcode", card_store_get_setcode(store, index));
+    json_object_set_object_member(card, "data", data);
+
+    JsonObject *text = json_object_new();
+    for (int i = CARD_STORE_NAME_FIELD_COUNT; i < CARD_STORE_STR_COUNT; i++) {
+        const char *s = card_store_get_string(store, index, (CardStoreStringField)i);
+        if (s) json_object_set_string_member(text, string_field_keys[i], s);
+    }
+    json_object_set_object_member(card, "text", text);
+
+    return card;
+}
@@ -0,0 +1,105 @@
+#ifndef CARD_STORE_H
+#define CARD_STORE_H
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+// 离线卡片二进制存储（cards.bin）：由 cards.json 编译而来，按列存放定长数值字段，
+// 字符串统一放入一个以 '\0' 结尾的字符串区（arena），通过偏移量引用。
+// 文件以 GMappedFile 只读映射，打开时无需解析任何 JSON。
+
+#define CARD_STORE_FILENAME "cards.bin"
+
+// 字符串字段（顺序即文件中的列顺序，修改需同步提升版本号）
+typedef enum {
+    CARD_STORE_STR_CN_NAME = 0,
+    CARD_STORE_STR_SC_NAME,
+    CARD_STORE_STR_MD_NAME,
+    CARD_STORE_STR_JP_NAME,
+    CARD_STORE_STR_EN_NAME,
+    CARD_STORE_STR_NWBBS_N,
+    CARD_STORE_STR_CNOCG_N,
+    CARD_STORE_STR_TYPES,
+    CARD_STORE_STR_PDESC,
+    CARD_STORE_STR_DESC,
+    CARD_STORE_STR_COUNT
+} CardStoreStringField;
+
+// 前 7 个字符串字段为卡名字段
+#define CARD_STORE_NAME_FIELD_COUNT 7
+
+typedef struct CardStore CardStore;
+
+// 筛选用到的数值字段（与 cards.json 中 data{} 对应）
+typedef struct {
+    guint32 type;
+    gint32 atk;
+    gint32 def;
+    gint32 level;
+    gint32 race;
+    gint32 attribute;
+    gint64 setcode;
+} CardNumericFields;
+
+/**
+ * 将 cards.json 编译为二进制存储文件
+ * 写入采用 g_file_set_contents（临时文件 + 重命名），不会留下半写入的文件
+ * @param json_path cards.json 路径
+ * @param bin_path 输出的 cards.bin 路径
+ * @return TRUE 如果编译成功，否则 FALSE
+ */
+gboolean card_store_compile(const char *json_path, const char *bin_path);
+
+/**
+ * 打开并映射二进制存储文件
+ * 如果文件不存在、版本不符或与 cards.json 的 mtime/大小不一致，返回 NULL
+ * @param bin_path cards.bin 路径
+ * @param json_path 对应的 cards.json 路径（用于校验是否过期）
+ * @return 存储对象（引用计数为 1），调用者需要 card_store_unref 释放；失败返回 NULL
+ */
+CardStore* card_store_open(const char *bin_path, const char *json_path);
+
+CardStore* card_store_ref(CardStore *store);
+void card_store_unref(CardStore *store);
+
+/**
+ * 获取卡片数量
+ */
+guint card_store_get_count(const CardStore *store);
+
+/**
+ * 按卡片ID查找记录下标（打开存储时建立的哈希索引，O(1)）
+ * @return 记录下标；不存在时返回 -1
+ */
+gint card_store_find_by_id(const CardStore *store, gint32 card_id);
+
+// 数值列访问（index 范围 [0, count)）
+gint32 card_store_get_id(const CardStore *store, guint index);
+gint32 card_store_get_cid(const CardStore *store, guint index);
+gint32 card_store_get_ot(const CardStore *store, guint index);
+guint32 card_store_get_type(const CardStore *store, guint index);
+gint32 card_store_get_atk(const CardStore *store, guint index);
+gint32 card_store_get_def(const CardStore *store, guint index);
+gint32 card_store_get_level(const CardStore *store, guint index);
+gint32 card_store_get_race(const CardStore *store, guint index);
+gint32 card_store_get_attribute(const CardStore *store, guint index);
+gint64 card_store_get_setcode(const CardStore *store, guint index);
+
+/**
+ * 一次性读取筛选所需的数值字段
+ */
+void card_store_get_numeric_fields(const CardStore *store, guint index, CardNumericFields *out);
+
+/**
+ * 获取字符串字段
+ * @return 指向映射内存的字符串，不需要释放；字段不存在时返回 NULL
+ */
+const char* card_store_get_string(const CardStore *store, guint index, CardStoreStringField field);
+
+/**
+ * 按 cards.json 的结构（顶层 id/cid/各语言卡名，data{...}，text{...}）构建单张卡片的 JSON 对象
+ * @return 新的 JSON 对象，调用者需要 json_object_unref 释放
+ */
+JsonObject* card_store_build_json(const CardStore *store, guint index);
+
+#endif // CARD_STORE_H
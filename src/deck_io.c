@@ -181,10 +181,9 @@ gboolean import_deck_from_ydk(
             
             if (is_prerelease) {
                 // 先行卡：从本地加载
-                gchar *local_path = get_prerelease_card_image_path(img_id);
-                if (local_path && g_file_test(local_path, G_FILE_TEST_EXISTS)) {
+                if (prerelease_card_has_image(img_id)) {
                     GError *error = NULL;
-                    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(local_path, &error);
+                    GdkPixbuf *pixbuf = load_prerelease_card_image(img_id, &error);
                     if (pixbuf) {
                         slot_set_pixbuf(target_pic, pixbuf);
                         g_object_unref(pixbuf);
@@ -195,7 +194,6 @@ gboolean import_deck_from_ydk(
                         }
                     }
                 }
-                g_free(local_path);
             } else {
                 // 普通卡：从缓存或在线加载（离线模式不影响此逻辑）
                 // 先尝试从缓存加载
@@ -204,7 +202,7 @@ gboolean import_deck_from_ydk(
                 if (cached) {
                     from_mem_cache = TRUE; // 借用引用，不需要 unref
                 } else {
-                    cached = load_from_disk_cache(img_id); // 新引用，需要 unref
+                    cached = load_thumb_from_disk_cache(img_id, gtk_widget_get_scale_factor(GTK_WIDGET(target_pic))); // 新引用，需要 unref
                 }
                 
                 if (cached) {
@@ -225,6 +223,7 @@ gboolean import_deck_from_ydk(
                     ctx->cache_id = img_id;
                     ctx->add_to_thumb_cache = TRUE;
                     ctx->url = g_strdup(url);
+                    ctx->priority = IMAGE_LOAD_PRIORITY_DECK_SLOT;
                     load_image_async(session, url, ctx);
                 }
             }
@@ -2,6 +2,7 @@
 #include "deck_slot.h"
 #include "image_loader.h"
 #include "prerelease.h"
+#include "search_results.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -22,18 +23,8 @@ GdkContentProvider* on_drag_prepare(GtkDragSource *source, double x, double y, g
     // 判断是否为右栏行拖拽
     const char *drag_kind = (const char*)g_object_get_data(G_OBJECT(pic), "drag_kind");
     if (drag_kind && g_strcmp0(drag_kind, "search_row") == 0) {
-        // 对于搜索结果行，检查是否仍在列表中
-        if (!GTK_IS_LIST_BOX_ROW(pic)) return NULL;
-        
-        // 检查是否被标记为无效
-        if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "row_invalid"))) {
-            return NULL;
-        }
-        
-        GtkWidget *parent = gtk_widget_get_parent(pic);
-        if (!parent || !GTK_IS_LIST_BOX(parent)) return NULL;
-        
-        CardPreview *pv = (CardPreview*)g_object_get_data(G_OBJECT(pic), "preview");
+        // 搜索结果行会被回收复用，未绑定卡片时不允许拖拽
+        const CardPreview *pv = search_result_row_get_preview(pic);
         if (!pv || pv->id <= 0) return NULL;
         gboolean is_monster = FALSE, is_extra_type = FALSE;
         if (pv->type > 0) {
@@ -68,26 +59,11 @@ void on_drag_begin(GtkDragSource *source, GdkDrag *drag, gpointer user_data) {
     const char *drag_kind = (const char*)g_object_get_data(G_OBJECT(pic), "drag_kind");
     GdkPixbuf *pb = NULL;
     if (drag_kind && g_strcmp0(drag_kind, "search_row") == 0) {
-        // 对于搜索结果行，检查是否仍在列表中
-        if (!GTK_IS_LIST_BOX_ROW(pic)) return;
-        
-        // 检查是否被标记为无效
-        if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pic), "row_invalid"))) {
-            return;
-        }
-        
-        GtkWidget *parent = gtk_widget_get_parent(pic);
-        if (!parent || !GTK_IS_LIST_BOX(parent)) return;
-        GtkWidget *row_child = gtk_list_box_row_get_child(GTK_LIST_BOX_ROW(pic));
-        if (row_child) {
-            GtkWidget *hbox = row_child;
-            GtkWidget *thumb_stack = gtk_widget_get_first_child(hbox);
-            if (thumb_stack && GTK_IS_STACK(thumb_stack)) {
-                GtkWidget *picture = gtk_stack_get_child_by_name(GTK_STACK(thumb_stack), "picture");
-                if (picture && GTK_IS_DRAWING_AREA(picture)) {
-                    pb = slot_get_pixbuf(picture);
-                }
-            }
+        // 搜索结果行会被回收复用，未绑定卡片时不处理
+        if (!search_result_row_get_preview(pic)) return;
+        GtkWidget *picture = search_result_row_get_picture(pic);
+        if (picture && GTK_IS_DRAWING_AREA(picture)) {
+            pb = slot_get_pixbuf(picture);
         }
     } else {
         pb = slot_get_pixbuf(pic);
@@ -255,10 +231,9 @@ void on_drop(GtkDropTarget *target, const GValue *value, double x, double y, gpo
         
         // 如果是先行卡，从本地加载图片
         if (is_prerelease) {
-            gchar *local_path = get_prerelease_card_image_path(img_id);
-            if (local_path && g_file_test(local_path, G_FILE_TEST_EXISTS)) {
+            if (prerelease_card_has_image(img_id)) {
                 GError *error = NULL;
-                GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(local_path, &error);
+                GdkPixbuf *pixbuf = load_prerelease_card_image(img_id, &error);
                 if (pixbuf) {
                     slot_set_pixbuf(place_w, pixbuf);
                     g_object_unref(pixbuf);
@@ -269,7 +244,6 @@ void on_drop(GtkDropTarget *target, const GValue *value, double x, double y, gpo
                     }
                 }
             }
-            g_free(local_path);
         } else {
             // 非先行卡，从缓存或在线加载
             // 若缓存中有该卡的缩略图，先立即显示以消除延迟
@@ -289,6 +263,7 @@ void on_drop(GtkDropTarget *target, const GValue *value, double x, double y, gpo
             ctx->cache_id = 0;
             ctx->add_to_thumb_cache = FALSE;
             ctx->url = g_strdup(url);
+            ctx->priority = IMAGE_LOAD_PRIORITY_DECK_SLOT;
             load_image_async(ui->session, url, ctx);
         }
         if (*to_count < place_index + 1) *to_count = place_index + 1;
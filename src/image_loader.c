@@ -1,34 +1,140 @@
 #include "image_loader.h"
 #include "app_path.h"
+#include "image_pack.h"
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
 
 // 全局缓存变量
-static GHashTable *thumb_cache = NULL;       // 缩略图缓存
-static GHashTable *fullsize_cache = NULL;    // 全尺寸图片缓存
 static char *cache_dir = NULL;               // 缓存目录路径
+static ImagePack *image_pack = NULL;         // 原图磁盘缓存（cache_dir/images.pack）
+static ImagePack *thumb_pack = NULL;         // 缩略图磁盘缓存（cache_dir/thumbs.pack）
 static GHashTable *pending_downloads = NULL; // 待处理下载
+static GHashTable *in_flight_downloads = NULL; // url -> 已发起请求的加载上下文（持有 GCancellable）
+static guint aborted_downloads = 0;          // 因无人等待而中止的下载数
+static gint cancelled_transfers = 0;         // 中止后确实以 G_IO_ERROR_CANCELLED 结束的传输数
 static GMutex cache_mutex;                   // 缓存互斥锁
 
-// 缓存容量控制：避免内存无限增长
-#define THUMB_CACHE_MAX_ENTRIES 700
-#define FULLSIZE_CACHE_MAX_ENTRIES 80
-static GQueue *thumb_cache_order = NULL;     // key(dup) FIFO，用于淘汰
-static GQueue *fullsize_cache_order = NULL;  // key(dup) FIFO，用于淘汰
+// 内存缓存：按卡片ID索引的 LRU，按像素数据字节数（rowstride × height）限制容量。
+// 缩略图与全尺寸图片分别计算预算，可通过环境变量调整（单位 MiB）：
+// YGO_THUMB_CACHE_MB、YGO_FULLSIZE_CACHE_MB；设置 YGO_ENABLE_MEM_CACHE=0 可完全关闭。
+#define THUMB_CACHE_DEFAULT_MB 32
+#define FULLSIZE_CACHE_DEFAULT_MB 64
 
-// 是否启用内存缓存：默认关闭（只用磁盘缓存），避免内存持续上涨。
-// 如需启用，设置环境变量：YGO_ENABLE_MEM_CACHE=1
-static gboolean mem_cache_enabled = FALSE;
+typedef struct {
+    int card_id;
+    GdkPixbuf *pixbuf;
+    gsize bytes;
+} PixbufLruEntry;
+
+typedef struct {
+    const char *name;
+    GHashTable *map;     // card_id -> order 中的节点
+    GQueue order;        // 头部为最近使用
+    gsize bytes;
+    gsize budget;
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+} PixbufLru;
+
+static PixbufLru thumb_cache = { "thumb", NULL, G_QUEUE_INIT, 0, 0, 0, 0, 0 };
+static PixbufLru fullsize_cache = { "fullsize", NULL, G_QUEUE_INIT, 0, 0, 0, 0, 0 };
+
+// 是否启用内存缓存：默认启用（容量有字节上限），YGO_ENABLE_MEM_CACHE=0 时关闭
+static gboolean mem_cache_enabled = TRUE;
 static gsize mem_cache_enabled_inited = 0;
 
 static gboolean is_mem_cache_enabled(void) {
     if (g_once_init_enter(&mem_cache_enabled_inited)) {
         const char *v = g_getenv("YGO_ENABLE_MEM_CACHE");
-        mem_cache_enabled = (v && v[0] == '1');
+        mem_cache_enabled = !(v && v[0] == '0');
         g_once_init_leave(&mem_cache_enabled_inited, 1);
     }
     return mem_cache_enabled;
 }
 
+static gsize cache_budget_from_env(const char *name, guint default_mb) {
+    const char *v = g_getenv(name);
+    guint64 mb = default_mb;
+    if (v && *v) {
+        gchar *end = NULL;
+        guint64 parsed = g_ascii_strtoull(v, &end, 10);
+        if (end && end != v) mb = parsed;
+    }
+    return (gsize)mb * 1024 * 1024;
+}
+
+static void pixbuf_lru_entry_free(PixbufLruEntry *entry) {
+    g_object_unref(entry->pixbuf);
+    g_free(entry);
+}
+
+static void pixbuf_lru_init(PixbufLru *lru, gsize budget) {
+    lru->map = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_queue_init(&lru->order);
+    lru->bytes = 0;
+    lru->budget = budget;
+}
+
+static void pixbuf_lru_clear(PixbufLru *lru) {
+    if (!lru->map) return;
+    g_hash_table_destroy(lru->map);
+    lru->map = NULL;
+    g_queue_clear_full(&lru->order, (GDestroyNotify)pixbuf_lru_entry_free);
+    lru->bytes = 0;
+}
+
+// 查找并标记为最近使用；返回的 pixbuf 由缓存持有。调用者需持有 cache_mutex
+static GdkPixbuf* pixbuf_lru_lookup(PixbufLru *lru, int card_id) {
+    if (!lru->map) return NULL;
+    GList *link = g_hash_table_lookup(lru->map, GINT_TO_POINTER(card_id));
+    if (!link) {
+        lru->misses++;
+        return NULL;
+    }
+    lru->hits++;
+    g_queue_unlink(&lru->order, link);
+    g_queue_push_head_link(&lru->order, link);
+    return ((PixbufLruEntry*)link->data)->pixbuf;
+}
+
+// 插入或替换，然后从最久未使用的一端淘汰到预算以内（刚插入的条目保留）。调用者需持有 cache_mutex
+static void pixbuf_lru_insert(PixbufLru *lru, int card_id, GdkPixbuf *pixbuf) {
+    if (!lru->map || !pixbuf || card_id <= 0) return;
+    GList *link = g_hash_table_lookup(lru->map, GINT_TO_POINTER(card_id));
+    if (link) {
+        PixbufLruEntry *old = (PixbufLruEntry*)link->data;
+        lru->bytes -= old->bytes;
+        g_queue_delete_link(&lru->order, link);
+        pixbuf_lru_entry_free(old);
+    }
+
+    PixbufLruEntry *entry = g_new0(PixbufLruEntry, 1);
+    entry->card_id = card_id;
+    entry->pixbuf = g_object_ref(pixbuf);
+    entry->bytes = (gsize)gdk_pixbuf_get_rowstride(pixbuf) * (gsize)gdk_pixbuf_get_height(pixbuf);
+    g_queue_push_head(&lru->order, entry);
+    g_hash_table_replace(lru->map, GINT_TO_POINTER(card_id), lru->order.head);
+    lru->bytes += entry->bytes;
+
+    while (lru->bytes > lru->budget && lru->order.tail != lru->order.head) {
+        PixbufLruEntry *victim = (PixbufLruEntry*)g_queue_pop_tail(&lru->order);
+        g_hash_table_remove(lru->map, GINT_TO_POINTER(victim->card_id));
+        lru->bytes -= victim->bytes;
+        lru->evictions++;
+        pixbuf_lru_entry_free(victim);
+    }
+}
+
+static void pixbuf_lru_get_stats(const PixbufLru *lru, ImageMemCacheStats *out) {
+    out->entries = lru->map ? g_hash_table_size(lru->map) : 0;
+    out->bytes = lru->bytes;
+    out->budget = lru->budget;
+    out->hits = lru->hits;
+    out->misses = lru->misses;
+    out->evictions = lru->evictions;
+}
+
 // 缩略图逻辑尺寸（与 UI 中 thumb-fixed 保持一致）
 #define THUMB_W 68
 #define THUMB_H 99
@@ -49,17 +155,6 @@ static GdkPixbuf* create_thumb_pixbuf(GdkPixbuf *src, int scale_factor) {
     return g_object_ref(src);
 }
 
-static void evict_cache_if_needed(GHashTable *cache, GQueue *order, guint max_entries) {
-    if (!cache || !order) return;
-    while (g_hash_table_size(cache) > max_entries) {
-        char *old_key = (char*)g_queue_pop_head(order);
-        if (!old_key) break;
-        // 可能存在重复 key（replace 时再次入队），remove 失败则忽略
-        g_hash_table_remove(cache, old_key);
-        g_free(old_key);
-    }
-}
-
 // 全局取消标志（使用计数器而不是GCancellable列表）
 // 每次开始新搜索时递增，回调检查这个值来判断是否应该继续
 static guint64 global_cancel_generation = 0;
@@ -67,15 +162,66 @@ static GMutex cancel_generation_mutex;
 
 // 下载队列管理
 #define MAX_CONCURRENT_DOWNLOADS 6  // 最大并发下载数
-static GQueue *download_queue = NULL;        // 待下载队列
+// 待下载队列：每个优先级一个先进先出队列，取出时选等效优先级最高的队首。
+// 预览和卡组槽位属于交互请求，总是最先处理；其余请求的等效优先级随排队时间提升
+// （每 DOWNLOAD_AGING_US 提升一级，最多提升到 VISIBLE），低优先级请求不会被一直压住。
+#define DOWNLOAD_QUEUE_CLASSES IMAGE_LOAD_PRIORITY_DROP
+#define DOWNLOAD_AGING_US (2 * G_USEC_PER_SEC)
+static GQueue download_queues[DOWNLOAD_QUEUE_CLASSES];
+static GHashTable *queued_downloads = NULL;  // url -> 排队中的上下文在队列中的节点
 static int active_downloads = 0;             // 当前活跃下载数
 static GMutex download_queue_mutex;          // 队列互斥锁
 
+// 异步读取的响应体字节数（主线程上没有任何阻塞读取）
+static gsize async_bytes_read = 0;
+
+// 解码线程池：图片解码使用独立线程池（线程数等于 CPU 核心数），不占用 GLib 默认的 GTask 线程池。
+// 排队与执行中的任务达到线程数的 DECODE_BACKLOG_PER_THREAD 倍时，下载队列暂停发起新下载，
+// 搜索结果暂停加载本地图片，直到有解码任务完成，避免大量图片同时解码占用内存。
+#define DECODE_BACKLOG_PER_THREAD 2
+typedef struct {
+    GTask *task;
+    GTaskThreadFunc func;
+    gint64 queued_us;
+} DecodeJob;
+static GThreadPool *decode_pool = NULL;
+static guint decode_threads = 0;
+static gint decode_backlog = 0;              // 排队与执行中的任务数
+static gint decode_backlog_peak = 0;
+static GMutex decode_stats_mutex;            // 保护以下统计
+static guint64 decode_jobs_done = 0;
+static gint64 decode_wait_us_total = 0;      // 排队等待时间
+static gint64 decode_run_us_total = 0;       // 执行时间
+static gint64 decode_run_us_max = 0;
+static gint download_queue_stalled = 0;      // 下载队列因解码积压而暂停
+static SoupSession *download_session = NULL; // 恢复下载队列时使用（弱引用）
+
+// 磁盘缓存容量：两个打包文件合计不超过 YGO_DISK_CACHE_MB（默认 512，0 表示不限制），
+// 其中缩略图占 1/8。启动后以及短时间内写入较多数据后，在后台线程按最近访问时间淘汰。
+// 同一个后台任务还会写回打包缓存的索引，异常退出时最多只需从索引之后扫描最近写入的记录。
+#define DISK_CACHE_DEFAULT_MB 512
+#define DISK_CACHE_THUMB_SHARE 8
+#define DISK_TRIM_STARTUP_DELAY_S 10              // 启动后延迟裁剪，避开启动时的加载高峰
+#define DISK_TRIM_BURST_DELAY_S 5
+#define DISK_TRIM_BURST_BYTES (16 * 1024 * 1024)  // 累计写入该字节数后安排一次裁剪
+#define DISK_TRIM_BURST_WRITES 256                // 或累计写入该条数后（缩略图很小，主要靠条数触发）
+static gsize disk_cache_budget = 0;
+static GMutex disk_trim_mutex;                    // 裁剪期间持有，防止打包缓存被关闭
+static gint disk_trim_pending = 0;                // 已安排或正在进行裁剪
+static guint disk_trim_source_id = 0;             // 主线程的延迟裁剪定时器
+static gsize disk_bytes_since_trim = 0;
+static gint disk_writes_since_trim = 0;
+
 // 内部结构：解码任务数据
 typedef struct {
     GBytes *image_data;
     ImageLoadCtx *ctx;
     guint64 cancel_generation;  // 创建时的取消代次
+    int cache_id;               // >0 时解码成功后把原始字节写入磁盘缓存
+    char *content_type;         // 响应的 Content-Type（可能为 NULL）
+    int thumb_scale;            // >0 时在解码线程生成该倍率的缩略图
+    gboolean keep_full;         // 有目标需要全尺寸图片（左侧预览）；否则直接解码为缩略图尺寸
+    GdkPixbuf *thumb;           // 解码线程生成的缩略图（完成回调接管）
 } DecodeTaskData;
 
 // 前向声明
@@ -84,20 +230,30 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
 static void image_response_cb(GObject *source, GAsyncResult *res, gpointer user_data);
 static void process_download_queue(SoupSession *session);
 static void start_download(SoupSession *session, ImageLoadCtx *ctx);
+static ImageLoadCtx* download_queue_pop(void);
+static void collect_abandoned_downloads(ImageLoadPriorityFunc func, gpointer user_data, GPtrArray *to_cancel);
+static void cancel_abandoned_downloads(GPtrArray *to_cancel);
+static gboolean start_disk_trim_cb(gpointer user_data);
+static void decode_pool_worker(gpointer job_data, gpointer user_data);
 
 void init_image_cache(void) {
     g_mutex_init(&cache_mutex);
     g_mutex_init(&cancel_generation_mutex);
     g_mutex_init(&download_queue_mutex);
+    g_mutex_init(&disk_trim_mutex);
+    g_mutex_init(&decode_stats_mutex);
+
+    decode_threads = MAX(g_get_num_processors(), 1);
+    decode_pool = g_thread_pool_new(decode_pool_worker, NULL, (gint)decode_threads, FALSE, NULL);
     
     if (is_mem_cache_enabled()) {
-        thumb_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
-        fullsize_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
-        thumb_cache_order = g_queue_new();
-        fullsize_cache_order = g_queue_new();
+        pixbuf_lru_init(&thumb_cache, cache_budget_from_env("YGO_THUMB_CACHE_MB", THUMB_CACHE_DEFAULT_MB));
+        pixbuf_lru_init(&fullsize_cache, cache_budget_from_env("YGO_FULLSIZE_CACHE_MB", FULLSIZE_CACHE_DEFAULT_MB));
     }
     pending_downloads = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
-    download_queue = g_queue_new();
+    in_flight_downloads = g_hash_table_new(g_str_hash, g_str_equal);
+    for (int i = 0; i < DOWNLOAD_QUEUE_CLASSES; i++) g_queue_init(&download_queues[i]);
+    queued_downloads = g_hash_table_new(g_str_hash, g_str_equal);
     
     // 创建缓存目录
     if (is_portable_mode()) {
@@ -110,30 +266,76 @@ void init_image_cache(void) {
         cache_dir = g_build_filename(cache_home, "ygo-deck-builder", "images", NULL);
     }
     g_mkdir_with_parents(cache_dir, 0755);
+    image_pack = image_pack_open(cache_dir, "images");
+    thumb_pack = image_pack_open(cache_dir, "thumbs");
+
+    disk_cache_budget = cache_budget_from_env("YGO_DISK_CACHE_MB", DISK_CACHE_DEFAULT_MB);
+    if (disk_cache_budget > 0 && (image_pack || thumb_pack)) {
+        g_atomic_int_set(&disk_trim_pending, 1);
+        disk_trim_source_id = g_timeout_add_seconds(DISK_TRIM_STARTUP_DELAY_S, start_disk_trim_cb, NULL);
+    }
 }
 
 void cleanup_image_cache(void) {
-    g_mutex_lock(&cache_mutex);
-    if (thumb_cache) {
-        g_hash_table_destroy(thumb_cache);
-        thumb_cache = NULL;
+    // 应用没有激活过（例如只转发给已运行的实例）时没有需要清理的内容
+    if (!cache_dir) return;
+
+    // 先等待排队中的解码任务完成（解码线程会写入磁盘缓存）
+    if (decode_pool) {
+        g_thread_pool_free(decode_pool, FALSE, TRUE);
+        decode_pool = NULL;
+    }
+    ImageDecodePoolStats decode_stats;
+    image_loader_get_decode_pool_stats(&decode_stats);
+    g_message("Image decode pool: %u threads, %" G_GUINT64_FORMAT " jobs, peak backlog %u/%u, "
+              "avg wait %.1f ms, avg decode %.1f ms, max decode %.1f ms",
+              decode_stats.threads, decode_stats.completed, decode_stats.peak_backlog, decode_stats.backlog_limit,
+              decode_stats.avg_wait_ms, decode_stats.avg_decode_ms, decode_stats.max_decode_ms);
+    if (download_session) {
+        g_object_remove_weak_pointer(G_OBJECT(download_session), (gpointer*)&download_session);
+        download_session = NULL;
     }
-    if (fullsize_cache) {
-        g_hash_table_destroy(fullsize_cache);
-        fullsize_cache = NULL;
+
+    if (disk_trim_source_id) {
+        g_source_remove(disk_trim_source_id);
+        disk_trim_source_id = 0;
+    }
+    ImageDiskCacheStats disk_stats[2];
+    image_loader_get_disk_cache_stats(&disk_stats[0], &disk_stats[1]);
+    for (guint i = 0; i < G_N_ELEMENTS(disk_stats); i++) {
+        g_message("Image disk cache %s: %u entries, %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT " bytes, "
+                  "%.1f%% hit ratio, %" G_GUINT64_FORMAT " evictions",
+                  i == 0 ? "images" : "thumbs", disk_stats[i].entries, disk_stats[i].bytes, disk_stats[i].budget,
+                  disk_stats[i].hit_ratio * 100.0, disk_stats[i].evictions);
+    }
+
+    // 写回打包缓存的索引；进行中的后台压缩先放弃（原文件不变），再等待裁剪线程结束
+    image_pack_abort_compaction(image_pack);
+    image_pack_abort_compaction(thumb_pack);
+    g_mutex_lock(&disk_trim_mutex);
+    image_pack_close(image_pack);
+    image_pack = NULL;
+    image_pack_close(thumb_pack);
+    thumb_pack = NULL;
+    g_mutex_unlock(&disk_trim_mutex);
+
+    g_mutex_lock(&cache_mutex);
+    PixbufLru *lrus[] = { &thumb_cache, &fullsize_cache };
+    for (guint i = 0; i < G_N_ELEMENTS(lrus); i++) {
+        if (!lrus[i]->map) continue;
+        g_message("Image %s cache: %u entries, %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " bytes, "
+                  "%" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses, %" G_GUINT64_FORMAT " evictions",
+                  lrus[i]->name, g_hash_table_size(lrus[i]->map), lrus[i]->bytes, lrus[i]->budget,
+                  lrus[i]->hits, lrus[i]->misses, lrus[i]->evictions);
+        pixbuf_lru_clear(lrus[i]);
     }
     if (pending_downloads) {
         g_hash_table_destroy(pending_downloads);
         pending_downloads = NULL;
     }
-
-    if (thumb_cache_order) {
-        g_queue_free_full(thumb_cache_order, g_free);
-        thumb_cache_order = NULL;
-    }
-    if (fullsize_cache_order) {
-        g_queue_free_full(fullsize_cache_order, g_free);
-        fullsize_cache_order = NULL;
+    if (in_flight_downloads) {
+        g_hash_table_destroy(in_flight_downloads);
+        in_flight_downloads = NULL;
     }
 
     g_free(cache_dir);
@@ -141,11 +343,10 @@ void cleanup_image_cache(void) {
     g_mutex_unlock(&cache_mutex);
     
     g_mutex_lock(&download_queue_mutex);
-    if (download_queue) {
+    if (queued_downloads) {
         // 清理队列中的所有上下文
-        gpointer item;
-        while ((item = g_queue_pop_head(download_queue)) != NULL) {
-            ImageLoadCtx *ctx = (ImageLoadCtx*)item;
+        ImageLoadCtx *ctx;
+        while ((ctx = download_queue_pop()) != NULL) {
             if (ctx->target) {
                 g_object_remove_weak_pointer(G_OBJECT(ctx->target), (gpointer*)&ctx->target);
             }
@@ -155,66 +356,442 @@ void cleanup_image_cache(void) {
             g_free(ctx->url);
             g_free(ctx);
         }
-        g_queue_free(download_queue);
-        download_queue = NULL;
+        g_hash_table_destroy(queued_downloads);
+        queued_downloads = NULL;
     }
     g_mutex_unlock(&download_queue_mutex);
+
+    g_message("Image loader: %" G_GSIZE_FORMAT " bytes read asynchronously, %u abandoned downloads aborted, "
+              "%d transfers ended cancelled",
+              image_loader_get_async_bytes_read(), aborted_downloads, g_atomic_int_get(&cancelled_transfers));
     
     g_mutex_clear(&cache_mutex);
     g_mutex_clear(&cancel_generation_mutex);
     g_mutex_clear(&download_queue_mutex);
+    g_mutex_clear(&disk_trim_mutex);
+    g_mutex_clear(&decode_stats_mutex);
+}
+
+// ===== 解码线程池 =====
+
+static guint decode_backlog_limit(void) {
+    return MAX(decode_threads, 1) * DECODE_BACKLOG_PER_THREAD;
+}
+
+gboolean image_loader_decode_pool_busy(void) {
+    return decode_pool && (guint)g_atomic_int_get(&decode_backlog) >= decode_backlog_limit();
+}
+
+static gboolean resume_download_queue_idle(gpointer user_data) {
+    (void)user_data;
+    if (download_session) process_download_queue(download_session);
+    return G_SOURCE_REMOVE;
+}
+
+static void decode_pool_worker(gpointer job_data, gpointer user_data) {
+    (void)user_data;
+    DecodeJob *job = (DecodeJob*)job_data;
+    gint64 start_us = g_get_monotonic_time();
+    job->func(job->task, g_task_get_source_object(job->task), g_task_get_task_data(job->task),
+              g_task_get_cancellable(job->task));
+    gint64 run_us = g_get_monotonic_time() - start_us;
+
+    g_mutex_lock(&decode_stats_mutex);
+    decode_jobs_done++;
+    decode_wait_us_total += start_us - job->queued_us;
+    decode_run_us_total += run_us;
+    decode_run_us_max = MAX(decode_run_us_max, run_us);
+    g_mutex_unlock(&decode_stats_mutex);
+
+    g_object_unref(job->task);
+    g_free(job);
+
+    // 积压降到上限以下后恢复因解码积压而暂停的下载队列
+    g_atomic_int_add(&decode_backlog, -1);
+    if (!image_loader_decode_pool_busy() && g_atomic_int_compare_and_exchange(&download_queue_stalled, 1, 0)) {
+        g_idle_add(resume_download_queue_idle, NULL);
+    }
+}
+
+void image_loader_run_in_decode_pool(GTask *task, GTaskThreadFunc func) {
+    if (!decode_pool) {
+        g_task_run_in_thread(task, func);
+        return;
+    }
+    DecodeJob *job = g_new(DecodeJob, 1);
+    job->task = g_object_ref(task);
+    job->func = func;
+    job->queued_us = g_get_monotonic_time();
+    gint backlog = g_atomic_int_add(&decode_backlog, 1) + 1;
+    gint peak = g_atomic_int_get(&decode_backlog_peak);
+    while (backlog > peak && !g_atomic_int_compare_and_exchange(&decode_backlog_peak, peak, backlog)) {
+        peak = g_atomic_int_get(&decode_backlog_peak);
+    }
+    g_thread_pool_push(decode_pool, job, NULL);
+}
+
+void image_loader_get_decode_pool_stats(ImageDecodePoolStats *out) {
+    if (!out) return;
+    out->threads = decode_threads;
+    out->backlog = (guint)g_atomic_int_get(&decode_backlog);
+    out->backlog_limit = decode_backlog_limit();
+    out->peak_backlog = (guint)g_atomic_int_get(&decode_backlog_peak);
+    g_mutex_lock(&decode_stats_mutex);
+    out->completed = decode_jobs_done;
+    out->avg_wait_ms = decode_jobs_done > 0 ? decode_wait_us_total / 1000.0 / decode_jobs_done : 0.0;
+    out->avg_decode_ms = decode_jobs_done > 0 ? decode_run_us_total / 1000.0 / decode_jobs_done : 0.0;
+    out->max_decode_ms = decode_run_us_max / 1000.0;
+    g_mutex_unlock(&decode_stats_mutex);
+}
+
+typedef struct {
+    int width;
+    int height;
+} DecodeSize;
+
+static void on_loader_size_prepared(GdkPixbufLoader *loader, int width, int height, gpointer user_data) {
+    const DecodeSize *target = (const DecodeSize*)user_data;
+    if (width != target->width || height != target->height) {
+        gdk_pixbuf_loader_set_size(loader, target->width, target->height);
+    }
+}
+
+// 解码内存中的图片数据；mime_type 可选，无法识别时由 gdk-pixbuf 按内容自动识别格式。
+// target 非 NULL 时由加载器直接解码到该尺寸（webp/jpeg 等格式在解码阶段缩小，不生成全尺寸像素）
+static GdkPixbuf* decode_image_bytes_sized(const guint8 *bytes, gsize size, const char *mime_type,
+                                           const DecodeSize *target) {
+    if (!bytes || size == 0) return NULL;
+    GdkPixbufLoader *loader = NULL;
+    if (mime_type && *mime_type) {
+        loader = gdk_pixbuf_loader_new_with_mime_type(mime_type, NULL);
+    }
+    if (!loader) loader = gdk_pixbuf_loader_new();
+    if (target) {
+        g_signal_connect(loader, "size-prepared", G_CALLBACK(on_loader_size_prepared), (gpointer)target);
+    }
+
+    GdkPixbuf *pixbuf = NULL;
+    GError *err = NULL;
+    if (gdk_pixbuf_loader_write(loader, bytes, size, &err) && gdk_pixbuf_loader_close(loader, &err)) {
+        pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+        if (pixbuf) pixbuf = g_object_ref(pixbuf);
+    } else {
+        if (err) g_error_free(err);
+        gdk_pixbuf_loader_close(loader, NULL);
+    }
+    g_object_unref(loader);
+    return pixbuf;
+}
+
+static GdkPixbuf* decode_image_bytes(const guint8 *bytes, gsize size, const char *mime_type) {
+    return decode_image_bytes_sized(bytes, size, mime_type, NULL);
+}
+
+// 直接解码为缩略图尺寸
+static GdkPixbuf* decode_thumb_bytes(const guint8 *bytes, gsize size, const char *mime_type, int scale_factor) {
+    if (scale_factor < 1) scale_factor = 1;
+    DecodeSize target = { THUMB_W * scale_factor, THUMB_H * scale_factor };
+    GdkPixbuf *thumb = decode_image_bytes_sized(bytes, size, mime_type, &target);
+    if (thumb && (gdk_pixbuf_get_width(thumb) != target.width || gdk_pixbuf_get_height(thumb) != target.height)) {
+        // 加载器未按要求缩放时退回到解码后缩放
+        GdkPixbuf *scaled = create_thumb_pixbuf(thumb, scale_factor);
+        g_object_unref(thumb);
+        thumb = scaled;
+    }
+    return thumb;
+}
+
+// ===== 磁盘缓存容量控制 =====
+
+static guint64 disk_cache_thumb_budget(void) {
+    return disk_cache_budget / DISK_CACHE_THUMB_SHARE;
+}
+
+static void disk_trim_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    (void)source_object;
+    (void)task_data;
+    (void)cancellable;
+    gint64 start_us = g_get_monotonic_time();
+    guint evicted = 0;
+    g_mutex_lock(&disk_trim_mutex);
+    if (disk_cache_budget > 0) {
+        // 裁剪时同时写回索引（失效数据较多时顺便压缩）
+        evicted = image_pack_trim(thumb_pack, disk_cache_thumb_budget()) +
+                  image_pack_trim(image_pack, disk_cache_budget - disk_cache_thumb_budget());
+    } else {
+        // 不限制大小：不淘汰，只写回索引并在失效数据较多时压缩
+        image_pack_trim(thumb_pack, G_MAXUINT64);
+        image_pack_trim(image_pack, G_MAXUINT64);
+    }
+    g_mutex_unlock(&disk_trim_mutex);
+    if (evicted > 0) {
+        g_message("Image disk cache: evicted %u entries in %.1f ms", evicted,
+                  (g_get_monotonic_time() - start_us) / 1000.0);
+    }
+    g_task_return_boolean(task, TRUE);
+}
+
+static void disk_trim_finished(GObject *source, GAsyncResult *res, gpointer user_data) {
+    (void)source;
+    (void)res;
+    (void)user_data;
+    g_atomic_int_set(&disk_trim_pending, 0);
+}
+
+static gboolean start_disk_trim_cb(gpointer user_data) {
+    (void)user_data;
+    disk_trim_source_id = 0;
+    GTask *task = g_task_new(NULL, NULL, disk_trim_finished, NULL);
+    g_task_set_priority(task, G_PRIORITY_LOW);
+    g_task_run_in_thread(task, disk_trim_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean schedule_disk_trim_idle(gpointer user_data) {
+    (void)user_data;
+    if (disk_trim_source_id == 0) {
+        disk_trim_source_id = g_timeout_add_seconds(DISK_TRIM_BURST_DELAY_S, start_disk_trim_cb, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// 写入打包缓存后调用（可在工作线程）：累计写入量达到阈值时回到主线程安排一次裁剪（并写回索引）
+static void note_disk_cache_write(gsize size) {
+    gsize total = (gsize)g_atomic_pointer_add(&disk_bytes_since_trim, (gssize)size) + size;
+    gint writes = g_atomic_int_add(&disk_writes_since_trim, 1) + 1;
+    if ((total >= DISK_TRIM_BURST_BYTES || writes >= DISK_TRIM_BURST_WRITES) &&
+        g_atomic_int_compare_and_exchange(&disk_trim_pending, 0, 1)) {
+        g_atomic_pointer_set(&disk_bytes_since_trim, 0);
+        g_atomic_int_set(&disk_writes_since_trim, 0);
+        g_idle_add(schedule_disk_trim_idle, NULL);
+    }
+}
+
+static void pack_get_disk_stats(ImagePack *pack, guint64 budget, ImageDiskCacheStats *out) {
+    if (!out) return;
+    ImagePackStats stats;
+    image_pack_get_stats(pack, &stats);
+    out->entries = stats.entries;
+    out->bytes = stats.file_bytes;
+    out->budget = budget;
+    out->hits = stats.hits;
+    out->misses = stats.misses;
+    out->evictions = stats.evictions;
+    guint64 lookups = stats.hits + stats.misses;
+    out->hit_ratio = lookups > 0 ? (double)stats.hits / (double)lookups : 0.0;
+}
+
+void image_loader_get_disk_cache_stats(ImageDiskCacheStats *images, ImageDiskCacheStats *thumbs) {
+    guint64 thumb_budget = disk_cache_thumb_budget();
+    pack_get_disk_stats(image_pack, disk_cache_budget - thumb_budget, images);
+    pack_get_disk_stats(thumb_pack, thumb_budget, thumbs);
+}
+
+// 打包条目的 tag 记录图片格式（Content-Type 在下表中的下标，0 表示未知）
+static const char *pack_content_types[] = { NULL, "image/webp", "image/png", "image/jpeg", "image/gif" };
+
+static guint32 pack_tag_from_content_type(const char *content_type) {
+    if (!content_type) return 0;
+    for (guint i = 1; i < G_N_ELEMENTS(pack_content_types); i++) {
+        if (g_ascii_strcasecmp(content_type, pack_content_types[i]) == 0) return i;
+    }
+    return 0;
+}
+
+static const char* pack_tag_content_type(guint32 tag) {
+    return tag < G_N_ELEMENTS(pack_content_types) ? pack_content_types[tag] : NULL;
+}
+
+// 缩略图键：卡片ID与缩放倍率
+static guint64 thumb_pack_key(int card_id, int scale_factor) {
+    return ((guint64)(guint32)card_id << 8) | (guint64)(scale_factor & 0xff);
+}
+
+static GdkPixbuf* decode_pack_bytes(GBytes *bytes, guint32 tag) {
+    gsize size = 0;
+    const guint8 *data = g_bytes_get_data(bytes, &size);
+    return decode_image_bytes(data, size, pack_tag_content_type(tag));
+}
+
+// 旧版本的单文件缓存：<id>.img 为下载的原始字节，<id>.type 记录其 Content-Type；更早的版本为 <id>.png
+static char* disk_cache_path(int card_id, const char *suffix) {
+    return g_strdup_printf("%s/%d.%s", cache_dir, card_id, suffix);
+}
+
+// 读取单文件缓存；打包缓存可用时顺便迁入并删除旧文件
+static GdkPixbuf* load_from_legacy_files(int card_id) {
+    static const char *suffixes[] = { "img", "png" };
+    for (guint i = 0; i < G_N_ELEMENTS(suffixes); i++) {
+        char *filename = disk_cache_path(card_id, suffixes[i]);
+        gchar *contents = NULL;
+        gsize length = 0;
+        if (!g_file_get_contents(filename, &contents, &length, NULL)) {
+            g_free(filename);
+            continue;
+        }
+        char *type_path = disk_cache_path(card_id, "type");
+        gchar *mime_type = NULL;
+        if (i == 0) {
+            if (g_file_get_contents(type_path, &mime_type, NULL, NULL)) g_strstrip(mime_type);
+        } else {
+            mime_type = g_strdup("image/png");
+        }
+
+        GdkPixbuf *pb = decode_image_bytes((const guint8*)contents, length, mime_type);
+        if (pb && image_pack_store(image_pack, (guint64)card_id, contents, length,
+                                   pack_tag_from_content_type(mime_type))) {
+            g_unlink(filename);
+            if (i == 0) g_unlink(type_path);
+        }
+        g_free(mime_type);
+        g_free(type_path);
+        g_free(contents);
+        g_free(filename);
+        if (pb) return pb;
+    }
+    return NULL;
 }
 
 GdkPixbuf* load_from_disk_cache(int card_id) {
     if (!cache_dir) return NULL;
-    char *filename = g_strdup_printf("%s/%d.png", cache_dir, card_id);
+
+    guint32 tag = 0;
+    GBytes *bytes = image_pack_lookup(image_pack, (guint64)card_id, &tag);
+    if (bytes) {
+        GdkPixbuf *pb = decode_pack_bytes(bytes, tag);
+        g_bytes_unref(bytes);
+        if (pb) return pb;
+    }
+    return load_from_legacy_files(card_id);
+}
+
+gboolean disk_cache_has_image(int card_id) {
+    return card_id > 0 && image_pack_contains(image_pack, (guint64)card_id);
+}
+
+void save_bytes_to_disk_cache(int card_id, GBytes *bytes, const char *content_type) {
+    if (!cache_dir || !bytes || card_id <= 0) return;
+    gsize size = 0;
+    const gchar *data = g_bytes_get_data(bytes, &size);
+    if (size == 0) return;
+
+    if (image_pack) {
+        if (image_pack_store(image_pack, (guint64)card_id, data, size, pack_tag_from_content_type(content_type))) {
+            note_disk_cache_write(size);
+        } else {
+            g_warning("写入图片打包缓存失败: %d", card_id);
+        }
+        return;
+    }
+
+    // 打包缓存不可用时退回单文件缓存
+    // g_file_set_contents 先写临时文件再重命名，读者不会看到半写入的文件
+    char *filename = disk_cache_path(card_id, "img");
     GError *err = NULL;
-    GdkPixbuf *pb = gdk_pixbuf_new_from_file(filename, &err);
-    if (err) {
+    if (!g_file_set_contents(filename, data, (gssize)size, &err)) {
+        g_warning("写入图片缓存失败 %s: %s", filename, err->message);
         g_error_free(err);
-        pb = NULL;
+        g_free(filename);
+        return;
     }
     g_free(filename);
-    return pb;
+
+    char *type_path = disk_cache_path(card_id, "type");
+    if (content_type && *content_type) {
+        g_file_set_contents(type_path, content_type, -1, NULL);
+    } else {
+        // 类型未知时由 gdk-pixbuf 按内容识别
+        g_unlink(type_path);
+    }
+    g_free(type_path);
 }
 
-void save_to_disk_cache(int card_id, GdkPixbuf *pixbuf) {
-    if (!cache_dir || !pixbuf) return;
-    char *filename = g_strdup_printf("%s/%d.png", cache_dir, card_id);
+void save_thumb_to_disk_cache(int card_id, int scale_factor, GdkPixbuf *thumb) {
+    if (!thumb_pack || !thumb || card_id <= 0) return;
+    if (scale_factor < 1) scale_factor = 1;
+    gchar *buffer = NULL;
+    gsize size = 0;
     GError *err = NULL;
-    gdk_pixbuf_save(pixbuf, filename, "png", &err, NULL);
-    if (err) {
-        g_error_free(err);
+    if (!gdk_pixbuf_save_to_buffer(thumb, &buffer, &size, "png", &err, NULL)) {
+        if (err) g_error_free(err);
+        return;
     }
-    g_free(filename);
+    if (image_pack_store(thumb_pack, thumb_pack_key(card_id, scale_factor), buffer, size,
+                         pack_tag_from_content_type("image/png"))) {
+        note_disk_cache_write(size);
+    }
+    g_free(buffer);
+}
+
+GdkPixbuf* load_thumb_from_thumb_pack(int card_id, int scale_factor) {
+    if (card_id <= 0) return NULL;
+    if (scale_factor < 1) scale_factor = 1;
+
+    guint32 tag = 0;
+    GBytes *bytes = image_pack_lookup(thumb_pack, thumb_pack_key(card_id, scale_factor), &tag);
+    if (!bytes) return NULL;
+    GdkPixbuf *thumb = decode_pack_bytes(bytes, tag);
+    g_bytes_unref(bytes);
+    return thumb;
+}
+
+GdkPixbuf* load_thumb_from_disk_cache(int card_id, int scale_factor) {
+    if (card_id <= 0) return NULL;
+    if (scale_factor < 1) scale_factor = 1;
+
+    GdkPixbuf *thumb = load_thumb_from_thumb_pack(card_id, scale_factor);
+    if (thumb) return thumb;
+
+    // 缩略图不存在（例如旧版本留下的缓存）：由原图直接解码到缩略图尺寸并写回
+    guint32 tag = 0;
+    GBytes *bytes = image_pack_lookup(image_pack, (guint64)card_id, &tag);
+    if (bytes) {
+        gsize size = 0;
+        const guint8 *data = g_bytes_get_data(bytes, &size);
+        thumb = decode_thumb_bytes(data, size, pack_tag_content_type(tag), scale_factor);
+        g_bytes_unref(bytes);
+    }
+    if (!thumb && cache_dir) {
+        GdkPixbuf *full = load_from_legacy_files(card_id);
+        if (!full) return NULL;
+        thumb = create_thumb_pixbuf(full, scale_factor);
+        g_object_unref(full);
+    }
+    if (thumb) save_thumb_to_disk_cache(card_id, scale_factor, thumb);
+    return thumb;
 }
 
 GdkPixbuf* get_thumb_from_cache(int card_id) {
     if (!is_mem_cache_enabled()) return NULL;
-    GdkPixbuf *result = NULL;
     g_mutex_lock(&cache_mutex);
-    if (thumb_cache) {
-        char key[32];
-        g_snprintf(key, sizeof(key), "%d", card_id);
-        result = (GdkPixbuf*)g_hash_table_lookup(thumb_cache, key);
-    }
+    GdkPixbuf *result = pixbuf_lru_lookup(&thumb_cache, card_id);
     g_mutex_unlock(&cache_mutex);
     return result;
 }
 
+void add_thumb_to_cache(int card_id, GdkPixbuf *pixbuf) {
+    if (!is_mem_cache_enabled()) return;
+    g_mutex_lock(&cache_mutex);
+    pixbuf_lru_insert(&thumb_cache, card_id, pixbuf);
+    g_mutex_unlock(&cache_mutex);
+}
+
 GdkPixbuf* get_fullsize_from_cache(int card_id) {
     if (!is_mem_cache_enabled()) return NULL;
-    GdkPixbuf *result = NULL;
     g_mutex_lock(&cache_mutex);
-    if (fullsize_cache) {
-        char key[32];
-        g_snprintf(key, sizeof(key), "%d", card_id);
-        result = (GdkPixbuf*)g_hash_table_lookup(fullsize_cache, key);
-    }
+    GdkPixbuf *result = pixbuf_lru_lookup(&fullsize_cache, card_id);
     g_mutex_unlock(&cache_mutex);
     return result;
 }
 
+void image_loader_get_mem_cache_stats(ImageMemCacheStats *thumb, ImageMemCacheStats *fullsize) {
+    g_mutex_lock(&cache_mutex);
+    if (thumb) pixbuf_lru_get_stats(&thumb_cache, thumb);
+    if (fullsize) pixbuf_lru_get_stats(&fullsize_cache, fullsize);
+    g_mutex_unlock(&cache_mutex);
+}
+
 // 获取当前取消代次（用于在开始异步操作前记录）
 guint64 get_cancel_generation(void) {
     guint64 gen;
@@ -234,8 +811,8 @@ gboolean is_cancelled(guint64 recorded_generation) {
 }
 
 void cancel_all_pending(void) {
-    // 仅递增取消代次，不实际取消任何GCancellable
-    // 这样libsoup的请求会自然完成，但回调会检测到代次变化并跳过处理
+    // 递增取消代次：回调会检测到代次变化并跳过处理。
+    // 进行中的下载如果没有任何新代次的请求在等待，会通过 GCancellable 中止，释放带宽和连接
     g_mutex_lock(&cancel_generation_mutex);
     global_cancel_generation++;
     g_mutex_unlock(&cancel_generation_mutex);
@@ -245,11 +822,9 @@ void cancel_all_pending(void) {
     // 锁顺序必须与 load_image_async 一致：cache_mutex -> download_queue_mutex，避免死锁。
     g_mutex_lock(&cache_mutex);
     g_mutex_lock(&download_queue_mutex);
-    if (download_queue) {
-        gpointer item;
-        while ((item = g_queue_pop_head(download_queue)) != NULL) {
-            ImageLoadCtx *ctx = (ImageLoadCtx*)item;
-
+    if (queued_downloads) {
+        ImageLoadCtx *ctx;
+        while ((ctx = download_queue_pop()) != NULL) {
             if (pending_downloads && ctx->url) {
                 g_hash_table_remove(pending_downloads, ctx->url);
             }
@@ -265,17 +840,104 @@ void cancel_all_pending(void) {
         }
     }
     g_mutex_unlock(&download_queue_mutex);
+
+    GPtrArray *to_cancel = g_ptr_array_new_with_free_func(g_object_unref);
+    collect_abandoned_downloads(NULL, NULL, to_cancel);
     g_mutex_unlock(&cache_mutex);
+    cancel_abandoned_downloads(to_cancel);
     
-    // 不要清空 pending_downloads！
-    // 活跃的下载回调仍然会访问这个哈希表
-    // 让回调函数自己清理（它们会检测到代次变化并跳过处理UI，但仍会从哈希表中移除条目）
+    // 其余进行中下载的 pending_downloads 条目不要清空：
+    // 活跃的下载回调仍然会访问这个哈希表，由回调自己清理
+}
+
+gsize image_loader_get_async_bytes_read(void) {
+    return (gsize)g_atomic_pointer_get(&async_bytes_read);
 }
 
 const char* get_cache_dir(void) {
     return cache_dir;
 }
 
+// 搜索结果行会被 GtkListView 回收给其他卡片：目标上记录的 bound_img_id 与本次加载的卡片不一致时不再更新控件
+static gboolean ctx_target_still_bound(const ImageLoadCtx *ctx) {
+    if (!ctx->target || ctx->cache_id <= 0) return TRUE;
+    int bound = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(ctx->target), "bound_img_id"));
+    return bound == 0 || bound == ctx->cache_id;
+}
+
+// ===== 下载队列（调用者需持有 download_queue_mutex）=====
+
+// 放入 ctx->priority 对应的队列，队列内按进入队列的时间排序（新请求直接追加到队尾）
+static void download_queue_insert(ImageLoadCtx *ctx) {
+    ctx->priority = CLAMP(ctx->priority, 0, DOWNLOAD_QUEUE_CLASSES - 1);
+    GQueue *queue = &download_queues[ctx->priority];
+    GList *l = queue->tail;
+    while (l && ((ImageLoadCtx*)l->data)->queued_at > ctx->queued_at) l = l->prev;
+    if (l) {
+        g_queue_insert_after(queue, l, ctx);
+        l = l->next;
+    } else {
+        g_queue_push_head(queue, ctx);
+        l = queue->head;
+    }
+    g_hash_table_insert(queued_downloads, ctx->url, l);
+}
+
+static void download_queue_push(ImageLoadCtx *ctx) {
+    ctx->queued_at = g_get_monotonic_time();
+    download_queue_insert(ctx);
+}
+
+// 取出等效优先级最高的请求：交互请求按优先级直接取出；
+// 其余请求用优先级减去排队时长换算的级数（不超过 VISIBLE），相同时取原优先级较高者
+static ImageLoadCtx* download_queue_pop(void) {
+    int best = -1;
+    for (int i = 0; i < IMAGE_LOAD_PRIORITY_VISIBLE && best < 0; i++) {
+        if (!g_queue_is_empty(&download_queues[i])) best = i;
+    }
+
+    if (best < 0) {
+        gint64 now = g_get_monotonic_time();
+        gint64 best_score = 0;
+        for (int i = IMAGE_LOAD_PRIORITY_VISIBLE; i < DOWNLOAD_QUEUE_CLASSES; i++) {
+            ImageLoadCtx *head = (ImageLoadCtx*)g_queue_peek_head(&download_queues[i]);
+            if (!head) continue;
+            // 老化收益封顶：最多提升 (i - VISIBLE) 级，不会越过交互请求
+            gint64 waited = MIN(now - head->queued_at,
+                                (gint64)(i - IMAGE_LOAD_PRIORITY_VISIBLE) * DOWNLOAD_AGING_US);
+            gint64 score = (gint64)i * DOWNLOAD_AGING_US - waited;
+            if (best < 0 || score < best_score) {
+                best = i;
+                best_score = score;
+            }
+        }
+    }
+    if (best < 0) return NULL;
+    ImageLoadCtx *ctx = (ImageLoadCtx*)g_queue_pop_head(&download_queues[best]);
+    g_hash_table_remove(queued_downloads, ctx->url);
+    return ctx;
+}
+
+// 同一URL以更高优先级再次请求时，把仍在排队的下载移到对应队列（保留原来的排队时间）
+static void download_queue_upgrade(const char *url, int priority) {
+    GList *link = (GList*)g_hash_table_lookup(queued_downloads, url);
+    if (!link) return;  // 已经开始下载
+    ImageLoadCtx *ctx = (ImageLoadCtx*)link->data;
+    if (priority >= ctx->priority) return;
+    g_hash_table_remove(queued_downloads, url);
+    g_queue_delete_link(&download_queues[ctx->priority], link);
+    ctx->priority = priority;
+    download_queue_insert(ctx);
+}
+
+// 释放尚未发起请求的加载上下文
+static void free_load_ctx(ImageLoadCtx *ctx) {
+    if (ctx->target) g_object_remove_weak_pointer(G_OBJECT(ctx->target), (gpointer*)&ctx->target);
+    if (ctx->stack) g_object_remove_weak_pointer(G_OBJECT(ctx->stack), (gpointer*)&ctx->stack);
+    g_free(ctx->url);
+    g_free(ctx);
+}
+
 // 后台线程：解码图片
 static void decode_task_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
     (void)source_object;
@@ -294,26 +956,31 @@ static void decode_task_thread(GTask *task, gpointer source_object, gpointer tas
         return;
     }
     
+    // 只需要缩略图时直接解码到缩略图尺寸，不生成全尺寸图片；主线程拿到的就是可直接显示的缩略图
     GdkPixbuf *pixbuf = NULL;
     if (data->image_data) {
         gsize size;
         const guint8 *bytes_data = g_bytes_get_data(data->image_data, &size);
         
         if (size > 0 && !is_cancelled(data->cancel_generation)) {
-            GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
-            GError *err = NULL;
-            if (gdk_pixbuf_loader_write(loader, bytes_data, size, &err)) {
-                gdk_pixbuf_loader_close(loader, NULL);
-                pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
-                if (pixbuf) {
-                    pixbuf = g_object_ref(pixbuf);
-                }
-            } else {
-                if (err) g_error_free(err);
+            if (data->keep_full) {
+                pixbuf = decode_image_bytes(bytes_data, size, data->content_type);
+                if (pixbuf && data->thumb_scale > 0) data->thumb = create_thumb_pixbuf(pixbuf, data->thumb_scale);
+            } else if (data->thumb_scale > 0) {
+                data->thumb = decode_thumb_bytes(bytes_data, size, data->content_type, data->thumb_scale);
             }
-            g_object_unref(loader);
         }
     }
+
+    // 能正常解码才写入磁盘缓存；直接保存下载的原始字节，不在UI线程重新编码
+    if ((pixbuf || data->thumb) && data->cache_id > 0) {
+        save_bytes_to_disk_cache(data->cache_id, data->image_data, data->content_type);
+    }
+
+    // 缩略图同时写入缩略图缓存，之后命中缓存时只需解码小图
+    if (data->thumb && data->cache_id > 0) {
+        save_thumb_to_disk_cache(data->cache_id, data->thumb_scale, data->thumb);
+    }
     
     if (pixbuf) {
         g_task_return_pointer(task, pixbuf, (GDestroyNotify)g_object_unref);
@@ -322,6 +989,21 @@ static void decode_task_thread(GTask *task, gpointer source_object, gpointer tas
     }
 }
 
+// 解码线程没有保留全尺寸图片时按需补解码（解码开始后才有需要全尺寸的请求加入同一下载，很少发生）
+static GdkPixbuf* decoded_full(DecodeTaskData *data, GdkPixbuf **full) {
+    if (!*full && data->image_data) {
+        gsize size = 0;
+        const guint8 *bytes = g_bytes_get_data(data->image_data, &size);
+        *full = decode_image_bytes(bytes, size, data->content_type);
+    }
+    return *full;
+}
+
+static GdkPixbuf* decoded_thumb(DecodeTaskData *data, GdkPixbuf **full, GdkPixbuf **thumb, int scale_factor) {
+    if (!*thumb && decoded_full(data, full)) *thumb = create_thumb_pixbuf(*full, scale_factor);
+    return *thumb;
+}
+
 // 解码完成回调
 static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer user_data) {
     (void)source;
@@ -331,6 +1013,8 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
         g_warning("decode_task_finished: data or ctx is NULL!");
         if (data) {
             if (data->image_data) g_bytes_unref(data->image_data);
+            if (data->thumb) g_object_unref(data->thumb);
+            g_free(data->content_type);
             g_free(data);
         }
         return;
@@ -345,72 +1029,46 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
         g_error_free(err);
     }
 
-    // 仅在需要缩略图时懒生成，避免每行持有大图导致内存飙升
-    GdkPixbuf *thumb_pixbuf = NULL;
+    // pixbuf 为全尺寸图片，只在有目标需要时由解码线程生成；缩略图通常已由解码线程直接解码得到
+    GdkPixbuf *thumb_pixbuf = data->thumb;
+    data->thumb = NULL;
+    gboolean decoded = pixbuf || thumb_pixbuf;
     
     // 使用代次检查代替 g_cancellable_is_cancelled
-    if (pixbuf && !is_cancelled(data->cancel_generation) && ctx->target) {
+    if (decoded && !is_cancelled(data->cancel_generation) && ctx->target) {
         // 额外的类型检查以确保对象仍然有效
         if (GTK_IS_WIDGET(ctx->target) && GTK_IS_DRAWING_AREA(ctx->target)) {
-            GdkPixbuf *ui_pixbuf = pixbuf;
-            if (ctx->scale_to_thumb) {
-                int sf = gtk_widget_get_scale_factor(GTK_WIDGET(ctx->target));
-                if (!thumb_pixbuf) thumb_pixbuf = create_thumb_pixbuf(pixbuf, sf);
-                ui_pixbuf = thumb_pixbuf ? thumb_pixbuf : pixbuf;
-            }
-            // 清空缓存的 surface（触发 destroy notify 如果有的话）
-            g_object_set_data_full(G_OBJECT(ctx->target), "cached_surface", NULL, NULL);
-            g_object_set_data_full(G_OBJECT(ctx->target), "cached_render", NULL, NULL);
-            
-            // 目标是DrawingArea（卡组槽位）
-            g_object_set_data_full(G_OBJECT(ctx->target), "pixbuf", g_object_ref(ui_pixbuf), 
-                                   (GDestroyNotify)g_object_unref);
-            gtk_widget_queue_draw(ctx->target);
-            
-            if (ctx->stack && GTK_IS_STACK(ctx->stack)) {
-                gtk_stack_set_visible_child_name(ctx->stack, "picture");
+            int sf = gtk_widget_get_scale_factor(GTK_WIDGET(ctx->target));
+            GdkPixbuf *ui_pixbuf = ctx->scale_to_thumb ?
+                decoded_thumb(data, &pixbuf, &thumb_pixbuf, sf) : decoded_full(data, &pixbuf);
+            if (ui_pixbuf && ctx_target_still_bound(ctx)) {
+                // 清空缓存的 surface（触发 destroy notify 如果有的话）
+                g_object_set_data_full(G_OBJECT(ctx->target), "cached_surface", NULL, NULL);
+                g_object_set_data_full(G_OBJECT(ctx->target), "cached_render", NULL, NULL);
+                
+                // 目标是DrawingArea（卡组槽位）
+                g_object_set_data_full(G_OBJECT(ctx->target), "pixbuf", g_object_ref(ui_pixbuf), 
+                                       (GDestroyNotify)g_object_unref);
+                gtk_widget_queue_draw(ctx->target);
+                
+                if (ctx->stack && GTK_IS_STACK(ctx->stack)) {
+                    gtk_stack_set_visible_child_name(ctx->stack, "picture");
+                }
             }
             
             // 添加到缩略图缓存（只缓存缩略图；如禁用内存缓存则跳过）
-            if (is_mem_cache_enabled() && ctx->add_to_thumb_cache && ctx->cache_id > 0) {
-                int sf = 1;
-                if (ctx->target && GTK_IS_WIDGET(ctx->target)) sf = gtk_widget_get_scale_factor(GTK_WIDGET(ctx->target));
-                if (!thumb_pixbuf) thumb_pixbuf = create_thumb_pixbuf(pixbuf, sf);
+            if (is_mem_cache_enabled() && ctx->add_to_thumb_cache && ctx->cache_id > 0 &&
+                decoded_thumb(data, &pixbuf, &thumb_pixbuf, sf)) {
+                add_thumb_to_cache(ctx->cache_id, thumb_pixbuf);
+            }
+            // 磁盘缓存已在解码线程写入；缩略图加载不占用全尺寸内存缓存的预算
+        } else if (GTK_IS_PICTURE(ctx->target) && decoded_full(data, &pixbuf)) {
+            // 目标是GtkPicture（左侧预览）：全尺寸图片放入内存缓存，再次预览时无需解码
+            if (ctx->cache_id > 0 && is_mem_cache_enabled()) {
                 g_mutex_lock(&cache_mutex);
-                if (!thumb_cache) {
-                    thumb_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, 
-                                                       (GDestroyNotify)g_object_unref);
-                }
-                char *key = g_strdup_printf("%d", ctx->cache_id);
-                g_hash_table_replace(thumb_cache, key, g_object_ref(thumb_pixbuf ? thumb_pixbuf : pixbuf));
-                if (thumb_cache_order) {
-                    g_queue_push_tail(thumb_cache_order, g_strdup(key));
-                    evict_cache_if_needed(thumb_cache, thumb_cache_order, THUMB_CACHE_MAX_ENTRIES);
-                }
+                pixbuf_lru_insert(&fullsize_cache, ctx->cache_id, pixbuf);
                 g_mutex_unlock(&cache_mutex);
             }
-            
-            // 保存到磁盘缓存；全尺寸内存缓存仅在启用内存缓存时写入
-            if (ctx->cache_id > 0) {
-                if (is_mem_cache_enabled()) {
-                    g_mutex_lock(&cache_mutex);
-                    char *key = g_strdup_printf("%d", ctx->cache_id);
-                    if (!fullsize_cache) {
-                        fullsize_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, 
-                                                              (GDestroyNotify)g_object_unref);
-                    }
-                    g_hash_table_replace(fullsize_cache, g_strdup(key), g_object_ref(pixbuf));
-                    if (fullsize_cache_order) {
-                        g_queue_push_tail(fullsize_cache_order, g_strdup(key));
-                        evict_cache_if_needed(fullsize_cache, fullsize_cache_order, FULLSIZE_CACHE_MAX_ENTRIES);
-                    }
-                    g_mutex_unlock(&cache_mutex);
-                    g_free(key);
-                }
-                save_to_disk_cache(ctx->cache_id, pixbuf);
-            }
-        } else if (GTK_IS_PICTURE(ctx->target)) {
-            // 目标是GtkPicture（左侧预览）
             GdkTexture *tex = gdk_texture_new_for_pixbuf(pixbuf);
             if (tex) {
                 gtk_picture_set_paintable(GTK_PICTURE(ctx->target), GDK_PAINTABLE(tex));
@@ -433,17 +1091,17 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
                 ImageLoadCtx *waiting_ctx = (ImageLoadCtx*)g_ptr_array_index(waiting, i);
                 if (!waiting_ctx) continue;
 
-                // 只有在未取消且有有效pixbuf时才更新UI
-                if (!cancelled && pixbuf && waiting_ctx->target) {
+                // 只有在未取消且解码成功时才更新UI
+                if (!cancelled && decoded && waiting_ctx->target) {
                     // 额外的类型检查以确保对象仍然有效
-                    if (GTK_IS_WIDGET(waiting_ctx->target) && GTK_IS_DRAWING_AREA(waiting_ctx->target)) {
-                        GdkPixbuf *ui_pixbuf = pixbuf;
-                        if (waiting_ctx->scale_to_thumb) {
-                            int sf = gtk_widget_get_scale_factor(GTK_WIDGET(waiting_ctx->target));
-                            if (!thumb_pixbuf) thumb_pixbuf = create_thumb_pixbuf(pixbuf, sf);
-                            ui_pixbuf = thumb_pixbuf ? thumb_pixbuf : pixbuf;
-                        }
-
+                    GdkPixbuf *ui_pixbuf = NULL;
+                    if (GTK_IS_WIDGET(waiting_ctx->target) && GTK_IS_DRAWING_AREA(waiting_ctx->target) &&
+                        ctx_target_still_bound(waiting_ctx)) {
+                        int sf = gtk_widget_get_scale_factor(GTK_WIDGET(waiting_ctx->target));
+                        ui_pixbuf = waiting_ctx->scale_to_thumb ?
+                            decoded_thumb(data, &pixbuf, &thumb_pixbuf, sf) : decoded_full(data, &pixbuf);
+                    }
+                    if (ui_pixbuf) {
                         // 清空缓存的 surface（触发 destroy notify 如果有的话）
                         g_object_set_data_full(G_OBJECT(waiting_ctx->target), "cached_surface", NULL, NULL);
                         g_object_set_data_full(G_OBJECT(waiting_ctx->target), "cached_render", NULL, NULL);
@@ -454,7 +1112,8 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
                         if (waiting_ctx->stack && GTK_IS_WIDGET(waiting_ctx->stack) && GTK_IS_STACK(waiting_ctx->stack)) {
                             gtk_stack_set_visible_child_name(waiting_ctx->stack, "picture");
                         }
-                    } else if (GTK_IS_WIDGET(waiting_ctx->target) && GTK_IS_PICTURE(waiting_ctx->target)) {
+                    } else if (GTK_IS_WIDGET(waiting_ctx->target) && GTK_IS_PICTURE(waiting_ctx->target) &&
+                               decoded_full(data, &pixbuf)) {
                         GdkTexture *tex = gdk_texture_new_for_pixbuf(pixbuf);
                         if (tex) {
                             gtk_picture_set_paintable(GTK_PICTURE(waiting_ctx->target),
@@ -507,19 +1166,21 @@ static void decode_task_finished(GObject *source, GAsyncResult *res, gpointer us
     
     g_free(ctx->url);
     g_free(ctx);
+    g_free(data->content_type);
     g_free(data);
     
-    // 下载完成，处理队列中的下一个请求
+    // 下载完成，处理队列中的下一个请求（目标已销毁时使用最近一次处理队列的会话）
     g_mutex_lock(&download_queue_mutex);
     active_downloads--;
     g_mutex_unlock(&download_queue_mutex);
     
+    if (!session) session = download_session;
     if (session) {
         process_download_queue(session);
     }
 }
 
-// HTTP响应回调
+// HTTP响应回调：响应体已由 libsoup 异步读完，主循环不会阻塞在网络读取上
 static void image_response_cb(GObject *source, GAsyncResult *res, gpointer user_data) {
     SoupSession *session = SOUP_SESSION(source);
     ImageLoadCtx *ctx = (ImageLoadCtx*)user_data;
@@ -529,13 +1190,51 @@ static void image_response_cb(GObject *source, GAsyncResult *res, gpointer user_
         return;
     }
     
+    // 网络请求已结束，不再是进行中的下载（被中止的下载已在中止时移除）
+    g_mutex_lock(&cache_mutex);
+    if (in_flight_downloads && g_hash_table_lookup(in_flight_downloads, ctx->url) == ctx) {
+        g_hash_table_remove(in_flight_downloads, ctx->url);
+    }
+    g_mutex_unlock(&cache_mutex);
+    gboolean aborted = g_cancellable_is_cancelled(ctx->cancellable);
+    g_clear_object(&ctx->cancellable);
+    
     // 检查是否已取消（代次变化）
     gboolean cancelled = is_cancelled(ctx->cancel_generation);
     
     GError *err = NULL;
-    GInputStream *in = soup_session_send_finish(session, res, &err);
+    SoupMessage *msg = soup_session_get_async_result_message(session, res);
+    GBytes *image_data = soup_session_send_and_read_finish(session, res, &err);
+    if (aborted) {
+        // 被中止的下载：等待的上下文和 pending_downloads 条目已在中止时清理，
+        // 该URL可能已经重新发起下载，这里不能再访问它的条目
+        // 只有传输本身以 G_IO_ERROR_CANCELLED 结束才计数：与 aborted_downloads 对照，
+        // 可以确认中止确实打断了连接，而不是等到响应体读完才返回
+        if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_atomic_int_inc(&cancelled_transfers);
+        }
+        if (err) g_error_free(err);
+        if (image_data) g_bytes_unref(image_data);
+        free_load_ctx(ctx);
+        g_mutex_lock(&download_queue_mutex);
+        active_downloads--;
+        g_mutex_unlock(&download_queue_mutex);
+        process_download_queue(session);
+        return;
+    }
+    if (image_data) {
+        g_atomic_pointer_add(&async_bytes_read, g_bytes_get_size(image_data));
+    }
+    // 非 2xx 响应的内容（错误页）无法解码，按下载失败处理
+    if (image_data && msg && !SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(msg))) {
+        if (!cancelled) {
+            g_warning("图片下载失败 %s: HTTP %u", ctx->url ? ctx->url : "unknown", soup_message_get_status(msg));
+        }
+        g_bytes_unref(image_data);
+        image_data = NULL;
+    }
     
-    if (!in || cancelled) {
+    if (!image_data || cancelled) {
         if (err) {
             // 不记录取消的错误
             if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
@@ -543,10 +1242,7 @@ static void image_response_cb(GObject *source, GAsyncResult *res, gpointer user_
             }
             g_error_free(err);
         }
-        if (in) {
-            g_input_stream_close(in, NULL, NULL);
-            g_object_unref(in);
-        }
+        if (image_data) g_bytes_unref(image_data);
         
         // 从待处理下载中移除，并清理所有等待的上下文
         if (ctx->url) {
@@ -593,78 +1289,37 @@ static void image_response_cb(GObject *source, GAsyncResult *res, gpointer user_
         process_download_queue(session);
         return;
     }
-    
-    // 读取整个流到内存
-    GByteArray *ba = g_byte_array_new();
-    guint8 buf[8192];
-    gssize n;
-    while ((n = g_input_stream_read(in, buf, sizeof(buf), NULL, &err)) > 0) {
-        g_byte_array_append(ba, buf, (guint)n);
-    }
-    g_input_stream_close(in, NULL, NULL);
-    g_object_unref(in);
-    
-    if (err) {
-        g_error_free(err);
-        g_byte_array_free(ba, TRUE);
-        
-        // 从待处理下载中移除，并清理所有等待的上下文
-        if (ctx->url) {
-            g_mutex_lock(&cache_mutex);
-            if (pending_downloads) {
-                GPtrArray *waiting = (GPtrArray*)g_hash_table_lookup(pending_downloads, ctx->url);
-                if (waiting) {
-                    // 清理所有等待的上下文
-                    for (guint i = 0; i < waiting->len; i++) {
-                        ImageLoadCtx *waiting_ctx = (ImageLoadCtx*)g_ptr_array_index(waiting, i);
-                        if (waiting_ctx) {
-                            if (waiting_ctx->target) {
-                                g_object_remove_weak_pointer(G_OBJECT(waiting_ctx->target), 
-                                                            (gpointer*)&waiting_ctx->target);
-                            }
-                            if (waiting_ctx->stack) {
-                                g_object_remove_weak_pointer(G_OBJECT(waiting_ctx->stack), 
-                                                            (gpointer*)&waiting_ctx->stack);
-                            }
-                            g_free(waiting_ctx->url);
-                            g_free(waiting_ctx);
-                        }
-                    }
-                }
-                g_hash_table_remove(pending_downloads, ctx->url);
-            }
-            g_mutex_unlock(&cache_mutex);
-        }
-        if (ctx->target && G_IS_OBJECT(ctx->target)) {
-            g_object_remove_weak_pointer(G_OBJECT(ctx->target), (gpointer*)&ctx->target);
-        }
-        if (ctx->stack && G_IS_OBJECT(ctx->stack)) {
-            g_object_remove_weak_pointer(G_OBJECT(ctx->stack), (gpointer*)&ctx->stack);
-        }
-        g_free(ctx->url);
-        g_free(ctx);
-        
-        // 下载失败，减少计数并处理队列
-        g_mutex_lock(&download_queue_mutex);
-        active_downloads--;
-        g_mutex_unlock(&download_queue_mutex);
-        process_download_queue(session);
-        return;
-    }
-    
-    // 创建GBytes
-    GBytes *image_data = g_bytes_new_take(ba->data, ba->len);
-    g_byte_array_free(ba, FALSE);  // 不释放data，已交给GBytes
+    if (err) g_error_free(err);
     
     // 启动解码任务
     DecodeTaskData *data = g_new0(DecodeTaskData, 1);
     data->image_data = image_data;
     data->ctx = ctx;
     data->cancel_generation = ctx->cancel_generation;  // 继承上下文的取消代次
+    data->cache_id = ctx->cache_id;
+    // 按发起请求的目标和所有等待目标决定解码线程生成什么：只需要缩略图时不保留全尺寸图片
+    // （缩放倍率只能在主线程读取）
+    g_mutex_lock(&cache_mutex);
+    GPtrArray *waiting = pending_downloads ? (GPtrArray*)g_hash_table_lookup(pending_downloads, ctx->url) : NULL;
+    for (guint i = 0; i <= (waiting ? waiting->len : 0); i++) {
+        ImageLoadCtx *c = i == 0 ? ctx : (ImageLoadCtx*)g_ptr_array_index(waiting, i - 1);
+        if (!c->scale_to_thumb) {
+            data->keep_full = TRUE;
+        } else if (data->thumb_scale == 0) {
+            data->thumb_scale = (c->target && GTK_IS_WIDGET(c->target)) ?
+                MAX(gtk_widget_get_scale_factor(c->target), 1) : 1;
+        }
+    }
+    g_mutex_unlock(&cache_mutex);
+    if (msg) {
+        const char *content_type = soup_message_headers_get_content_type(
+            soup_message_get_response_headers(msg), NULL);
+        data->content_type = g_strdup(content_type);
+    }
     
     GTask *task = g_task_new(NULL, NULL, decode_task_finished, data);
     g_task_set_task_data(task, data, NULL);
-    g_task_run_in_thread(task, decode_task_thread);
+    image_loader_run_in_decode_pool(task, decode_task_thread);
     g_object_unref(task);
 }
 
@@ -701,20 +1356,39 @@ static void start_download(SoupSession *session, ImageLoadCtx *ctx) {
         return;
     }
     
-    // 发起HTTP请求（不使用GCancellable，让请求自然完成，回调中检查代次来决定是否处理结果）
-    soup_session_send_async(session, msg, G_PRIORITY_DEFAULT, NULL, image_response_cb, ctx);
-    g_object_unref(msg);  // soup_session_send_async 会内部增加引用
+    // 登记为进行中的下载：所有等待者都失效时通过 GCancellable 中止传输
+    ctx->cancellable = g_cancellable_new();
+    g_mutex_lock(&cache_mutex);
+    if (in_flight_downloads) g_hash_table_replace(in_flight_downloads, ctx->url, ctx);
+    g_mutex_unlock(&cache_mutex);
+
+    // 发起HTTP请求并异步读完整个响应体
+    soup_session_send_and_read_async(session, msg, G_PRIORITY_DEFAULT, ctx->cancellable, image_response_cb, ctx);
+    g_object_unref(msg);  // soup_session_send_and_read_async 会内部增加引用
 }
 
 // 处理下载队列
 static void process_download_queue(SoupSession *session) {
     if (!session) return;
+    if (session != download_session) {
+        if (download_session) {
+            g_object_remove_weak_pointer(G_OBJECT(download_session), (gpointer*)&download_session);
+        }
+        download_session = session;
+        g_object_add_weak_pointer(G_OBJECT(download_session), (gpointer*)&download_session);
+    }
     
     g_mutex_lock(&download_queue_mutex);
     
     // 启动尽可能多的下载（不超过最大并发数）
     while (active_downloads < MAX_CONCURRENT_DOWNLOADS) {
-        ImageLoadCtx *ctx = (ImageLoadCtx*)g_queue_pop_head(download_queue);
+        // 解码积压时暂停：先标记再复查，解码任务完成时会看到标记并重新处理队列
+        if (image_loader_decode_pool_busy()) {
+            g_atomic_int_set(&download_queue_stalled, 1);
+            if (image_loader_decode_pool_busy()) break;
+            g_atomic_int_set(&download_queue_stalled, 0);
+        }
+        ImageLoadCtx *ctx = download_queue_pop();
         if (!ctx) break;  // 队列为空
         
         // 检查目标是否仍然有效
@@ -759,8 +1433,11 @@ void load_image_async(SoupSession *session, const char *url, ImageLoadCtx *ctx)
     g_mutex_lock(&cache_mutex);
     GPtrArray *waiting = (GPtrArray*)g_hash_table_lookup(pending_downloads, url);
     if (waiting) {
-        // 已有下载进行中，加入等待队列
+        // 已有下载进行中或在排队，加入等待队列；排队中的下载按新请求的优先级提升
         g_ptr_array_add(waiting, ctx);
+        g_mutex_lock(&download_queue_mutex);
+        download_queue_upgrade(url, ctx->priority);
+        g_mutex_unlock(&download_queue_mutex);
         g_mutex_unlock(&cache_mutex);
         return;
     }
@@ -770,15 +1447,102 @@ void load_image_async(SoupSession *session, const char *url, ImageLoadCtx *ctx)
     g_hash_table_insert(pending_downloads, g_strdup(url), waiting);
     g_mutex_unlock(&cache_mutex);
     
-    // 加入下载队列或立即开始下载
+    // 按优先级加入下载队列；有空闲连接且解码没有积压时立即开始
     g_mutex_lock(&download_queue_mutex);
-    if (active_downloads < MAX_CONCURRENT_DOWNLOADS) {
-        active_downloads++;
-        g_mutex_unlock(&download_queue_mutex);
-        start_download(session, ctx);
-    } else {
-        // 队列已满，加入等待队列
-        g_queue_push_tail(download_queue, ctx);
-        g_mutex_unlock(&download_queue_mutex);
+    download_queue_push(ctx);
+    g_mutex_unlock(&download_queue_mutex);
+    process_download_queue(session);
+}
+
+static int ctx_priority(const ImageLoadCtx *ctx, ImageLoadPriorityFunc func, gpointer user_data) {
+    if (!ctx || !ctx->target || !ctx_target_still_bound(ctx)) return IMAGE_LOAD_PRIORITY_DROP;
+    return func ? func(ctx, user_data) : ctx->priority;
+}
+
+static gboolean ctx_still_wanted(const ImageLoadCtx *ctx, ImageLoadPriorityFunc func, gpointer user_data) {
+    return !is_cancelled(ctx->cancel_generation) && ctx_priority(ctx, func, user_data) < IMAGE_LOAD_PRIORITY_DROP;
+}
+
+// 找出发起请求的目标和所有等待目标都不再需要的下载：释放等待的上下文并移除 pending_downloads 条目，
+// 使之后的同URL请求重新发起下载。调用者需持有 cache_mutex；
+// 收集到的 GCancellable 要在释放锁之后再取消（取消可能同步触发回调）
+static void collect_abandoned_downloads(ImageLoadPriorityFunc func, gpointer user_data, GPtrArray *to_cancel) {
+    if (!in_flight_downloads) return;
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, in_flight_downloads);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        ImageLoadCtx *ctx = (ImageLoadCtx*)value;
+        GPtrArray *waiting = pending_downloads ? (GPtrArray*)g_hash_table_lookup(pending_downloads, ctx->url) : NULL;
+        gboolean wanted = ctx_still_wanted(ctx, func, user_data);
+        for (guint i = 0; !wanted && waiting && i < waiting->len; i++) {
+            wanted = ctx_still_wanted(g_ptr_array_index(waiting, i), func, user_data);
+        }
+        if (wanted) continue;
+
+        if (waiting) {
+            for (guint i = 0; i < waiting->len; i++) {
+                free_load_ctx((ImageLoadCtx*)g_ptr_array_index(waiting, i));
+            }
+            g_hash_table_remove(pending_downloads, ctx->url);
+        }
+        g_ptr_array_add(to_cancel, g_object_ref(ctx->cancellable));
+        g_hash_table_iter_remove(&iter);
+        aborted_downloads++;
     }
 }
+
+static void cancel_abandoned_downloads(GPtrArray *to_cancel) {
+    for (guint i = 0; i < to_cancel->len; i++) {
+        g_cancellable_cancel(G_CANCELLABLE(g_ptr_array_index(to_cancel, i)));
+    }
+    g_ptr_array_unref(to_cancel);
+}
+
+void image_loader_reprioritize(ImageLoadPriorityFunc func, gpointer user_data) {
+    // 锁顺序与 load_image_async 一致：cache_mutex -> download_queue_mutex
+    g_mutex_lock(&cache_mutex);
+    g_mutex_lock(&download_queue_mutex);
+    // 取出全部排队请求，重新计算优先级后放回（各队列内仍按排队时间排序）
+    GPtrArray *queued = g_ptr_array_sized_new(g_hash_table_size(queued_downloads));
+    for (int i = 0; i < DOWNLOAD_QUEUE_CLASSES; i++) {
+        ImageLoadCtx *ctx;
+        while ((ctx = (ImageLoadCtx*)g_queue_pop_head(&download_queues[i])) != NULL) {
+            g_ptr_array_add(queued, ctx);
+        }
+    }
+    g_hash_table_remove_all(queued_downloads);
+
+    for (guint q = 0; q < queued->len; q++) {
+        ImageLoadCtx *ctx = (ImageLoadCtx*)g_ptr_array_index(queued, q);
+        GPtrArray *waiting = (ctx->url && pending_downloads) ?
+            (GPtrArray*)g_hash_table_lookup(pending_downloads, ctx->url) : NULL;
+
+        // 同一URL的等待目标共用这次下载，取其中最高的优先级
+        int prio = ctx_priority(ctx, func, user_data);
+        for (guint i = 0; waiting && i < waiting->len; i++) {
+            prio = MIN(prio, ctx_priority(g_ptr_array_index(waiting, i), func, user_data));
+        }
+
+        if (prio >= IMAGE_LOAD_PRIORITY_DROP) {
+            // 没有任何目标还需要这张图：移出队列，之后重新绑定时会再次发起
+            if (waiting) {
+                for (guint i = 0; i < waiting->len; i++) {
+                    free_load_ctx((ImageLoadCtx*)g_ptr_array_index(waiting, i));
+                }
+                g_hash_table_remove(pending_downloads, ctx->url);
+            }
+            free_load_ctx(ctx);
+        } else {
+            ctx->priority = prio;
+            download_queue_insert(ctx);
+        }
+    }
+    g_ptr_array_unref(queued);
+    g_mutex_unlock(&download_queue_mutex);
+
+    GPtrArray *to_cancel = g_ptr_array_new_with_free_func(g_object_unref);
+    collect_abandoned_downloads(func, user_data, to_cancel);
+    g_mutex_unlock(&cache_mutex);
+    cancel_abandoned_downloads(to_cancel);
+}
@@ -4,6 +4,16 @@
 #include <gtk/gtk.h>
 #include <libsoup/soup.h>
 
+// 下载优先级（数值越小越先下载）
+typedef enum {
+    IMAGE_LOAD_PRIORITY_PREVIEW = 0,  // 左侧全尺寸预览（用户正在查看）
+    IMAGE_LOAD_PRIORITY_DECK_SLOT,    // 卡组槽位（导入卡组、拖放添加）
+    IMAGE_LOAD_PRIORITY_VISIBLE,      // 搜索结果中目标在视口内
+    IMAGE_LOAD_PRIORITY_PREFETCH,     // 目标在视口附近的预取范围内
+    IMAGE_LOAD_PRIORITY_BACKGROUND,   // 目标离视口较远
+    IMAGE_LOAD_PRIORITY_DROP          // 目标已不再需要该图片，排队中的下载可直接放弃
+} ImageLoadPriority;
+
 /**
  * 图片加载上下文结构
  * 包含加载图片所需的所有信息
@@ -17,8 +27,18 @@ typedef struct {
     char *url;                 // 正在加载的URL（网络）或file_path（本地）
     gboolean is_local_file;    // TRUE表示从本地文件加载，FALSE表示从网络加载
     guint64 cancel_generation; // 创建时的取消代次，用于检测是否应该取消
+    int priority;              // ImageLoadPriority，决定在下载队列中的位置
+    gint64 queued_at;          // 进入下载队列的时间（单调时钟，由加载器设置）
+    GCancellable *cancellable; // 发起请求后用于中止传输（由加载器设置）
 } ImageLoadCtx;
 
+/**
+ * 重新计算排队下载优先级的回调（在主线程调用）
+ * @param ctx 排队中的加载上下文（target 非 NULL）
+ * @return 新的 ImageLoadPriority
+ */
+typedef int (*ImageLoadPriorityFunc)(const ImageLoadCtx *ctx, gpointer user_data);
+
 /**
  * 初始化图片缓存系统
  * 必须在使用其他函数前调用
@@ -27,28 +47,63 @@ void init_image_cache(void);
 
 /**
  * 清理图片缓存系统
- * 释放所有缓存资源
+ * 在应用 shutdown 时调用：等待解码线程池排空，写回打包缓存索引，释放所有缓存资源
  */
 void cleanup_image_cache(void);
 
 /**
- * 从磁盘缓存加载图片
+ * 从磁盘缓存加载图片（按缓存的实际格式解码）
+ * 读取打包缓存 images.pack；旧版本的单文件缓存会在读取时迁入打包缓存
  * @param card_id 卡片ID
  * @return GdkPixbuf指针，调用者需要unref，失败返回NULL
  */
 GdkPixbuf* load_from_disk_cache(int card_id);
 
 /**
- * 保存图片到磁盘缓存
+ * 打包缓存 images.pack 中是否有该卡片的原图（只查索引，不读取也不解码）
  * @param card_id 卡片ID
- * @param pixbuf 要保存的图片
+ * @return TRUE如果有
  */
-void save_to_disk_cache(int card_id, GdkPixbuf *pixbuf);
+gboolean disk_cache_has_image(int card_id);
 
 /**
- * 从内存缓存获取缩略图
+ * 把下载的原始图片字节写入磁盘缓存（追加到打包缓存，可在工作线程调用）
  * @param card_id 卡片ID
- * @return GdkPixbuf指针，不需要unref，失败返回NULL
+ * @param bytes 图片原始字节（webp/jpg/png 等，按原格式保存）
+ * @param content_type 响应的 Content-Type，随条目记录；可为 NULL
+ */
+void save_bytes_to_disk_cache(int card_id, GBytes *bytes, const char *content_type);
+
+/**
+ * 只从磁盘缩略图缓存 thumbs.pack 加载缩略图（解码一张小 PNG，可在主线程调用）
+ * @param card_id 卡片ID
+ * @param scale_factor 控件的 HiDPI 缩放倍率
+ * @return GdkPixbuf指针，调用者需要unref；缩略图缓存中没有时返回NULL
+ */
+GdkPixbuf* load_thumb_from_thumb_pack(int card_id, int scale_factor);
+
+/**
+ * 从磁盘缓存加载缩略图（68x99 乘以 scale_factor）
+ * 缩略图由解码线程随原图一起生成；只有原图时会解码原图生成一次并写回缩略图缓存，
+ * 这种情况开销较大，界面代码应在解码线程池中调用
+ * @param card_id 卡片ID
+ * @param scale_factor 控件的 HiDPI 缩放倍率
+ * @return GdkPixbuf指针，调用者需要unref，失败返回NULL
+ */
+GdkPixbuf* load_thumb_from_disk_cache(int card_id, int scale_factor);
+
+/**
+ * 把缩略图写入磁盘缩略图缓存 thumbs.pack（可在工作线程调用）
+ * @param card_id 卡片ID
+ * @param scale_factor 缩略图对应的缩放倍率
+ * @param thumb 缩略图
+ */
+void save_thumb_to_disk_cache(int card_id, int scale_factor, GdkPixbuf *thumb);
+
+/**
+ * 从内存缓存获取缩略图（命中时标记为最近使用）
+ * @param card_id 卡片ID
+ * @return GdkPixbuf指针，由缓存持有，不需要unref，应立即使用或自行ref；失败返回NULL
  */
 GdkPixbuf* get_thumb_from_cache(int card_id);
 
@@ -66,6 +121,41 @@ void add_thumb_to_cache(int card_id, GdkPixbuf *pixbuf);
  */
 GdkPixbuf* get_fullsize_from_cache(int card_id);
 
+// 内存缓存统计
+typedef struct {
+    guint entries;
+    gsize bytes;      // 当前占用（像素数据 rowstride × height）
+    gsize budget;     // 字节预算
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+} ImageMemCacheStats;
+
+/**
+ * 获取缩略图/全尺寸内存缓存的统计数据
+ * @param thumb 输出缩略图缓存统计，可为 NULL
+ * @param fullsize 输出全尺寸缓存统计，可为 NULL
+ */
+void image_loader_get_mem_cache_stats(ImageMemCacheStats *thumb, ImageMemCacheStats *fullsize);
+
+// 磁盘缓存统计（命中率按本次运行的查找计算）
+typedef struct {
+    guint entries;
+    guint64 bytes;       // 打包文件大小（含尚未回收的失效数据）
+    guint64 budget;      // 字节上限，0 表示不限制
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+    double hit_ratio;    // hits / (hits + misses)，没有查找时为 0
+} ImageDiskCacheStats;
+
+/**
+ * 获取原图/缩略图磁盘缓存的统计数据
+ * @param images 输出原图缓存统计，可为 NULL
+ * @param thumbs 输出缩略图缓存统计，可为 NULL
+ */
+void image_loader_get_disk_cache_stats(ImageDiskCacheStats *images, ImageDiskCacheStats *thumbs);
+
 /**
  * 获取当前取消代次
  * @return 当前的取消代次号
@@ -81,18 +171,63 @@ gboolean is_cancelled(guint64 recorded_generation);
 
 /**
  * 取消所有待处理的图片加载
- * 用于搜索刷新时清理旧请求
+ * 用于搜索刷新时清理旧请求：排队中的下载直接移除，
+ * 进行中的下载若没有新请求在等待同一URL则中止网络传输
  */
 void cancel_all_pending(void);
 
 /**
  * 异步加载图片
+ * 超过并发上限或解码线程池积压时按 ctx->priority 排队，排队较久的低优先级请求会逐步提升；
+ * 同一URL正在排队时再次请求，排队中的下载会提升到两者中较高的优先级
  * @param session libsoup会话
  * @param url 图片URL
  * @param ctx 加载上下文（函数会接管所有权）
  */
 void load_image_async(SoupSession *session, const char *url, ImageLoadCtx *ctx);
 
+/**
+ * 重新排列尚未开始的下载（例如视口滚动后）
+ * 按回调给出的优先级重新归类；同一URL有多个等待目标时取其中最高的优先级。
+ * 所有目标都已销毁或为 IMAGE_LOAD_PRIORITY_DROP 的下载会被移出队列，
+ * 已经开始的此类下载会被中止。
+ * @param func 优先级回调
+ * @param user_data 传给回调的数据
+ */
+void image_loader_reprioritize(ImageLoadPriorityFunc func, gpointer user_data);
+
+/**
+ * 在图片解码线程池中执行 GTask 的线程函数（代替 g_task_run_in_thread）
+ * 线程池线程数等于 CPU 核心数；未初始化时退回 g_task_run_in_thread
+ */
+void image_loader_run_in_decode_pool(GTask *task, GTaskThreadFunc func);
+
+/**
+ * 解码线程池是否积压（排队与执行中的任务达到上限）
+ * 批量发起图片加载的调用者应在积压时暂停，等下一轮再继续
+ */
+gboolean image_loader_decode_pool_busy(void);
+
+// 解码线程池统计
+typedef struct {
+    guint threads;
+    guint backlog;        // 当前排队与执行中的任务数
+    guint backlog_limit;  // 达到该值时暂停发起新的下载
+    guint peak_backlog;
+    guint64 completed;
+    double avg_wait_ms;   // 平均排队时间
+    double avg_decode_ms; // 平均执行时间
+    double max_decode_ms;
+} ImageDecodePoolStats;
+
+void image_loader_get_decode_pool_stats(ImageDecodePoolStats *out);
+
+/**
+ * 获取累计异步读取的图片响应体字节数
+ * 响应体由 libsoup 异步读取，主循环不会阻塞在网络读取上
+ */
+gsize image_loader_get_async_bytes_read(void);
+
 /**
  * 获取缓存目录路径
  * @return 缓存目录的完整路径，不要释放
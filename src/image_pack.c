@@ -0,0 +1,856 @@
+#include "image_pack.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// <name>.pack 文件格式（本机字节序，记录按 8 字节对齐）：
+//   [PackHeader，填充到 32 字节]
+//   [PackRecordHeader + 数据 + 对齐填充] × N（tag 为 PACK_TAG_TOMBSTONE、长度为 0 的记录表示删除）
+// <name>.idx 文件格式：
+//   [IndexHeader，填充到 48 字节]
+//   [ImagePackEntry × count，按 key 升序，只包含有效条目，附带最近访问时间与访问次数]
+// 两个文件通过 generation 对应；索引只覆盖数据文件前 pack_size 字节，其后的记录在打开时扫描补回。
+#define PACK_MAGIC "YGOIPACK"
+#define INDEX_MAGIC "YGOIPIDX"
+#define PACK_VERSION 1
+#define INDEX_VERSION 2
+#define PACK_BYTE_ORDER 0x01020304u
+#define PACK_HEADER_SIZE 32
+#define INDEX_HEADER_SIZE 48
+#define PACK_RECORD_MAGIC 0x52504749u
+#define PACK_TAG_TOMBSTONE G_MAXUINT32
+
+// 失效数据超过该值且超过有效数据的一半时，image_pack_trim 顺便压缩
+#define PACK_COMPACT_MIN_DEAD_BYTES (16 * 1024 * 1024)
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint64 generation;
+} PackHeader;
+
+typedef struct {
+    guint32 magic;
+    guint32 tag;
+    guint64 key;
+    guint32 length;
+    guint32 reserved;
+} PackRecordHeader;
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint64 generation;
+    guint64 pack_size;
+    guint32 count;
+    guint32 reserved;
+} IndexHeader;
+
+typedef struct {
+    guint64 key;
+    guint64 offset;   // 数据（记录头之后）在 .pack 中的偏移
+    guint32 length;
+    guint32 tag;
+    guint32 atime;    // 最近一次读取或写入的时间（Unix 秒）
+    guint32 uses;     // 累计读取次数
+} ImagePackEntry;
+
+// 索引条目只读映射，本次打开后的访问记录先保存在内存中，写回索引时合并
+typedef struct {
+    guint64 key;
+    guint32 atime;
+    guint32 uses;
+} PackAccess;
+
+// 数据文件的只读句柄：查找在锁内取得引用，锁外 pread，压缩替换文件后旧句柄仍可读完
+typedef struct {
+    gint ref_count;
+    int fd;
+} PackReader;
+
+G_STATIC_ASSERT(sizeof(PackHeader) <= PACK_HEADER_SIZE);
+G_STATIC_ASSERT(sizeof(IndexHeader) <= INDEX_HEADER_SIZE);
+G_STATIC_ASSERT(sizeof(PackRecordHeader) == 24);
+G_STATIC_ASSERT(sizeof(ImagePackEntry) == 32);
+
+struct ImagePack {
+    char *pack_path;
+    char *index_path;
+    GMutex lock;               // 保护以下全部字段以及文件读写位置
+    GFileIOStream *io;
+    PackReader *reader;        // 当前数据文件的只读句柄
+    guint64 generation;
+    guint64 end;               // 下一条记录的写入位置
+    GMappedFile *index_map;
+    const ImagePackEntry *index_entries;
+    guint index_count;
+    GHashTable *overlay;       // 索引之后写入的条目：&entry->key -> ImagePackEntry*
+    GHashTable *touched;       // 本次打开后读取过的索引条目：&access->key -> PackAccess*
+    guint live_count;
+    guint64 live_bytes;
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+    gboolean compacting;       // 正在压缩（复制数据期间不持有 lock）
+    gboolean flushing;         // 正在写回索引（写文件期间不持有 lock）
+    gint abort_compact;        // 原子标记：image_pack_abort_compaction 要求放弃进行中的压缩
+};
+
+static guint64 align8(guint64 v) {
+    return (v + 7) & ~(guint64)7;
+}
+
+static guint64 new_generation(void) {
+    return ((guint64)g_random_int() << 32) ^ (guint64)g_get_real_time();
+}
+
+static gboolean entry_is_live(const ImagePackEntry *e) {
+    return e && e->tag != PACK_TAG_TOMBSTONE;
+}
+
+static guint32 pack_now(void) {
+    return (guint32)(g_get_real_time() / G_USEC_PER_SEC);
+}
+
+// 一条记录在数据文件中占用的字节数（含记录头与对齐填充）
+static guint64 record_footprint(guint32 length) {
+    return align8(sizeof(PackRecordHeader) + length);
+}
+
+// ===== 只读句柄 =====
+
+static PackReader* reader_open(const char *path) {
+    int fd = g_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        g_warning("无法打开图片缓存文件 %s: %s", path, g_strerror(errno));
+        return NULL;
+    }
+    PackReader *reader = g_new(PackReader, 1);
+    reader->ref_count = 1;
+    reader->fd = fd;
+    return reader;
+}
+
+static PackReader* reader_ref(PackReader *reader) {
+    if (reader) g_atomic_int_inc(&reader->ref_count);
+    return reader;
+}
+
+static void reader_unref(PackReader *reader) {
+    if (!reader || !g_atomic_int_dec_and_test(&reader->ref_count)) return;
+    g_close(reader->fd, NULL);
+    g_free(reader);
+}
+
+// 按偏移读取，不改变文件位置，可与写入和其他读取并发（不需要 lock）
+static gboolean reader_pread(PackReader *reader, guint64 offset, void *buf, gsize len) {
+    guint8 *p = buf;
+    while (len > 0) {
+        ssize_t n = pread(reader->fd, p, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return FALSE;
+        p += n;
+        offset += (guint64)n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+// ===== 文件读写（调用者需持有 lock）=====
+
+static gboolean pack_read_at(ImagePack *pack, guint64 offset, void *buf, gsize len) {
+    if (!g_seekable_seek(G_SEEKABLE(pack->io), (goffset)offset, G_SEEK_SET, NULL, NULL)) return FALSE;
+    gsize n = 0;
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(pack->io));
+    return g_input_stream_read_all(in, buf, len, &n, NULL, NULL) && n == len;
+}
+
+// 从独立的输入流读取（压缩复制数据时使用，不需要 lock）
+static gboolean stream_read_at(GInputStream *in, guint64 offset, void *buf, gsize len) {
+    if (!g_seekable_seek(G_SEEKABLE(in), (goffset)offset, G_SEEK_SET, NULL, NULL)) return FALSE;
+    gsize n = 0;
+    return g_input_stream_read_all(in, buf, len, &n, NULL, NULL) && n == len;
+}
+
+static gboolean stream_write_record(GOutputStream *out, const PackRecordHeader *rec, const void *data) {
+    static const guint8 zeros[8] = { 0 };
+    gsize pad = (gsize)(align8(sizeof(*rec) + rec->length) - (sizeof(*rec) + rec->length));
+    return g_output_stream_write_all(out, rec, sizeof(*rec), NULL, NULL, NULL) &&
+           (rec->length == 0 || g_output_stream_write_all(out, data, rec->length, NULL, NULL, NULL)) &&
+           (pad == 0 || g_output_stream_write_all(out, zeros, pad, NULL, NULL, NULL));
+}
+
+static gboolean pack_append_record(ImagePack *pack, const PackRecordHeader *rec, const void *data) {
+    if (!g_seekable_seek(G_SEEKABLE(pack->io), (goffset)pack->end, G_SEEK_SET, NULL, NULL)) return FALSE;
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(pack->io));
+    if (!stream_write_record(out, rec, data)) return FALSE;
+    pack->end = align8(pack->end + sizeof(*rec) + rec->length);
+    return TRUE;
+}
+
+// ===== 条目查找 =====
+
+static int compare_entry_key(const void *a, const void *b) {
+    guint64 x = ((const ImagePackEntry *)a)->key;
+    guint64 y = ((const ImagePackEntry *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static const ImagePackEntry* index_find(const ImagePack *pack, guint64 key) {
+    if (!pack->index_entries) return NULL;
+    ImagePackEntry probe = { key, 0, 0, 0, 0, 0 };
+    return bsearch(&probe, pack->index_entries, pack->index_count, sizeof(ImagePackEntry), compare_entry_key);
+}
+
+static const ImagePackEntry* pack_find(const ImagePack *pack, guint64 key) {
+    const ImagePackEntry *e = g_hash_table_lookup(pack->overlay, &key);
+    return e ? e : index_find(pack, key);
+}
+
+static void overlay_put(ImagePack *pack, guint64 key, guint64 offset, guint32 length, guint32 tag, guint32 atime) {
+    const ImagePackEntry *old = pack_find(pack, key);
+    if (entry_is_live(old)) {
+        pack->live_count--;
+        pack->live_bytes -= old->length;
+    }
+    g_hash_table_remove(pack->touched, &key);
+    ImagePackEntry *e = g_new(ImagePackEntry, 1);
+    e->key = key;
+    e->offset = offset;
+    e->length = length;
+    e->tag = tag;
+    e->atime = atime;
+    e->uses = 0;
+    // replace 使哈希表的键指向新条目内的 key
+    g_hash_table_replace(pack->overlay, &e->key, e);
+    if (entry_is_live(e)) {
+        pack->live_count++;
+        pack->live_bytes += length;
+    }
+}
+
+// 记录一次读取：新增条目直接修改，索引条目记入 touched
+static void pack_note_access(ImagePack *pack, const ImagePackEntry *e) {
+    guint32 now = pack_now();
+    ImagePackEntry *added = g_hash_table_lookup(pack->overlay, &e->key);
+    if (added) {
+        added->atime = now;
+        if (added->uses < G_MAXUINT32) added->uses++;
+        return;
+    }
+    PackAccess *access = g_hash_table_lookup(pack->touched, &e->key);
+    if (!access) {
+        access = g_new(PackAccess, 1);
+        access->key = e->key;
+        access->uses = e->uses;
+        g_hash_table_insert(pack->touched, &access->key, access);
+    }
+    access->atime = now;
+    if (access->uses < G_MAXUINT32) access->uses++;
+}
+
+// 合并索引与新增条目（以及访问记录），得到按 key 排序的全部有效条目
+static GArray* pack_collect_live(const ImagePack *pack) {
+    GArray *entries = g_array_sized_new(FALSE, FALSE, sizeof(ImagePackEntry), pack->live_count);
+    for (guint i = 0; i < pack->index_count; i++) {
+        ImagePackEntry e = pack->index_entries[i];
+        if (g_hash_table_contains(pack->overlay, &e.key)) continue;
+        const PackAccess *access = g_hash_table_lookup(pack->touched, &e.key);
+        if (access) {
+            e.atime = access->atime;
+            e.uses = access->uses;
+        }
+        g_array_append_val(entries, e);
+    }
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, pack->overlay);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        const ImagePackEntry *e = (const ImagePackEntry *)value;
+        if (entry_is_live(e)) g_array_append_val(entries, *e);
+    }
+    g_array_sort(entries, (GCompareFunc)compare_entry_key);
+    return entries;
+}
+
+// ===== 索引文件 =====
+
+static gboolean index_write(const char *path, guint64 generation, guint64 pack_size, GArray *entries) {
+    gsize size = INDEX_HEADER_SIZE + (gsize)entries->len * sizeof(ImagePackEntry);
+    guint8 *buf = g_malloc0(size);
+    IndexHeader *h = (IndexHeader *)buf;
+    memcpy(h->magic, INDEX_MAGIC, sizeof(h->magic));
+    h->version = INDEX_VERSION;
+    h->byte_order = PACK_BYTE_ORDER;
+    h->generation = generation;
+    h->pack_size = pack_size;
+    h->count = entries->len;
+    if (entries->len > 0) {
+        memcpy(buf + INDEX_HEADER_SIZE, entries->data, (gsize)entries->len * sizeof(ImagePackEntry));
+    }
+    GError *err = NULL;
+    gboolean ok = g_file_set_contents(path, (const gchar *)buf, (gssize)size, &err);
+    if (!ok) {
+        g_warning("写入图片缓存索引失败 %s: %s", path, err->message);
+        g_error_free(err);
+    }
+    g_free(buf);
+    return ok;
+}
+
+static void index_unmap(ImagePack *pack) {
+    if (pack->index_map) g_mapped_file_unref(pack->index_map);
+    pack->index_map = NULL;
+    pack->index_entries = NULL;
+    pack->index_count = 0;
+}
+
+// 映射索引文件；与数据文件不对应时返回 FALSE
+static gboolean index_map_load(ImagePack *pack, guint64 pack_file_size, guint64 *indexed_size) {
+    GMappedFile *map = g_mapped_file_new(pack->index_path, FALSE, NULL);
+    if (!map) return FALSE;
+    gsize len = g_mapped_file_get_length(map);
+    const char *contents = g_mapped_file_get_contents(map);
+    const IndexHeader *h = (const IndexHeader *)contents;
+    if (len < INDEX_HEADER_SIZE || memcmp(h->magic, INDEX_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != INDEX_VERSION || h->byte_order != PACK_BYTE_ORDER ||
+        h->generation != pack->generation || h->pack_size > pack_file_size ||
+        len != INDEX_HEADER_SIZE + (gsize)h->count * sizeof(ImagePackEntry)) {
+        g_mapped_file_unref(map);
+        return FALSE;
+    }
+    pack->index_map = map;
+    pack->index_entries = (const ImagePackEntry *)(contents + INDEX_HEADER_SIZE);
+    pack->index_count = h->count;
+    *indexed_size = h->pack_size;
+    return TRUE;
+}
+
+// ===== 打开 =====
+
+static gboolean pack_create(ImagePack *pack) {
+    // 先删除旧文件：替换已存在的文件时 GIO 会先写临时文件，只读句柄将指向旧文件
+    g_unlink(pack->pack_path);
+    GFile *file = g_file_new_for_path(pack->pack_path);
+    GError *err = NULL;
+    pack->io = g_file_replace_readwrite(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &err);
+    g_object_unref(file);
+    if (!pack->io) {
+        g_warning("无法创建图片缓存文件 %s: %s", pack->pack_path, err->message);
+        g_error_free(err);
+        return FALSE;
+    }
+    guint8 buf[PACK_HEADER_SIZE] = { 0 };
+    PackHeader *h = (PackHeader *)buf;
+    memcpy(h->magic, PACK_MAGIC, sizeof(h->magic));
+    h->version = PACK_VERSION;
+    h->byte_order = PACK_BYTE_ORDER;
+    h->generation = new_generation();
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(pack->io));
+    if (!g_output_stream_write_all(out, buf, sizeof(buf), NULL, NULL, NULL)) {
+        g_clear_object(&pack->io);
+        return FALSE;
+    }
+    pack->generation = h->generation;
+    pack->end = PACK_HEADER_SIZE;
+    pack->reader = reader_open(pack->pack_path);
+    return pack->reader != NULL;
+}
+
+static void pack_reset_state(ImagePack *pack) {
+    index_unmap(pack);
+    // 查找中的线程持有各自的引用，读完后才真正关闭
+    reader_unref(pack->reader);
+    pack->reader = NULL;
+    if (pack->io) {
+        g_io_stream_close(G_IO_STREAM(pack->io), NULL, NULL);
+        g_clear_object(&pack->io);
+    }
+    g_hash_table_remove_all(pack->overlay);
+    g_hash_table_remove_all(pack->touched);
+    pack->live_count = 0;
+    pack->live_bytes = 0;
+    pack->end = 0;
+}
+
+static gboolean pack_load(ImagePack *pack) {
+    GFile *file = g_file_new_for_path(pack->pack_path);
+    pack->io = g_file_open_readwrite(file, NULL, NULL);
+    g_object_unref(file);
+
+    PackHeader h;
+    if (!pack->io || !pack_read_at(pack, 0, &h, sizeof(h)) ||
+        memcmp(h.magic, PACK_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != PACK_VERSION || h.byte_order != PACK_BYTE_ORDER) {
+        // 文件不存在或格式不符：重新创建（旧索引随 generation 变化自然失效）
+        if (pack->io) {
+            g_io_stream_close(G_IO_STREAM(pack->io), NULL, NULL);
+            g_clear_object(&pack->io);
+        }
+        return pack_create(pack);
+    }
+    pack->generation = h.generation;
+
+    if (!g_seekable_seek(G_SEEKABLE(pack->io), 0, G_SEEK_END, NULL, NULL)) return FALSE;
+    guint64 file_size = (guint64)g_seekable_tell(G_SEEKABLE(pack->io));
+
+    guint64 offset = PACK_HEADER_SIZE;
+    if (index_map_load(pack, file_size, &offset)) {
+        for (guint i = 0; i < pack->index_count; i++) {
+            pack->live_count++;
+            pack->live_bytes += pack->index_entries[i].length;
+        }
+    }
+
+    // 补回索引之后追加的记录（访问时间按打开时间计）
+    guint32 now = pack_now();
+    guint recovered = 0;
+    while (offset + sizeof(PackRecordHeader) <= file_size) {
+        PackRecordHeader rec;
+        if (!pack_read_at(pack, offset, &rec, sizeof(rec)) || rec.magic != PACK_RECORD_MAGIC ||
+            offset + sizeof(rec) + rec.length > file_size) {
+            break;
+        }
+        overlay_put(pack, rec.key, offset + sizeof(rec), rec.length, rec.tag, now);
+        offset = align8(offset + sizeof(rec) + rec.length);
+        recovered++;
+    }
+    if (offset < file_size) {
+        // 丢弃未写完的尾部记录
+        g_seekable_truncate(G_SEEKABLE(pack->io), (goffset)offset, NULL, NULL);
+    }
+    // 写入位置保持 8 字节对齐（即使最后一条记录的填充没有写完）
+    pack->end = offset;
+    if (recovered > 0) {
+        g_message("Image pack %s: recovered %u records after the index", pack->pack_path, recovered);
+    }
+    pack->reader = reader_open(pack->pack_path);
+    return pack->reader != NULL;
+}
+
+ImagePack* image_pack_open(const char *dir, const char *name) {
+    if (!dir || !name) return NULL;
+    ImagePack *pack = g_new0(ImagePack, 1);
+    char *base = g_build_filename(dir, name, NULL);
+    pack->pack_path = g_strconcat(base, ".pack", NULL);
+    pack->index_path = g_strconcat(base, ".idx", NULL);
+    g_free(base);
+    g_mutex_init(&pack->lock);
+    pack->overlay = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+    pack->touched = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+
+    if (!pack_load(pack)) {
+        pack_reset_state(pack);
+        g_hash_table_destroy(pack->overlay);
+        g_hash_table_destroy(pack->touched);
+        g_mutex_clear(&pack->lock);
+        g_free(pack->pack_path);
+        g_free(pack->index_path);
+        g_free(pack);
+        return NULL;
+    }
+    return pack;
+}
+
+// ===== 读写 =====
+
+GBytes* image_pack_lookup(ImagePack *pack, guint64 key, guint32 *tag_out) {
+    if (!pack) return NULL;
+    // 锁内只确定位置并取得文件句柄的引用，数据在锁外读取，不与写入、索引写回排队
+    g_mutex_lock(&pack->lock);
+    const ImagePackEntry *e = pack_find(pack, key);
+    PackReader *reader = NULL;
+    guint64 offset = 0;
+    guint32 length = 0;
+    guint32 tag = 0;
+    if (entry_is_live(e) && e->length > 0 && pack->reader) {
+        reader = reader_ref(pack->reader);
+        offset = e->offset;
+        length = e->length;
+        tag = e->tag;
+        pack_note_access(pack, e);
+        pack->hits++;
+    } else {
+        pack->misses++;
+    }
+    g_mutex_unlock(&pack->lock);
+    if (!reader) return NULL;
+
+    guint8 *buf = g_malloc(length);
+    gboolean ok = reader_pread(reader, offset, buf, length);
+    reader_unref(reader);
+    if (!ok) {
+        g_free(buf);
+        g_mutex_lock(&pack->lock);
+        pack->hits--;
+        pack->misses++;
+        g_mutex_unlock(&pack->lock);
+        return NULL;
+    }
+    if (tag_out) *tag_out = tag;
+    return g_bytes_new_take(buf, length);
+}
+
+gboolean image_pack_contains(ImagePack *pack, guint64 key) {
+    if (!pack) return FALSE;
+    g_mutex_lock(&pack->lock);
+    gboolean found = entry_is_live(pack_find(pack, key));
+    g_mutex_unlock(&pack->lock);
+    return found;
+}
+
+gboolean image_pack_store(ImagePack *pack, guint64 key, const void *data, gsize size, guint32 tag) {
+    if (!pack || !data || size == 0 || size > G_MAXUINT32 || tag == PACK_TAG_TOMBSTONE) return FALSE;
+    PackRecordHeader rec = { PACK_RECORD_MAGIC, tag, key, (guint32)size, 0 };
+    g_mutex_lock(&pack->lock);
+    guint64 offset = pack->end;
+    gboolean ok = pack_append_record(pack, &rec, data);
+    if (ok) overlay_put(pack, key, offset + sizeof(rec), (guint32)size, tag, pack_now());
+    g_mutex_unlock(&pack->lock);
+    return ok;
+}
+
+gboolean image_pack_remove(ImagePack *pack, guint64 key) {
+    if (!pack) return FALSE;
+    g_mutex_lock(&pack->lock);
+    gboolean ok = FALSE;
+    if (entry_is_live(pack_find(pack, key))) {
+        PackRecordHeader rec = { PACK_RECORD_MAGIC, PACK_TAG_TOMBSTONE, key, 0, 0 };
+        ok = pack_append_record(pack, &rec, NULL);
+        if (ok) overlay_put(pack, key, 0, 0, PACK_TAG_TOMBSTONE, 0);
+    }
+    g_mutex_unlock(&pack->lock);
+    return ok;
+}
+
+// ===== 索引写回与压缩 =====
+
+// 写回索引分三步，写文件期间不持有 lock，查找与写入照常进行：
+// 1. 持锁合并出全部有效条目（含访问记录）与当前文件末尾；
+// 2. 不持锁写入新索引文件（原子替换，旧映射在解除前仍然有效）；
+// 3. 重新持锁映射新索引，丢弃已进入索引的新增条目与访问记录，保留期间新写入的部分。
+static gboolean pack_flush_index(ImagePack *pack) {
+    g_mutex_lock(&pack->lock);
+    // 压缩或另一次写回进行中：由它们写入索引
+    if (!pack->io || pack->flushing || pack->compacting) {
+        g_mutex_unlock(&pack->lock);
+        return FALSE;
+    }
+    if (g_hash_table_size(pack->overlay) == 0 && g_hash_table_size(pack->touched) == 0) {
+        g_mutex_unlock(&pack->lock);
+        return TRUE;
+    }
+    pack->flushing = TRUE;
+    GArray *entries = pack_collect_live(pack);
+    guint64 generation = pack->generation;
+    guint64 pack_size = pack->end;
+    g_mutex_unlock(&pack->lock);
+
+    gboolean ok = index_write(pack->index_path, generation, pack_size, entries);
+    g_array_unref(entries);
+
+    g_mutex_lock(&pack->lock);
+    if (ok) {
+        GMappedFile *old_map = pack->index_map;
+        const ImagePackEntry *old_entries = pack->index_entries;
+        guint old_count = pack->index_count;
+        pack->index_map = NULL;
+        pack->index_entries = NULL;
+        pack->index_count = 0;
+        guint64 indexed = 0;
+        if (index_map_load(pack, pack->end, &indexed)) {
+            if (old_map) g_mapped_file_unref(old_map);
+            // 仍与写入索引时一致的新增条目已经进入索引；期间覆盖写入的条目和删除记录保留在内存中
+            GHashTableIter iter;
+            gpointer value;
+            g_hash_table_iter_init(&iter, pack->overlay);
+            while (g_hash_table_iter_next(&iter, NULL, &value)) {
+                const ImagePackEntry *e = (const ImagePackEntry *)value;
+                const ImagePackEntry *indexed_entry = index_find(pack, e->key);
+                if (entry_is_live(e) ? (indexed_entry && indexed_entry->offset == e->offset) : !indexed_entry) {
+                    g_hash_table_iter_remove(&iter);
+                }
+            }
+            g_hash_table_iter_init(&iter, pack->touched);
+            while (g_hash_table_iter_next(&iter, NULL, &value)) {
+                const PackAccess *access = (const PackAccess *)value;
+                const ImagePackEntry *indexed_entry = index_find(pack, access->key);
+                if (!indexed_entry || (indexed_entry->atime == access->atime && indexed_entry->uses == access->uses)) {
+                    g_hash_table_iter_remove(&iter);
+                }
+            }
+        } else {
+            // 旧映射仍然有效，新增条目与访问记录保留在内存中
+            g_warning("图片缓存索引无法重新映射: %s", pack->index_path);
+            pack->index_map = old_map;
+            pack->index_entries = old_entries;
+            pack->index_count = old_count;
+            ok = FALSE;
+        }
+    }
+    pack->flushing = FALSE;
+    g_mutex_unlock(&pack->lock);
+    return ok;
+}
+
+// 压缩分三步，复制数据期间不持有 lock，查找与写入照常进行：
+// 1. 持锁取得有效条目快照与当前文件末尾（快照覆盖的区域之后不会再被修改）；
+// 2. 不持锁用独立的文件句柄按快照把数据复制到临时文件；
+// 3. 重新持锁，追加复制期间写入的条目并替换数据文件，全部条目暂存在内存中；
+// 之后再按 pack_flush_index 的方式在锁外写入新索引（含最新的访问时间与次数）。
+static gboolean pack_compact(ImagePack *pack) {
+    gint64 start_us = g_get_monotonic_time();
+
+    g_mutex_lock(&pack->lock);
+    if (!pack->io || pack->compacting || pack->flushing) {
+        g_mutex_unlock(&pack->lock);
+        return FALSE;
+    }
+    pack->compacting = TRUE;
+    g_atomic_int_set(&pack->abort_compact, 0);
+    guint64 old_size = pack->end;
+    GArray *snapshot = pack_collect_live(pack);
+    g_mutex_unlock(&pack->lock);
+
+    GArray *new_offsets = g_array_sized_new(FALSE, FALSE, sizeof(guint64), snapshot->len);
+    char *tmp_path = g_strconcat(pack->pack_path, ".tmp", NULL);
+    GFile *tmp_file = g_file_new_for_path(tmp_path);
+    GFileOutputStream *fout = g_file_replace(tmp_file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL);
+    GFile *src_file = g_file_new_for_path(pack->pack_path);
+    GFileInputStream *src = g_file_read(src_file, NULL, NULL);
+    g_object_unref(src_file);
+    GOutputStream *out = fout ? G_OUTPUT_STREAM(fout) : NULL;
+    gboolean ok = fout != NULL && src != NULL;
+    guint64 generation = new_generation();
+    guint64 offset = PACK_HEADER_SIZE;
+    guint8 *buf = NULL;
+    gsize buf_size = 0;
+
+    if (ok) {
+        guint8 hbuf[PACK_HEADER_SIZE] = { 0 };
+        PackHeader *h = (PackHeader *)hbuf;
+        memcpy(h->magic, PACK_MAGIC, sizeof(h->magic));
+        h->version = PACK_VERSION;
+        h->byte_order = PACK_BYTE_ORDER;
+        h->generation = generation;
+        ok = g_output_stream_write_all(out, hbuf, sizeof(hbuf), NULL, NULL, NULL);
+    }
+    for (guint i = 0; ok && i < snapshot->len; i++) {
+        // 应用退出时放弃压缩，原文件保持不变
+        if (g_atomic_int_get(&pack->abort_compact)) {
+            ok = FALSE;
+            break;
+        }
+        const ImagePackEntry *e = &g_array_index(snapshot, ImagePackEntry, i);
+        if (e->length > buf_size) {
+            buf_size = e->length;
+            buf = g_realloc(buf, buf_size);
+        }
+        PackRecordHeader rec = { PACK_RECORD_MAGIC, e->tag, e->key, e->length, 0 };
+        ok = stream_read_at(G_INPUT_STREAM(src), e->offset, buf, e->length) && stream_write_record(out, &rec, buf);
+        guint64 data_offset = offset + sizeof(rec);
+        g_array_append_val(new_offsets, data_offset);
+        offset = align8(offset + sizeof(rec) + e->length);
+    }
+    if (src) g_object_unref(src);
+
+    g_mutex_lock(&pack->lock);
+    GArray *entries = NULL;
+    if (ok) {
+        // 以当前的有效条目为准：仍指向快照位置的条目改用复制后的偏移，
+        // 复制期间新写入（或被覆盖）的条目从原文件补写到临时文件末尾，期间删除的条目不再出现
+        GHashTable *copied = g_hash_table_new(g_int64_hash, g_int64_equal); // &key -> 快照下标 + 1
+        for (guint i = 0; i < snapshot->len; i++) {
+            ImagePackEntry *e = &g_array_index(snapshot, ImagePackEntry, i);
+            g_hash_table_insert(copied, &e->key, GUINT_TO_POINTER(i + 1));
+        }
+        entries = pack_collect_live(pack);
+        guint appended = 0;
+        for (guint i = 0; ok && i < entries->len; i++) {
+            ImagePackEntry *e = &g_array_index(entries, ImagePackEntry, i);
+            guint idx = GPOINTER_TO_UINT(g_hash_table_lookup(copied, &e->key));
+            if (idx > 0 && g_array_index(snapshot, ImagePackEntry, idx - 1).offset == e->offset) {
+                e->offset = g_array_index(new_offsets, guint64, idx - 1);
+                continue;
+            }
+            if (e->length > buf_size) {
+                buf_size = e->length;
+                buf = g_realloc(buf, buf_size);
+            }
+            PackRecordHeader rec = { PACK_RECORD_MAGIC, e->tag, e->key, e->length, 0 };
+            ok = pack_read_at(pack, e->offset, buf, e->length) && stream_write_record(out, &rec, buf);
+            e->offset = offset + sizeof(rec);
+            offset = align8(offset + sizeof(rec) + e->length);
+            appended++;
+        }
+        g_hash_table_destroy(copied);
+        if (appended > 0) {
+            g_message("Image pack %s: %u records written during compaction", pack->pack_path, appended);
+        }
+    }
+    g_free(buf);
+    if (out) {
+        ok = g_output_stream_close(out, NULL, NULL) && ok;
+        g_object_unref(fout);
+    }
+    g_array_unref(snapshot);
+    g_array_unref(new_offsets);
+
+    if (!ok) {
+        g_warning("图片缓存压缩失败: %s", pack->pack_path);
+        g_file_delete(tmp_file, NULL, NULL);
+        pack->compacting = FALSE;
+        g_mutex_unlock(&pack->lock);
+        g_object_unref(tmp_file);
+        g_free(tmp_path);
+        if (entries) g_array_unref(entries);
+        return FALSE;
+    }
+
+    // 替换数据文件；新索引写入前异常退出时索引 generation 不符，打开时会从头扫描重建
+    pack_reset_state(pack);
+    GFile *pack_file = g_file_new_for_path(pack->pack_path);
+    ok = g_file_move(tmp_file, pack_file, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, NULL);
+    if (ok) {
+        pack->io = g_file_open_readwrite(pack_file, NULL, NULL);
+        pack->reader = pack->io ? reader_open(pack->pack_path) : NULL;
+        ok = pack->reader != NULL;
+    }
+    g_object_unref(pack_file);
+    if (!ok) g_file_delete(tmp_file, NULL, NULL);
+    g_object_unref(tmp_file);
+    g_free(tmp_path);
+
+    if (ok) {
+        // 全部条目先作为新增条目放在内存中，随后在锁外写入索引
+        pack->generation = generation;
+        pack->end = offset;
+        for (guint i = 0; i < entries->len; i++) {
+            ImagePackEntry *e = g_new(ImagePackEntry, 1);
+            *e = g_array_index(entries, ImagePackEntry, i);
+            g_hash_table_replace(pack->overlay, &e->key, e);
+            pack->live_count++;
+            pack->live_bytes += e->length;
+        }
+        g_message("Image pack %s compacted: %" G_GUINT64_FORMAT " -> %" G_GUINT64_FORMAT " bytes, %u entries in %.1f ms",
+                  pack->pack_path, old_size, pack->end, pack->live_count,
+                  (g_get_monotonic_time() - start_us) / 1000.0);
+    } else {
+        pack_reset_state(pack);
+        if (!pack_load(pack)) g_warning("图片缓存压缩后无法重新打开: %s", pack->pack_path);
+        else g_warning("图片缓存压缩后替换文件失败: %s", pack->pack_path);
+    }
+    g_array_unref(entries);
+    pack->compacting = FALSE;
+    g_mutex_unlock(&pack->lock);
+
+    if (ok) pack_flush_index(pack);
+    return ok;
+}
+
+// 淘汰顺序：最近访问时间早的在前，时间相同时访问次数少的在前
+static int compare_entry_age(const void *a, const void *b) {
+    const ImagePackEntry *x = (const ImagePackEntry *)a;
+    const ImagePackEntry *y = (const ImagePackEntry *)b;
+    if (x->atime != y->atime) return x->atime < y->atime ? -1 : 1;
+    return (x->uses > y->uses) - (x->uses < y->uses);
+}
+
+static guint pack_evict_locked(ImagePack *pack, guint64 max_bytes) {
+    GArray *entries = pack_collect_live(pack);
+    guint64 total = PACK_HEADER_SIZE;
+    for (guint i = 0; i < entries->len; i++) {
+        total += record_footprint(g_array_index(entries, ImagePackEntry, i).length);
+    }
+
+    guint evicted = 0;
+    if (total > max_bytes) {
+        // 淘汰到上限的 90%，避免之后每次写入都再次触发
+        guint64 target = max_bytes / 10 * 9;
+        g_array_sort(entries, compare_entry_age);
+        for (guint i = 0; i < entries->len && total > target; i++) {
+            const ImagePackEntry *e = &g_array_index(entries, ImagePackEntry, i);
+            PackRecordHeader rec = { PACK_RECORD_MAGIC, PACK_TAG_TOMBSTONE, e->key, 0, 0 };
+            if (!pack_append_record(pack, &rec, NULL)) break;
+            overlay_put(pack, e->key, 0, 0, PACK_TAG_TOMBSTONE, 0);
+            total -= record_footprint(e->length);
+            evicted++;
+        }
+        pack->evictions += evicted;
+    }
+    g_array_unref(entries);
+    return evicted;
+}
+
+gboolean image_pack_flush_index(ImagePack *pack) {
+    if (!pack) return FALSE;
+    return pack_flush_index(pack);
+}
+
+gboolean image_pack_compact(ImagePack *pack) {
+    if (!pack) return FALSE;
+    return pack_compact(pack);
+}
+
+void image_pack_abort_compaction(ImagePack *pack) {
+    if (pack) g_atomic_int_set(&pack->abort_compact, 1);
+}
+
+guint image_pack_trim(ImagePack *pack, guint64 max_bytes) {
+    if (!pack) return 0;
+    g_mutex_lock(&pack->lock);
+    if (!pack->io) {
+        g_mutex_unlock(&pack->lock);
+        return 0;
+    }
+    guint evicted = pack_evict_locked(pack, max_bytes);
+    // 被淘汰和覆盖的数据只有重写数据文件才能真正释放磁盘空间：
+    // 超出上限，或失效数据较多（超过阈值且超过有效数据的一半）时压缩
+    guint64 used = PACK_HEADER_SIZE + pack->live_bytes + (guint64)pack->live_count * (sizeof(PackRecordHeader) + 7);
+    guint64 dead = pack->end > used ? pack->end - used : 0;
+    gboolean compact = pack->end > max_bytes ||
+                       (dead > PACK_COMPACT_MIN_DEAD_BYTES && dead > pack->live_bytes / 2);
+    g_mutex_unlock(&pack->lock);
+
+    // 压缩会写入新索引；不压缩（或压缩失败）时单独写回索引，
+    // 访问时间与次数只保存在索引中，下次启动仍按真实的最近使用顺序淘汰
+    if (!compact || !pack_compact(pack)) pack_flush_index(pack);
+    return evicted;
+}
+
+void image_pack_get_stats(ImagePack *pack, ImagePackStats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!pack) return;
+    g_mutex_lock(&pack->lock);
+    out->entries = pack->live_count;
+    out->live_bytes = pack->live_bytes;
+    out->file_bytes = pack->end;
+    out->hits = pack->hits;
+    out->misses = pack->misses;
+    out->evictions = pack->evictions;
+    g_mutex_unlock(&pack->lock);
+}
+
+void image_pack_close(ImagePack *pack) {
+    if (!pack) return;
+    // 关闭时只写回索引，压缩留给后台裁剪，退出不会因复制数据而阻塞
+    pack_flush_index(pack);
+
+    g_mutex_lock(&pack->lock);
+    pack_reset_state(pack);
+    g_mutex_unlock(&pack->lock);
+
+    g_hash_table_destroy(pack->overlay);
+    g_hash_table_destroy(pack->touched);
+    g_mutex_clear(&pack->lock);
+    g_free(pack->pack_path);
+    g_free(pack->index_path);
+    g_free(pack);
+}
@@ -0,0 +1,92 @@
+#ifndef IMAGE_PACK_H
+#define IMAGE_PACK_H
+
+#include <glib.h>
+
+// 图片打包缓存：所有图片追加写入一个数据文件（<name>.pack），另有一个按 key 排序的
+// 索引文件（<name>.idx）在打开时只读映射。每条记录自带头部，索引之后追加的记录
+// 在打开时顺序扫描补回，因此进程异常退出只会丢失尚未写完的最后一条记录。
+// 同一 key 重复写入或删除会留下失效数据，由 image_pack_compact 重写数据文件回收。
+// 索引为每个条目记录最近访问时间和访问次数，image_pack_trim 据此淘汰最久未用的条目。
+
+typedef struct ImagePack ImagePack;
+
+typedef struct {
+    guint entries;        // 有效条目数
+    guint64 live_bytes;   // 有效条目的数据字节数
+    guint64 file_bytes;   // 数据文件大小（含失效记录）
+    guint64 hits;         // 本次打开后的查找命中次数
+    guint64 misses;
+    guint64 evictions;    // 本次打开后 image_pack_trim 淘汰的条目数
+} ImagePackStats;
+
+/**
+ * 打开（不存在时创建）打包缓存
+ * @param dir 所在目录
+ * @param name 文件名前缀（生成 <name>.pack 与 <name>.idx）
+ * @return 打包缓存对象；无法创建数据文件时返回 NULL
+ */
+ImagePack* image_pack_open(const char *dir, const char *name);
+
+/**
+ * 写回索引并关闭（不压缩；调用者需确保没有其他线程仍在使用）
+ */
+void image_pack_close(ImagePack *pack);
+
+/**
+ * 读取条目（可在任意线程调用；锁内只查找位置，数据在锁外用 pread 读取）
+ * @param key 条目键
+ * @param tag_out 输出写入时附带的标记，可为 NULL
+ * @return 数据，调用者需要 g_bytes_unref 释放；不存在时返回 NULL
+ */
+GBytes* image_pack_lookup(ImagePack *pack, guint64 key, guint32 *tag_out);
+
+/**
+ * 判断条目是否存在（只查索引，不读取数据，也不计入命中统计）
+ */
+gboolean image_pack_contains(ImagePack *pack, guint64 key);
+
+/**
+ * 追加写入条目，覆盖同 key 的旧条目（可在任意线程调用）
+ * @param tag 调用者自定义的标记（例如图片格式），不能为 G_MAXUINT32
+ * @return TRUE 如果写入成功
+ */
+gboolean image_pack_store(ImagePack *pack, guint64 key, const void *data, gsize size, guint32 tag);
+
+/**
+ * 删除条目（追加一条删除记录）
+ * @return TRUE 如果条目存在并已删除
+ */
+gboolean image_pack_remove(ImagePack *pack, guint64 key);
+
+/**
+ * 把内存中的新增条目与访问记录合并写入索引文件（写文件期间不持有锁）
+ * @return TRUE 如果写入成功（没有新增条目时直接返回 TRUE）；
+ *         压缩或另一次写回正在进行时返回 FALSE
+ */
+gboolean image_pack_flush_index(ImagePack *pack);
+
+/**
+ * 重写数据文件，只保留有效条目，并写入新的索引
+ * 复制数据期间不持有锁，其他线程可以照常查找和写入（耗时，应在后台线程调用）
+ * @return TRUE 如果压缩成功；失败或已有压缩在进行时保持原文件不变
+ */
+gboolean image_pack_compact(ImagePack *pack);
+
+/**
+ * 要求进行中的压缩尽快放弃（可在任意线程调用），原文件保持不变；
+ * 应用退出前调用，避免等待大文件复制完成
+ */
+void image_pack_abort_compaction(ImagePack *pack);
+
+/**
+ * 把数据文件限制在 max_bytes 以内：超出时按最近访问时间（相同时按访问次数）
+ * 淘汰条目到上限的 90%，并写回索引（保存访问时间与次数）；
+ * 数据文件仍超出上限或失效数据较多时压缩（耗时，应在后台线程调用）
+ * @return 淘汰的条目数
+ */
+guint image_pack_trim(ImagePack *pack, guint64 max_bytes);
+
+void image_pack_get_stats(ImagePack *pack, ImagePackStats *out);
+
+#endif // IMAGE_PACK_H
@@ -43,6 +43,7 @@
 #include "image_loader.h"
 #include "dnd_manager.h"
 #include "search_filter.h"
+#include "search_results.h"
 #include "deck_url.h"
 
 // 全局变量：程序所在目录
@@ -80,11 +81,33 @@ static FilterState filter_state = {
     .field_text = NULL
 };
 
+// 由 filter_state 编译出的筛选谓词，启动时在 on_activate 中编译
+static FilterPredicate filter_predicate;
+// 编译谓词时的字段名缓存代次；离线数据更新后字段代码可能变化，需要重新编译
+static guint filter_predicate_setnames_generation = 0;
+
+// 筛选状态变化后重新编译谓词
+static void recompile_filter_predicate(void) {
+    filter_predicate_clear(&filter_predicate);
+    filter_predicate_setnames_generation = card_info_setnames_generation();
+    filter_predicate_compile(&filter_predicate, &filter_state);
+}
+
 // 获取当前筛选状态的指针（供search_filter.c使用）
 const FilterState* get_current_filter_state(void) {
     return (const FilterState*)&filter_state;
 }
 
+// 获取当前筛选谓词的指针（供search_filter.c使用，在主线程调用）
+const FilterPredicate* get_current_filter_predicate(void) {
+    // strings.conf 字段名缓存已失效（离线数据更新/清理），字段代码需要重新解析
+    if (filter_predicate.has_field &&
+        filter_predicate_setnames_generation != card_info_setnames_generation()) {
+        recompile_filter_predicate();
+    }
+    return (const FilterPredicate*)&filter_predicate;
+}
+
 // 检查是否有活动的筛选条件
 gboolean has_active_filter(void) {
     // 检查卡片类型选择
@@ -168,15 +191,6 @@ static gchar *get_forbidden_list_path(const char *filename) {
 // 前置声明
 static void on_export_clicked(GtkButton *btn, gpointer user_data);
 
-void list_clear(GtkListBox *list) {
-    GtkWidget *child = gtk_widget_get_first_child(GTK_WIDGET(list));
-    while (child) {
-        GtkWidget *next = gtk_widget_get_next_sibling(child);
-        gtk_list_box_remove(list, child);
-        child = next;
-    }
-}
-
 void draw_pixbuf_scaled(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer user_data) {
     (void)user_data;
     GdkPixbuf *pb = (GdkPixbuf*)g_object_get_data(G_OBJECT(area), "pixbuf");
@@ -224,13 +238,17 @@ void draw_pixbuf_scaled(GtkDrawingArea *area, cairo_t *cr, int width, int height
 
     // 重新生成缓存：按比例 contain 填充到 target_w x target_h
     // 若当前 pixbuf 分辨率低于目标 device-pixel 尺寸（常见于 widget 未 realize 时取到 scale=1 的预缩放），
-    // 尝试从磁盘缓存读取原图用于本次渲染，以恢复清晰度。
+    // 尝试从磁盘缓存读取当前倍率的缩略图（不够大时再读原图）用于本次渲染，以恢复清晰度。
     GdkPixbuf *src_pb = pb;
     GdkPixbuf *disk_pb = NULL;
     if (gdk_pixbuf_get_width(pb) < target_w || gdk_pixbuf_get_height(pb) < target_h) {
         int img_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(area), "img_id"));
         if (img_id > 0) {
-            disk_pb = load_from_disk_cache(img_id);
+            disk_pb = load_thumb_from_disk_cache(img_id, scale_factor);
+            if (disk_pb && (gdk_pixbuf_get_width(disk_pb) < target_w || gdk_pixbuf_get_height(disk_pb) < target_h)) {
+                g_object_unref(disk_pb);
+                disk_pb = load_from_disk_cache(img_id);
+            }
             if (disk_pb) {
                 src_pb = disk_pb;
             }
@@ -736,6 +754,8 @@ static void reset_filter_state(void) {
     filter_state.left_scale_text = NULL;
     filter_state.right_scale_text = NULL;
     filter_state.field_text = NULL;
+
+    recompile_filter_predicate();
 }
 
 // "恢复默认"按钮回调：重置筛选状态并更新UI控件
@@ -948,6 +968,10 @@ static void on_filter_dialog_closed(AdwDialog *dialog, gpointer user_data) {
     // 保存卡片字段文本
     AdwEntryRow *field_row = g_object_get_data(G_OBJECT(dialog), "field_row");
     filter_state.field_text = field_row ? g_strdup(gtk_editable_get_text(GTK_EDITABLE(field_row))) : NULL;
+
+    // 编译筛选条件：之后每次搜索只做整数比较
+    recompile_filter_predicate();
+    filter_benchmark_maybe_run(&filter_predicate);
 }
 
 // 筛选按钮回调：打开筛选选项对话框
@@ -1393,7 +1417,6 @@ typedef struct {
 typedef struct {
     GtkWidget *slot;
     int img_id;
-    gchar *local_path;
 } PreleaseLoadTask;
 
 // 异步加载先行卡图片的工作线程
@@ -1402,13 +1425,13 @@ static void prerelease_load_thread(GTask *task, gpointer source_object, gpointer
     (void)cancellable;
     
     PreleaseLoadTask *data = (PreleaseLoadTask*)task_data;
-    if (!data || !data->local_path) {
+    if (!data) {
         g_task_return_pointer(task, NULL, NULL);
         return;
     }
     
     GError *error = NULL;
-    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(data->local_path, &error);
+    GdkPixbuf *pixbuf = load_prerelease_card_image(data->img_id, &error);
     
     if (error) {
         g_warning("加载先行卡图片失败: %s", error->message);
@@ -1442,7 +1465,6 @@ static void prerelease_load_finished(GObject *source, GAsyncResult *res, gpointe
     // 清理
     if (pixbuf) g_object_unref(pixbuf);
     if (data->slot) g_object_remove_weak_pointer(G_OBJECT(data->slot), (gpointer*)&data->slot);
-    g_free(data->local_path);
     g_free(data);
 }
 
@@ -1463,23 +1485,19 @@ static void load_card_image(GtkWidget *slot, int img_id, SoupSession *session) {
     }
     
     if (is_prerelease) {
-        // 先行卡：异步从本地加载（避免IO阻塞）
-        gchar *local_path = get_prerelease_card_image_path(img_id);
-        if (local_path && g_file_test(local_path, G_FILE_TEST_EXISTS)) {
+        // 先行卡：异步从本地归档加载（避免IO阻塞）
+        if (prerelease_card_has_image(img_id)) {
             PreleaseLoadTask *task_data = g_new0(PreleaseLoadTask, 1);
             task_data->slot = slot;
             task_data->img_id = img_id;
-            task_data->local_path = local_path;  // 转移所有权
             
             // 添加弱引用防止slot被销毁后访问
             g_object_add_weak_pointer(G_OBJECT(slot), (gpointer*)&task_data->slot);
             
             GTask *task = g_task_new(NULL, NULL, prerelease_load_finished, task_data);
             g_task_set_task_data(task, task_data, NULL);
-            g_task_run_in_thread(task, prerelease_load_thread);
+            image_loader_run_in_decode_pool(task, prerelease_load_thread);
             g_object_unref(task);
-        } else {
-            g_free(local_path);
         }
     } else {
         // 普通卡：先检查内存缓存（快速路径）
@@ -1490,9 +1508,9 @@ static void load_card_image(GtkWidget *slot, int img_id, SoupSession *session) {
             return;
         }
         
-        // 内存缓存未命中，检查磁盘缓存
-        // 注意：load_from_disk_cache返回新引用，调用者需要unref
-        GdkPixbuf *disk_cached = load_from_disk_cache(img_id);
+        // 内存缓存未命中，检查磁盘缩略图缓存
+        // 注意：load_thumb_from_disk_cache返回新引用，调用者需要unref
+        GdkPixbuf *disk_cached = load_thumb_from_disk_cache(img_id, gtk_widget_get_scale_factor(slot));
         if (disk_cached) {
             slot_set_pixbuf(slot, disk_cached);
             g_object_unref(disk_cached);  // 重要：释放引用
@@ -1511,6 +1529,7 @@ static void load_card_image(GtkWidget *slot, int img_id, SoupSession *session) {
         ctx->add_to_thumb_cache = TRUE;
         ctx->url = g_strdup(url);
         ctx->cancel_generation = get_cancel_generation();
+        ctx->priority = IMAGE_LOAD_PRIORITY_DECK_SLOT;
         load_image_async(session, url, ctx);
     }
 }
@@ -1958,17 +1977,17 @@ static void on_sort_clicked(GtkButton *btn, gpointer user_data) {
     
     // 对Main区域排序
     if (ui->main_pics && ui->main_idx > 0) {
-        sort_deck_region(ui->main_pics, &ui->main_idx, ui->main_count);
+        sort_deck_region(ui->main_pics, &ui->main_idx, ui->main_count, ui->session);
     }
     
     // 对Extra区域排序（按融合-同调-超量-连接，同类按level降序）
     if (ui->extra_pics && ui->extra_idx > 0) {
-        sort_extra_region(ui->extra_pics, &ui->extra_idx, ui->extra_count);
+        sort_extra_region(ui->extra_pics, &ui->extra_idx, ui->extra_count, ui->session);
     }
     
     // 对Side区域排序
     if (ui->side_pics && ui->side_idx > 0) {
-        sort_deck_region(ui->side_pics, &ui->side_idx, ui->side_count);
+        sort_deck_region(ui->side_pics, &ui->side_idx, ui->side_count, ui->session);
     }
 }
 
@@ -2090,7 +2109,6 @@ typedef struct {
     GtkPicture *picture;
     GtkStack *stack;
     int card_id;
-    gchar *local_path;
 } PreviewLoadTask;
 
 // 异步加载预览图的工作线程
@@ -2099,13 +2117,13 @@ static void preview_load_thread(GTask *task, gpointer source_object, gpointer ta
     (void)cancellable;
     
     PreviewLoadTask *data = (PreviewLoadTask*)task_data;
-    if (!data || !data->local_path) {
+    if (!data) {
         g_task_return_pointer(task, NULL, NULL);
         return;
     }
     
     GError *error = NULL;
-    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(data->local_path, &error);
+    GdkPixbuf *pixbuf = load_prerelease_card_image(data->card_id, &error);
     
     if (error) {
         g_warning("Failed to load prerelease image: %s", error->message);
@@ -2146,7 +2164,6 @@ static void preview_load_finished(GObject *source, GAsyncResult *res, gpointer u
     if (pixbuf) g_object_unref(pixbuf);
     if (data->picture) g_object_remove_weak_pointer(G_OBJECT(data->picture), (gpointer*)&data->picture);
     if (data->stack) g_object_remove_weak_pointer(G_OBJECT(data->stack), (gpointer*)&data->stack);
-    g_free(data->local_path);
     g_free(data);
 }
 
@@ -2160,14 +2177,12 @@ static void show_card_preview(SearchUI *ui, const CardPreview *pv) {
     // 图片
     if (pv->id > 0) {
         if (pv->is_prerelease) {
-            // 先行卡：异步从本地加载图片（避免IO阻塞）
-            gchar *local_path = get_prerelease_card_image_path(pv->id);
-            if (local_path && g_file_test(local_path, G_FILE_TEST_EXISTS)) {
+            // 先行卡：异步从本地归档加载图片（避免IO阻塞）
+            if (prerelease_card_has_image(pv->id)) {
                 PreviewLoadTask *task_data = g_new0(PreviewLoadTask, 1);
                 task_data->picture = ui->left_picture;
                 task_data->stack = ui->left_stack;
                 task_data->card_id = pv->id;
-                task_data->local_path = local_path;  // 转移所有权
                 
                 // 添加弱引用
                 g_object_add_weak_pointer(G_OBJECT(task_data->picture), (gpointer*)&task_data->picture);
@@ -2175,14 +2190,17 @@ static void show_card_preview(SearchUI *ui, const CardPreview *pv) {
                 
                 GTask *task = g_task_new(NULL, NULL, preview_load_finished, task_data);
                 g_task_set_task_data(task, task_data, NULL);
-                g_task_run_in_thread(task, preview_load_thread);
+                image_loader_run_in_decode_pool(task, preview_load_thread);
                 g_object_unref(task);
-            } else {
-                g_free(local_path);
             }
         } else {
-            // 普通卡：先尝试从磁盘缓存加载
-            GdkPixbuf *cached_pixbuf = load_from_disk_cache(pv->id);
+            // 普通卡：先尝试内存缓存，再尝试磁盘缓存
+            GdkPixbuf *cached_pixbuf = get_fullsize_from_cache(pv->id);
+            if (cached_pixbuf) {
+                g_object_ref(cached_pixbuf);  // 内存缓存持有引用，统一按新引用处理
+            } else {
+                cached_pixbuf = load_from_disk_cache(pv->id);
+            }
             if (cached_pixbuf) {
                 // 从缓存加载成功
                 GdkTexture *tex = gdk_texture_new_for_pixbuf(cached_pixbuf);
@@ -2207,6 +2225,7 @@ static void show_card_preview(SearchUI *ui, const CardPreview *pv) {
                 ctx->scale_to_thumb = FALSE;
                 ctx->cache_id = pv->id;  // 设置cache_id以便下载后保存到缓存
                 ctx->url = g_strdup(url);
+                ctx->priority = IMAGE_LOAD_PRIORITY_PREVIEW;
                 load_image_async(ui->session, url, ctx);
             }
         }
@@ -2218,13 +2237,8 @@ void on_result_row_pressed(GtkGestureClick *gesture, int n_press, double x, doub
     (void)n_press; (void)user_data;
     GtkWidget *row = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(gesture));
     
-    // 安全性检查：确保 row 仍然有效
-    if (!row || !GTK_IS_LIST_BOX_ROW(row)) {
-        return;
-    }
-    
-    // 检查是否被标记为无效（在 list_clear 之前）
-    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "row_invalid"))) {
+    // 安全性检查：行控件会被回收，未绑定卡片时不处理
+    if (!row || !search_result_row_get_preview(row)) {
         return;
     }
     
@@ -2240,19 +2254,8 @@ void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, dou
     SearchUI *ui = (SearchUI*)user_data;
     GtkWidget *row = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(gesture));
     
-    // 安全性检查：确保 row 仍然有效且是 ListBoxRow
-    if (!row || !GTK_IS_LIST_BOX_ROW(row)) {
-        return;
-    }
-    
-    // 检查是否被标记为无效（在 list_clear 之前）
-    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "row_invalid"))) {
-        return;
-    }
-    
-    // 检查 row 是否仍在列表中（防止在 list_clear 后访问）
-    GtkWidget *parent = gtk_widget_get_parent(row);
-    if (!parent || !GTK_IS_LIST_BOX(parent)) {
+    // 安全性检查：行控件会被回收，未绑定卡片时不处理
+    if (!row || !search_result_row_get_preview(row)) {
         return;
     }
     
@@ -2269,7 +2272,7 @@ void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, dou
     }
     g_object_set_data_full(G_OBJECT(row), "press_xy", NULL, NULL);
 
-    CardPreview *pv = (CardPreview*)g_object_get_data(G_OBJECT(row), "preview");
+    const CardPreview *pv = search_result_row_get_preview(row);
     if (!pv) return;
     
     // 检查禁限卡限制
@@ -2351,19 +2354,11 @@ void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, dou
     if (pv->id > 0) {
         // 优先尝试从右栏行中获取已加载的缩略图（零延迟）
         GdkPixbuf *right_pixbuf = NULL;
-        if (GTK_IS_LIST_BOX_ROW(row)) {
-            GtkWidget *row_child = gtk_list_box_row_get_child(GTK_LIST_BOX_ROW(row));
-            if (row_child) {
-                GtkWidget *thumb_stack = gtk_widget_get_first_child(row_child);
-                if (thumb_stack && GTK_IS_STACK(thumb_stack)) {
-                    GtkWidget *picture = gtk_stack_get_child_by_name(GTK_STACK(thumb_stack), "picture");
-                    if (picture && GTK_IS_DRAWING_AREA(picture)) {
-                        GdkPixbuf *pb = slot_get_pixbuf(picture);
-                        if (pb) {
-                            right_pixbuf = g_object_ref(pb);  // 增加引用计数
-                        }
-                    }
-                }
+        GtkWidget *picture = search_result_row_get_picture(row);
+        if (picture && GTK_IS_DRAWING_AREA(picture)) {
+            GdkPixbuf *pb = slot_get_pixbuf(picture);
+            if (pb) {
+                right_pixbuf = g_object_ref(pb);  // 增加引用计数
             }
         }
         
@@ -2393,8 +2388,8 @@ void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, dou
                 slot_set_pixbuf(target_pic, cached);
                 // 注意：get_thumb_from_cache返回缓存持有的引用，不需要unref
             } else {
-                // 尝试从磁盘缓存加载
-                GdkPixbuf *disk_cached = load_from_disk_cache(pv->id);
+                // 尝试从磁盘缩略图缓存加载
+                GdkPixbuf *disk_cached = load_thumb_from_disk_cache(pv->id, gtk_widget_get_scale_factor(GTK_WIDGET(target_pic)));
                 if (disk_cached) {
                     slot_set_pixbuf(target_pic, disk_cached);
                     g_object_unref(disk_cached);  // 重要：释放引用
@@ -2410,6 +2405,7 @@ void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, dou
                     ctx->add_to_thumb_cache = TRUE;  // 下载后保存到缩略图缓存
                     ctx->url = g_strdup(url);
                     ctx->cancel_generation = get_cancel_generation();
+                    ctx->priority = IMAGE_LOAD_PRIORITY_DECK_SLOT;
                     load_image_async(ui->session, url, ctx);
                 }
             }
@@ -2421,24 +2417,10 @@ void on_result_row_enter(GtkEventControllerMotion *controller, double x, double
     (void)x; (void)y;
     SearchUI *ui = (SearchUI*)user_data;
     GtkWidget *row = gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(controller));
+    if (!row) return;
     
-    // 安全性检查：确保 row 仍然有效且是 ListBoxRow
-    if (!row || !GTK_IS_LIST_BOX_ROW(row)) {
-        return;
-    }
-    
-    // 检查是否被标记为无效（在 list_clear 之前）
-    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "row_invalid"))) {
-        return;
-    }
-    
-    // 检查 row 是否仍在列表中（防止在 list_clear 后访问）
-    GtkWidget *parent = gtk_widget_get_parent(row);
-    if (!parent || !GTK_IS_LIST_BOX(parent)) {
-        return;
-    }
-    
-    CardPreview *pv = (CardPreview*)g_object_get_data(G_OBJECT(row), "preview");
+    // 行控件会被回收，未绑定卡片时取不到信息
+    const CardPreview *pv = search_result_row_get_preview(row);
     if (pv) show_card_preview(ui, pv);
 }
 
@@ -2786,7 +2768,7 @@ static void on_show_prerelease_action(GSimpleAction *action, GVariant *parameter
     }
     
     // 清空当前搜索结果
-    list_clear(GTK_LIST_BOX(ui->list));
+    search_results_clear(ui);
     
     // 清理旧的图片加载队列和定时器
     if (ui->search_image_loader_id > 0) {
@@ -2849,6 +2831,15 @@ static GtkWidget* make_section_header(const char *title_text) {
     return box;
 }
 
+// 应用退出：等待解码线程池排空，写回图片缓存索引并输出统计
+static void
+on_shutdown(GApplication *app, gpointer user_data)
+{
+    (void)app;
+    (void)user_data;
+    cleanup_image_cache();
+}
+
 static void
 on_activate(GApplication *app, gpointer user_data)
 {
@@ -2857,6 +2848,9 @@ on_activate(GApplication *app, gpointer user_data)
     // Initialize image cache system
     init_image_cache();
 
+    // 编译默认筛选条件（数值条件需要初始化为 FILTER_ANY）
+    recompile_filter_predicate();
+
     AdwApplicationWindow *win = ADW_APPLICATION_WINDOW(
         adw_application_window_new(GTK_APPLICATION(app)));
 
@@ -3368,6 +3362,8 @@ on_activate(GApplication *app, gpointer user_data)
     
     // 为输入框添加回车键支持,触发按钮点击
     g_signal_connect_swapped(sui->entry, "activate", G_CALLBACK(gtk_widget_activate), sui->button);
+    // 修改关键词时立即打断仍在进行的后台搜索
+    g_signal_connect(sui->entry, "changed", G_CALLBACK(on_search_entry_changed), sui);
     gtk_box_append(GTK_BOX(search_bar), sui->entry);
     gtk_box_append(GTK_BOX(search_bar), sui->button);
     
@@ -3386,8 +3382,8 @@ on_activate(GApplication *app, gpointer user_data)
     gtk_scrolled_window_set_kinetic_scrolling(GTK_SCROLLED_WINDOW(scroller), TRUE);
     // 使用自动滚动策略,只在需要时显示滚动条
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroller), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
-    sui->list = gtk_list_box_new();
-    gtk_list_box_set_selection_mode(GTK_LIST_BOX(sui->list), GTK_SELECTION_NONE);
+    // 结果列表：GtkListView 只为可见行创建控件并回收复用
+    search_results_init(sui);
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scroller), sui->list);
 
     gtk_box_append(GTK_BOX(col_end), search_bar);
@@ -3538,5 +3534,6 @@ main(int argc, char *argv[])
     load_io_config(&last_export_directory, &last_import_directory);
 
     g_signal_connect(app, "activate", G_CALLBACK(on_activate), NULL);
+    g_signal_connect(app, "shutdown", G_CALLBACK(on_shutdown), NULL);
     return g_application_run(G_APPLICATION(app), argc, argv);
 }
@@ -1,5 +1,9 @@
 #include "offline_data.h"
 #include "app_path.h"
+#include "card_store.h"
+#include "card_index.h"
+#include "search_keys.h"
+#include "card_info.h"
 #include <libsoup/soup.h>
 #include <json-glib/json-glib.h>
 #include <archive.h>
@@ -12,10 +16,13 @@
 #include <dirent.h>
 #include <unistd.h>
 
-// 离线 cards.json 解析缓存：避免每次搜索都重新 parse，尤其是第一次搜索会明显卡顿。
+// 离线卡片存储缓存：cards.json 首次加载（或更新）时编译为 cards.bin，之后只做内存映射，
+// 搜索/按 ID 查询都直接读取映射的列数据，不再解析 JSON。
+// 倒排索引在第一次文本搜索（或预热）时于锁外建立，按 ID 查询和数值列读取只需等待映射好的存储。
 static GMutex offline_cache_mutex;
-static JsonParser *offline_cards_parser = NULL;
-static JsonObject *offline_cards_root = NULL; // owned by parser->root
+static GMutex offline_index_build_mutex;             // 串行化索引建立，避免并发搜索重复建立
+static CardStore *offline_store = NULL;
+static CardSearchIndex *offline_search_index = NULL; // 对应当前 offline_store，存储替换时失效
 static gchar *offline_cards_json_path = NULL;
 static gint64 offline_cards_json_mtime = 0;
 
@@ -29,6 +36,14 @@ static gchar *get_cards_json_path(void) {
     return json_path;
 }
 
+static gchar *get_cards_store_path(void) {
+    gchar *cards_dir = get_cards_dir();
+    if (!cards_dir) return NULL;
+    gchar *bin_path = g_build_filename(cards_dir, CARD_STORE_FILENAME, NULL);
+    g_free(cards_dir);
+    return bin_path;
+}
+
 static gint64 stat_mtime_us(const char *path) {
     if (!path) return 0;
     GStatBuf st;
@@ -43,11 +58,8 @@ static gint64 stat_mtime_us(const char *path) {
 
 void offline_data_clear_cache(void) {
     g_mutex_lock(&offline_cache_mutex);
-    if (offline_cards_parser) {
-        g_object_unref(offline_cards_parser);
-        offline_cards_parser = NULL;
-    }
-    offline_cards_root = NULL;
+    g_clear_pointer(&offline_search_index, card_search_index_unref);
+    g_clear_pointer(&offline_store, card_store_unref);
     g_clear_pointer(&offline_cards_json_path, g_free);
     offline_cards_json_mtime = 0;
     g_mutex_unlock(&offline_cache_mutex);
@@ -62,8 +74,7 @@ static gboolean offline_cache_ensure_loaded_locked(void) {
     }
 
     gint64 mtime = stat_mtime_us(json_path);
-    gboolean need_reload = (offline_cards_parser == NULL) ||
-                           (offline_cards_root == NULL) ||
+    gboolean need_reload = (offline_store == NULL) ||
                            (offline_cards_json_path == NULL) ||
                            (g_strcmp0(offline_cards_json_path, json_path) != 0) ||
                            (offline_cards_json_mtime != mtime);
@@ -74,123 +85,138 @@ static gboolean offline_cache_ensure_loaded_locked(void) {
     }
 
     // reload
-    if (offline_cards_parser) {
-        g_object_unref(offline_cards_parser);
-        offline_cards_parser = NULL;
-    }
-    offline_cards_root = NULL;
+    g_clear_pointer(&offline_search_index, card_search_index_unref);
+    g_clear_pointer(&offline_store, card_store_unref);
     g_clear_pointer(&offline_cards_json_path, g_free);
     offline_cards_json_mtime = 0;
 
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    if (!json_parser_load_from_file(parser, json_path, &error)) {
-        g_warning("Failed to parse cards.json: %s", error ? error->message : "unknown error");
-        if (error) g_error_free(error);
-        g_object_unref(parser);
-        g_free(json_path);
-        return FALSE;
+    gchar *bin_path = get_cards_store_path();
+    CardStore *store = card_store_open(bin_path, json_path);
+    if (!store) {
+        // cards.bin 不存在或已过期（例如旧版本下载的数据），现场编译一次
+        if (card_store_compile(json_path, bin_path)) {
+            store = card_store_open(bin_path, json_path);
+        }
     }
+    g_free(bin_path);
 
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
-        g_warning("Invalid JSON structure in cards.json");
-        g_object_unref(parser);
+    if (!store) {
+        g_warning("Failed to load offline card store");
         g_free(json_path);
         return FALSE;
     }
 
-    offline_cards_parser = parser;
-    offline_cards_root = json_node_get_object(root);
+    offline_store = store;
     offline_cards_json_path = json_path; // take ownership
     offline_cards_json_mtime = mtime;
     return TRUE;
 }
 
-static gboolean card_matches_query(JsonObject *card, const gchar *query_lower) {
-    if (!card || !query_lower || query_lower[0] == '\0') return TRUE;
-
-    gboolean match = FALSE;
-    const gchar *name_fields[] = {"cn_name", "sc_name", "md_name", "jp_name", "en_name", "nwbbs_n", "cnocg_n", NULL};
-    for (int i = 0; name_fields[i] != NULL && !match; i++) {
-        if (json_object_has_member(card, name_fields[i])) {
-            const gchar *name = json_object_get_string_member(card, name_fields[i]);
-            if (name) {
-                gchar *name_lower = g_utf8_strdown(name, -1);
-                if (name_lower && strstr(name_lower, query_lower) != NULL) {
-                    match = TRUE;
-                }
-                g_free(name_lower);
-            }
-        }
+// 取得当前存储的引用（必要时加载/编译），调用者需要 card_store_unref
+static CardStore *offline_store_acquire(void) {
+    CardStore *store = NULL;
+    g_mutex_lock(&offline_cache_mutex);
+    if (offline_cache_ensure_loaded_locked() && offline_store) {
+        store = card_store_ref(offline_store);
     }
+    g_mutex_unlock(&offline_cache_mutex);
+    return store;
+}
 
-    if (!match && json_object_has_member(card, "text")) {
-        JsonObject *text = json_object_get_object_member(card, "text");
-        if (text && json_object_has_member(text, "desc")) {
-            const gchar *desc = json_object_get_string_member(text, "desc");
-            if (desc) {
-                gchar *desc_lower = g_utf8_strdown(desc, -1);
-                if (desc_lower && strstr(desc_lower, query_lower) != NULL) {
-                    match = TRUE;
-                }
-                g_free(desc_lower);
-            }
-        }
+static CardSearchIndex *offline_search_index_lookup(const CardStore *store) {
+    CardSearchIndex *index = NULL;
+    g_mutex_lock(&offline_cache_mutex);
+    if (offline_store == store && offline_search_index) {
+        index = card_search_index_ref(offline_search_index);
     }
+    g_mutex_unlock(&offline_cache_mutex);
+    return index;
+}
+
+// 取得 store 对应的倒排索引引用（可能为 NULL），调用者需要 card_search_index_unref；
+// 尚未建立时在 offline_cache_mutex 之外建立，期间按 ID 查询不受影响（应在工作线程调用）
+static CardSearchIndex *offline_search_index_acquire(CardStore *store) {
+    CardSearchIndex *index = offline_search_index_lookup(store);
+    if (index) return index;
 
-    return match;
+    g_mutex_lock(&offline_index_build_mutex);
+    // 等待期间其他线程可能已经建好
+    index = offline_search_index_lookup(store);
+    if (!index) {
+        index = card_search_index_build(store);
+        g_mutex_lock(&offline_cache_mutex);
+        // 建立期间存储已被替换（离线数据更新）时不登记，只供本次使用
+        if (index && offline_store == store && !offline_search_index) {
+            offline_search_index = card_search_index_ref(index);
+        }
+        g_mutex_unlock(&offline_cache_mutex);
+    }
+    g_mutex_unlock(&offline_index_build_mutex);
+    return index;
 }
 
 guint offline_foreach_card(const char *query,
                            gboolean search_all,
+                           OfflineCardFilterFunc filter_cb,
                            OfflineCardMatchFunc match_cb,
                            gpointer user_data,
-                           guint max_results) {
+                           guint max_results,
+                           GCancellable *cancellable) {
     // max_results==0 表示不限制，但这里为了 UI 不卡死，通常会传入 500。
     if (!offline_data_exists()) return 0;
 
-    gchar *query_lower = NULL;
-    if (!search_all && query && query[0] != '\0') {
-        query_lower = g_utf8_strdown(query, -1);
-    }
-
-    guint accepted = 0;
+    CardStore *store = offline_store_acquire();
+    if (!store) return 0;
 
-    JsonParser *parser_ref = NULL;
-    JsonObject *root_obj = NULL;
-    g_mutex_lock(&offline_cache_mutex);
-    gboolean ok = offline_cache_ensure_loaded_locked();
-    if (ok && offline_cards_parser && offline_cards_root) {
-        parser_ref = g_object_ref(offline_cards_parser);
-        root_obj = offline_cards_root;
+    // 搜索键（折叠后的卡名+描述）随索引一起预先建立，匹配时不再逐卡分配；
+    // 只有文本搜索需要索引，纯筛选直接读取数值列
+    CardSearchIndex *index = NULL;
+    const SearchKeys *keys = NULL;
+    gchar *query_folded = NULL;
+    if (!search_all && query && query[0] != '\0') {
+        index = offline_search_index_acquire(store);
+        keys = card_search_index_get_keys(index);
+        if (!keys) {
+            if (index) card_search_index_unref(index);
+            card_store_unref(store);
+            return 0;
+        }
+        query_folded = search_key_fold(query);
     }
-    g_mutex_unlock(&offline_cache_mutex);
 
-    if (!ok || !parser_ref || !root_obj) {
-        if (parser_ref) g_object_unref(parser_ref);
-        g_free(query_lower);
-        return 0;
+    // 通过倒排索引缩小候选集；查询过短（无法生成 n-gram）时退化为全量扫描
+    GArray *candidates = NULL;
+    if (query_folded && index) {
+        candidates = card_search_index_lookup(index, query_folded);
     }
 
-    JsonObjectIter iter;
-    json_object_iter_init(&iter, root_obj);
-    const gchar *member_name = NULL;
-    JsonNode *card_node = NULL;
+    guint accepted = 0;
+    gsize bytes_scanned = 0;
+    guint total = candidates ? candidates->len : card_store_get_count(store);
+    for (guint k = 0; k < total; k++) {
+        // 新的搜索开始后立即停止遍历
+        if (cancellable && g_cancellable_is_cancelled(cancellable)) break;
 
-    while (json_object_iter_next(&iter, &member_name, &card_node)) {
-        (void)member_name;
-        if (!card_node || !JSON_NODE_HOLDS_OBJECT(card_node)) continue;
-        JsonObject *card = json_node_get_object(card_node);
-        if (!card) continue;
+        guint i = candidates ? g_array_index(candidates, guint32, k) : k;
 
-        if (!search_all && query_lower && !card_matches_query(card, query_lower)) {
+        // 候选集仍需做一次子串校验（n-gram 全部命中不代表连续出现）
+        if (query_folded && !search_keys_match(keys, i, query_folded, &bytes_scanned)) {
             continue;
         }
 
+        // 数值预筛选直接读取列数据，不通过的卡片不必构建 JSON
+        if (filter_cb) {
+            CardNumericFields fields;
+            card_store_get_numeric_fields(store, i, &fields);
+            if (!filter_cb(&fields, user_data)) continue;
+        }
+
+        // 只有命中的卡片才构建 JSON 对象交给回调
         gboolean accept = TRUE;
         if (match_cb) {
+            JsonObject *card = card_store_build_json(store, i);
             accept = match_cb(card, user_data);
+            json_object_unref(card);
         }
         if (accept) {
             accepted++;
@@ -198,8 +224,15 @@ guint offline_foreach_card(const char *query,
         }
     }
 
-    g_free(query_lower);
-    g_object_unref(parser_ref);
+    if (query_folded) {
+        g_debug("Offline search \"%s\": %u candidates, %" G_GSIZE_FORMAT " key bytes scanned",
+                query, total, bytes_scanned);
+    }
+
+    if (candidates) g_array_unref(candidates);
+    if (index) card_search_index_unref(index);
+    g_free(query_folded);
+    card_store_unref(store);
     return accepted;
 }
 
@@ -209,9 +242,13 @@ typedef struct {
 
 static gpointer offline_warm_thread(gpointer data) {
     OfflineWarmCtx *ctx = (OfflineWarmCtx*)data;
-    g_mutex_lock(&offline_cache_mutex);
-    (void)offline_cache_ensure_loaded_locked();
-    g_mutex_unlock(&offline_cache_mutex);
+    // 先映射存储（按 ID 查询只需等待这一步），再在锁外建立倒排索引
+    CardStore *store = offline_store_acquire();
+    if (store) {
+        CardSearchIndex *index = offline_search_index_acquire(store);
+        if (index) card_search_index_unref(index);
+        card_store_unref(store);
+    }
     if (ctx) {
         ctx->done = TRUE;
         g_free(ctx);
@@ -627,12 +664,22 @@ static gpointer download_offline_data_thread(gpointer data) {
         g_free(strings_path);
     }
     
+    // 将 cards.json 编译为二进制存储，之后的搜索只需映射该文件
+    gchar *json_path = g_build_filename(cards_dir, "cards.json", NULL);
+    gchar *bin_path = g_build_filename(cards_dir, CARD_STORE_FILENAME, NULL);
+    if (!card_store_compile(json_path, bin_path)) {
+        g_warning("Failed to compile offline card store, will retry on first search");
+    }
+    g_free(json_path);
+    g_free(bin_path);
+
     g_free(zip_path);
     g_free(data_dir);
     g_free(cards_dir);
 
-    // 离线数据更新后，清理解析缓存，避免读取旧文件。
+    // 离线数据更新后，清理存储缓存和 strings.conf 字段名缓存，避免读取旧文件。
     offline_data_clear_cache();
+    card_info_invalidate_setnames();
     
     ctx->success = TRUE;
     if (ctx->callback) {
@@ -709,6 +756,7 @@ gboolean clear_offline_data(void) {
 
     // 清理离线数据后，清空解析缓存
     offline_data_clear_cache();
+    card_info_invalidate_setnames();
     return success;
 }
 
@@ -1021,57 +1069,83 @@ JsonObject* get_card_by_id_offline(int card_id) {
     if (card_id <= 0) {
         return NULL;
     }
-    
-    // 获取 cards.json 文件路径
-    gchar *cards_dir = get_cards_dir();
-    if (!cards_dir) {
+
+    CardStore *store = offline_store_acquire();
+    if (!store) {
         return NULL;
     }
-    
-    gchar *json_path = g_build_filename(cards_dir, "cards.json", NULL);
-    g_free(cards_dir);
-    
-    if (!g_file_test(json_path, G_FILE_TEST_EXISTS)) {
-        g_free(json_path);
-        return NULL;
+
+    JsonObject *result = NULL;
+    gint index = card_store_find_by_id(store, card_id);
+    if (index >= 0) {
+        // 新构建的对象（调用者需要 unref）
+        result = card_store_build_json(store, (guint)index);
     }
-    
-    // 加载 JSON 文件
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    
-    if (!json_parser_load_from_file(parser, json_path, &error)) {
-        if (error) g_error_free(error);
-        g_object_unref(parser);
-        g_free(json_path);
+
+    card_store_unref(store);
+    return result;
+}
+
+static void free_card_object(gpointer data) {
+    if (data) json_object_unref((JsonObject*)data);
+}
+
+/**
+ * 批量根据卡片ID获取离线卡片信息
+ */
+GPtrArray* get_cards_by_ids_offline(const int *card_ids, guint n_ids) {
+    if (!card_ids || n_ids == 0) {
         return NULL;
     }
-    
-    g_free(json_path);
-    
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
-        g_object_unref(parser);
+
+    // 整批只取一次存储引用，避免每张卡都加锁/校验文件
+    CardStore *store = offline_store_acquire();
+    if (!store) {
         return NULL;
     }
-    
-    JsonObject *root_obj = json_node_get_object(root);
-    
-    // 根据ID查找卡片
-    char card_id_str[32];
-    g_snprintf(card_id_str, sizeof(card_id_str), "%d", card_id);
-    
-    JsonObject *result = NULL;
-    if (json_object_has_member(root_obj, card_id_str)) {
-        JsonNode *card_node = json_object_get_member(root_obj, card_id_str);
-        if (card_node && JSON_NODE_HOLDS_OBJECT(card_node)) {
-            // 复制卡片对象（调用者需要 unref）
-            result = json_object_ref(json_node_get_object(card_node));
+
+    GPtrArray *results = g_ptr_array_new_full(n_ids, free_card_object);
+    for (guint i = 0; i < n_ids; i++) {
+        JsonObject *card = NULL;
+        if (card_ids[i] > 0) {
+            gint index = card_store_find_by_id(store, card_ids[i]);
+            if (index >= 0) {
+                card = card_store_build_json(store, (guint)index);
+            }
         }
+        g_ptr_array_add(results, card);
     }
-    
-    g_object_unref(parser);
-    return result;
+
+    card_store_unref(store);
+    return results;
+}
+
+/**
+ * 批量读取离线卡片的数值字段（不构建 JSON 对象）
+ */
+gboolean get_card_numeric_fields_offline(const int *card_ids, guint n_ids,
+                                         CardNumericFields *fields_out, gboolean *found_out) {
+    if (!card_ids || !fields_out || !found_out) {
+        return FALSE;
+    }
+
+    CardStore *store = offline_store_acquire();
+    if (!store) {
+        return FALSE;
+    }
+
+    for (guint i = 0; i < n_ids; i++) {
+        gint index = card_ids[i] > 0 ? card_store_find_by_id(store, card_ids[i]) : -1;
+        found_out[i] = (index >= 0);
+        if (index >= 0) {
+            card_store_get_numeric_fields(store, (guint)index, &fields_out[i]);
+        } else {
+            memset(&fields_out[i], 0, sizeof(CardNumericFields));
+        }
+    }
+
+    card_store_unref(store);
+    return TRUE;
 }
 
 /**
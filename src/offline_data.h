@@ -2,7 +2,9 @@
 #define OFFLINE_DATA_H
 
 #include <glib.h>
+#include <gio/gio.h>
 #include <json-glib/json-glib.h>
+#include "card_store.h"
 
 /**
  * 下载并处理离线卡片数据
@@ -52,25 +54,51 @@ JsonArray* get_all_offline_cards(void);
 
 // 以流式方式遍历离线卡片：避免一次性构建 1w+ 结果数组导致首搜卡顿。
 // match_cb 返回 TRUE 表示“接受并计数”；当接受数量达到 max_results 时停止遍历。
+// cancellable 被取消时立即停止（可为 NULL），便于在后台线程中执行并被新的搜索打断。
+// 传给 match_cb 的 card 是从 cards.bin 临时构建的对象，回调返回后即释放，需要保留请自行 json_object_ref。
 typedef gboolean (*OfflineCardMatchFunc)(JsonObject *card, gpointer user_data);
+// 数值预筛选：在构建 JSON 对象之前直接用存储中的数值列判断，返回 FALSE 则跳过该卡（可为 NULL）
+typedef gboolean (*OfflineCardFilterFunc)(const CardNumericFields *fields, gpointer user_data);
 
 guint offline_foreach_card(const char *query,
 						   gboolean search_all,
+						   OfflineCardFilterFunc filter_cb,
 						   OfflineCardMatchFunc match_cb,
 						   gpointer user_data,
-						   guint max_results);
+						   guint max_results,
+						   GCancellable *cancellable);
 
-// 预热离线 JSON 解析缓存（后台线程）：减少第一次搜索的卡顿。
+// 预热离线卡片存储（后台线程）：必要时把 cards.json 编译为 cards.bin 并完成映射，减少第一次搜索的卡顿。
 void offline_data_warm_cache_async(void);
 
-// 清空离线 JSON 解析缓存（例如清理/更新离线数据后）。
+// 释放离线卡片存储缓存（例如清理/更新离线数据后），下次访问时重新映射。
 void offline_data_clear_cache(void);
 
 /**
- * 从离线数据中根据卡片ID获取单张卡片信息
+ * 从离线数据中根据卡片ID获取单张卡片信息（读取 cards.bin，不解析 JSON）
  * @param card_id 卡片ID
  * @return JSON对象，包含卡片数据，需要调用者使用json_object_unref释放；如果失败返回NULL
  */
 JsonObject* get_card_by_id_offline(int card_id);
 
+/**
+ * 批量根据卡片ID获取离线卡片信息（一次加锁，按哈希索引逐个查找）
+ * @param card_ids 卡片ID数组
+ * @param n_ids 数组长度
+ * @return 与 card_ids 一一对应的 JsonObject 指针数组，找不到的位置为 NULL；
+ *         需要调用者使用 g_ptr_array_unref 释放（会同时释放其中的对象）；失败返回NULL
+ */
+GPtrArray* get_cards_by_ids_offline(const int *card_ids, guint n_ids);
+
+/**
+ * 批量读取离线卡片的数值字段（一次加锁，直接读取 cards.bin 的数值列，不构建 JSON 对象）
+ * @param card_ids 卡片ID数组
+ * @param n_ids 数组长度
+ * @param fields_out 输出数组（n_ids 个），找不到的位置清零
+ * @param found_out 输出数组（n_ids 个），标记每个ID是否找到
+ * @return TRUE 如果离线数据可用，否则FALSE（输出数组不会被写入）
+ */
+gboolean get_card_numeric_fields_offline(const int *card_ids, guint n_ids,
+                                         CardNumericFields *fields_out, gboolean *found_out);
+
 #endif // OFFLINE_DATA_H
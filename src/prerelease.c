@@ -1,18 +1,31 @@
 #include "prerelease.h"
 #include "app_path.h"
+#include "search_keys.h"
 #include <libsoup/soup.h>
 #include <json-glib/json-glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include <sqlite3.h>
 #include <archive.h>
 #include <archive_entry.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <glib/gstdio.h>
 
 #define PRERELEASE_URL "https://cdntx.moecube.com/ygopro-super-pre/archive/ygopro-super-pre.ypk"
 #define PRERELEASE_JSON_FILENAME "pre-release.json"
+#define PRERELEASE_CDB_FILENAME "test-release.cdb"
+#define PRERELEASE_YPK_FILENAME "ygopro-super-pre.ypk"
+// 解压后的先行卡图片字节缓存上限
+#define PRERELEASE_IMAGE_CACHE_BYTES (8 * 1024 * 1024)
+
+// 卡片查询的公共列，与 card_object_from_row 的列下标对应
+#define PRERELEASE_CARD_SELECT "SELECT d.id, d.ot, d.alias, d.setcode, d.type, d.atk, d.def, d.level, " \
+                               "d.race, d.attribute, t.name, t.desc " \
+                               "FROM datas d LEFT JOIN texts t ON d.id = t.id"
 
 /**
  * 获取先行卡数据目录的绝对路径
@@ -44,6 +57,651 @@ static gchar *get_prerelease_json_path(void) {
     return filepath;
 }
 
+/**
+ * 获取先行卡CDB文件路径
+ */
+static gchar *get_prerelease_cdb_path(void) {
+    gchar *data_dir = get_prerelease_data_dir();
+    if (!data_dir) {
+        return NULL;
+    }
+    
+    gchar *filepath = g_build_filename(data_dir, PRERELEASE_CDB_FILENAME, NULL);
+    g_free(data_dir);
+    
+    return filepath;
+}
+
+/**
+ * 获取先行卡YPK归档路径
+ */
+static gchar *get_prerelease_ypk_path(void) {
+    gchar *data_dir = get_prerelease_data_dir();
+    if (!data_dir) {
+        return NULL;
+    }
+    
+    gchar *filepath = g_build_filename(data_dir, PRERELEASE_YPK_FILENAME, NULL);
+    g_free(data_dir);
+    
+    return filepath;
+}
+
+static JsonNode *parse_cdb_to_json(const char *cdb_path);
+
+// 常驻的先行卡索引：解析后的 JSON、按卡片ID的哈希表与折叠后的搜索键（text.name + text.desc），
+// 下标与 JSON 数组一致。下载完成后在后台线程建立；文件 mtime 变化或重新下载后重新加载。
+// 查找、搜索和获取全部先行卡都只读这份数据，不再每次重新解析文件。
+// 使用 CDB 后端下载时不会生成 JSON，此时直接从 CDB 建立同样的索引。
+static GMutex prerelease_cache_mutex;
+static JsonNode *prerelease_cache_root = NULL;
+static JsonArray *prerelease_cache_cards = NULL; // owned by root
+static GHashTable *prerelease_cache_by_id = NULL; // card id -> 数组下标 + 1
+static SearchKeys *prerelease_cache_keys = NULL;
+static gint64 prerelease_cache_mtime = 0;
+
+static void prerelease_cache_clear_locked(void) {
+    g_clear_pointer(&prerelease_cache_root, json_node_unref);
+    prerelease_cache_cards = NULL;
+    g_clear_pointer(&prerelease_cache_by_id, g_hash_table_destroy);
+    g_clear_pointer(&prerelease_cache_keys, search_keys_free);
+    prerelease_cache_mtime = 0;
+}
+
+static gboolean prerelease_cache_ensure_loaded_locked(void) {
+    gchar *json_path = get_prerelease_json_path();
+    gchar *cdb_path = get_prerelease_cdb_path();
+    GStatBuf st;
+    gboolean from_json = json_path && g_stat(json_path, &st) == 0;
+    if (!from_json && (!cdb_path || g_stat(cdb_path, &st) != 0)) {
+        g_free(json_path);
+        g_free(cdb_path);
+        prerelease_cache_clear_locked();
+        return FALSE;
+    }
+
+    gint64 mtime = (gint64)st.st_mtime;
+    if (prerelease_cache_root && prerelease_cache_mtime == mtime) {
+        g_free(json_path);
+        g_free(cdb_path);
+        return TRUE;
+    }
+    prerelease_cache_clear_locked();
+
+    JsonNode *root = NULL;
+    if (from_json) {
+        JsonParser *parser = json_parser_new();
+        GError *error = NULL;
+        if (json_parser_load_from_file(parser, json_path, &error)) {
+            root = json_parser_steal_root(parser);
+        } else {
+            g_warning("Failed to load pre-release JSON: %s", error->message);
+            g_error_free(error);
+        }
+        g_object_unref(parser);
+    } else {
+        root = parse_cdb_to_json(cdb_path);
+    }
+    g_free(json_path);
+    g_free(cdb_path);
+
+    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
+        if (root) json_node_unref(root);
+        return FALSE;
+    }
+
+    JsonArray *cards = json_node_get_array(root);
+    guint len = json_array_get_length(cards);
+    SearchKeys *keys = search_keys_new(len);
+    GHashTable *by_id = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < len; i++) {
+        const char *fields[2] = { NULL, NULL };
+        JsonNode *node = json_array_get_element(cards, i);
+        if (node && JSON_NODE_HOLDS_OBJECT(node)) {
+            JsonObject *card = json_node_get_object(node);
+            if (json_object_has_member(card, "id")) {
+                int id = (int)json_object_get_int_member(card, "id");
+                // 与逐个遍历的旧实现一致：同一ID出现多次时取第一张
+                if (!g_hash_table_contains(by_id, GINT_TO_POINTER(id))) {
+                    g_hash_table_insert(by_id, GINT_TO_POINTER(id), GUINT_TO_POINTER(i + 1));
+                }
+            }
+            if (json_object_has_member(card, "text")) {
+                JsonObject *text = json_object_get_object_member(card, "text");
+                if (text && json_object_has_member(text, "name")) fields[0] = json_object_get_string_member(text, "name");
+                if (text && json_object_has_member(text, "desc")) fields[1] = json_object_get_string_member(text, "desc");
+            }
+        }
+        // 非对象元素也要占位，保证下标与数组对齐
+        search_keys_append(keys, fields, G_N_ELEMENTS(fields));
+    }
+
+    prerelease_cache_root = root;
+    prerelease_cache_cards = cards;
+    prerelease_cache_by_id = by_id;
+    prerelease_cache_keys = keys;
+    prerelease_cache_mtime = mtime;
+    g_message("Pre-release index loaded: %u cards", len);
+    return TRUE;
+}
+
+// 可选的 CDB 后端（YGO_PRERELEASE_BACKEND=cdb）：以只读方式常开 test-release.cdb，
+// 按 ID 查找、搜索和枚举都使用缓存的预编译语句，按 ID 查找是一次主键 B 树查找。
+// 打开时把卡名/效果折叠一次存入临时表 temp.fold，并在其上建立 trigram 分词的 FTS5 索引：
+// 3 个字符及以上的搜索词走 FTS 索引，更短的搜索词扫描已折叠的临时表，查询时不再逐行折叠。
+// 下载时不再把 CDB 转成 JSON 写盘，也不需要在内存中保留整份 JSON。
+// 连接与语句只在 prerelease_cdb_mutex 下使用；CDB 的 mtime 变化时重新打开。
+static GMutex prerelease_cdb_mutex;
+static sqlite3 *prerelease_cdb = NULL;
+static sqlite3_stmt *prerelease_cdb_by_id_stmt = NULL;
+static sqlite3_stmt *prerelease_cdb_search_stmt = NULL;     // 扫描已折叠的临时表
+static sqlite3_stmt *prerelease_cdb_fts_search_stmt = NULL; // FTS5 trigram 索引，SQLite 不支持时为 NULL
+static sqlite3_stmt *prerelease_cdb_all_stmt = NULL;
+static gint64 prerelease_cdb_mtime = 0;
+
+static gboolean prerelease_cdb_enabled = FALSE;
+static gsize prerelease_cdb_enabled_inited = 0;
+
+static gboolean is_prerelease_cdb_enabled(void) {
+    if (g_once_init_enter(&prerelease_cdb_enabled_inited)) {
+        const char *v = g_getenv("YGO_PRERELEASE_BACKEND");
+        prerelease_cdb_enabled = v && g_ascii_strcasecmp(v, "cdb") == 0;
+        g_once_init_leave(&prerelease_cdb_enabled_inited, 1);
+    }
+    return prerelease_cdb_enabled;
+}
+
+static void prerelease_cdb_close_locked(void) {
+    g_clear_pointer(&prerelease_cdb_by_id_stmt, sqlite3_finalize);
+    g_clear_pointer(&prerelease_cdb_search_stmt, sqlite3_finalize);
+    g_clear_pointer(&prerelease_cdb_fts_search_stmt, sqlite3_finalize);
+    g_clear_pointer(&prerelease_cdb_all_stmt, sqlite3_finalize);
+    g_clear_pointer(&prerelease_cdb, sqlite3_close);
+    prerelease_cdb_mtime = 0;
+}
+
+// SQL 函数 ygo_fold(text)：与 JSON 索引的搜索键使用同样的折叠规则，
+// 保证两个后端的搜索结果一致（LIKE 只做 ASCII 大小写折叠）
+static void prerelease_cdb_fold_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    (void)argc;
+    const char *text = (const char *)sqlite3_value_text(argv[0]);
+    if (!text) {
+        sqlite3_result_null(context);
+        return;
+    }
+    sqlite3_result_text(context, search_key_fold(text), -1, g_free);
+}
+
+static gboolean prerelease_cdb_prepare_locked(const char *sql, sqlite3_stmt **stmt) {
+    if (sqlite3_prepare_v3(prerelease_cdb, sql, -1, SQLITE_PREPARE_PERSISTENT, stmt, NULL) != SQLITE_OK) {
+        g_warning("Failed to prepare pre-release statement: %s", sqlite3_errmsg(prerelease_cdb));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean prerelease_cdb_exec_locked(const char *sql, gboolean warn) {
+    char *errmsg = NULL;
+    if (sqlite3_exec(prerelease_cdb, sql, NULL, NULL, &errmsg) != SQLITE_OK) {
+        if (warn) g_warning("Pre-release database statement failed: %s", errmsg ? errmsg : "unknown error");
+        sqlite3_free(errmsg);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * 建立搜索用的临时表：卡名/效果只在打开时折叠一次；
+ * 可用时再建立 FTS5 trigram 索引（只读连接也可以创建 TEMP 对象）
+ * @return 是否建立了 FTS 索引
+ */
+static gboolean prerelease_cdb_build_search_index_locked(void) {
+    if (!prerelease_cdb_exec_locked(
+            "CREATE TEMP TABLE fold(id INTEGER PRIMARY KEY, name TEXT, desc TEXT);"
+            "INSERT INTO temp.fold SELECT d.id, ygo_fold(t.name), ygo_fold(t.desc)"
+            " FROM datas d LEFT JOIN texts t ON d.id = t.id;", TRUE)) {
+        return FALSE;
+    }
+    // 旧版本 SQLite 没有 FTS5 或 trigram 分词器时只使用临时表
+    if (!prerelease_cdb_exec_locked(
+            "CREATE VIRTUAL TABLE temp.fold_fts USING fts5(name, desc, content='fold', content_rowid='id',"
+            " tokenize='trigram');"
+            "INSERT INTO temp.fold_fts(fold_fts) VALUES('rebuild');", FALSE)) {
+        g_message("Pre-release CDB: FTS5 trigram unavailable, searching folded text table");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean prerelease_cdb_ensure_open_locked(void) {
+    gchar *cdb_path = get_prerelease_cdb_path();
+    GStatBuf st;
+    if (!cdb_path || g_stat(cdb_path, &st) != 0) {
+        g_free(cdb_path);
+        prerelease_cdb_close_locked();
+        return FALSE;
+    }
+
+    gint64 mtime = (gint64)st.st_mtime;
+    if (prerelease_cdb && prerelease_cdb_mtime == mtime) {
+        g_free(cdb_path);
+        return TRUE;
+    }
+    prerelease_cdb_close_locked();
+
+    if (sqlite3_open_v2(cdb_path, &prerelease_cdb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) {
+        g_warning("Cannot open pre-release database: %s", sqlite3_errmsg(prerelease_cdb));
+        prerelease_cdb_close_locked();
+        g_free(cdb_path);
+        return FALSE;
+    }
+
+    sqlite3_create_function_v2(prerelease_cdb, "ygo_fold", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                               NULL, prerelease_cdb_fold_func, NULL, NULL, NULL);
+
+    gint64 start_us = g_get_monotonic_time();
+    gboolean has_fts = prerelease_cdb_build_search_index_locked();
+
+    // ID 条件（?2）走主键，文本条件只在子查询中匹配折叠后的文本
+    if (!prerelease_cdb_prepare_locked(PRERELEASE_CARD_SELECT " WHERE d.id = ?1", &prerelease_cdb_by_id_stmt) ||
+        !prerelease_cdb_prepare_locked(PRERELEASE_CARD_SELECT
+                                       " WHERE d.id = ?2 OR d.id IN"
+                                       " (SELECT id FROM temp.fold WHERE instr(name, ?1) > 0 OR instr(desc, ?1) > 0)",
+                                       &prerelease_cdb_search_stmt) ||
+        (has_fts && !prerelease_cdb_prepare_locked(PRERELEASE_CARD_SELECT
+                                                   " WHERE d.id = ?2 OR d.id IN"
+                                                   " (SELECT rowid FROM temp.fold_fts WHERE fold_fts MATCH ?1)",
+                                                   &prerelease_cdb_fts_search_stmt)) ||
+        !prerelease_cdb_prepare_locked(PRERELEASE_CARD_SELECT, &prerelease_cdb_all_stmt)) {
+        prerelease_cdb_close_locked();
+        g_free(cdb_path);
+        return FALSE;
+    }
+    g_message("Pre-release CDB search index built in %.1f ms (%s)",
+              (g_get_monotonic_time() - start_us) / 1000.0, has_fts ? "FTS5 trigram" : "folded text");
+
+    prerelease_cdb_mtime = mtime;
+    g_message("Pre-release CDB opened read-only: %s", cdb_path);
+    g_free(cdb_path);
+    return TRUE;
+}
+
+/**
+ * 启用 CDB 后端且数据库可用时加锁并返回 TRUE（调用者负责解锁），
+ * 否则返回 FALSE，调用者改用 JSON 索引
+ */
+static gboolean prerelease_cdb_lock(void) {
+    if (!is_prerelease_cdb_enabled()) {
+        return FALSE;
+    }
+    g_mutex_lock(&prerelease_cdb_mutex);
+    if (!prerelease_cdb_ensure_open_locked()) {
+        g_mutex_unlock(&prerelease_cdb_mutex);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// 先行卡图片直接从 YPK（ZIP）归档读取：只读映射归档并解析一次中央目录，建立按卡片ID
+// 排序的 pics/<id>.<ext> 条目表（本地头偏移、压缩大小、压缩方式），读取图片时二分查找后
+// 只解压对应的条目，不再把 pics/ 解压到磁盘。索引在下载完成后重建。
+// 解压后的字节放在按字节数限制的小 LRU 中；未压缩的条目直接引用映射内存，不进缓存。
+// 旧版本解压在 pics/ 下的卡图同样在加载时扫描一次目录，记入按ID排序的数组，
+// 之后判断有无卡图和构造路径都不再访问文件系统。
+typedef struct {
+    gint32 id;
+    guint16 method;           // 0 = 不压缩，8 = deflate
+    guint32 local_offset;     // 本地文件头偏移
+    guint32 compressed_size;
+    guint32 size;
+} PrereleaseArchiveEntry;
+
+typedef struct {
+    int id;
+    GBytes *bytes;
+} PrereleaseImageCacheEntry;
+
+static GMutex prerelease_archive_mutex;
+static gboolean prerelease_archive_loaded = FALSE;
+static GMappedFile *prerelease_archive_map = NULL;
+static GArray *prerelease_archive_entries = NULL; // PrereleaseArchiveEntry，按 id 升序
+static GQueue prerelease_image_cache = G_QUEUE_INIT; // PrereleaseImageCacheEntry*，队首为最近使用
+static GHashTable *prerelease_image_cache_index = NULL; // card id -> GList*
+static gsize prerelease_image_cache_bytes = 0;
+static GArray *prerelease_legacy_image_ids = NULL; // gint32，按 id 升序
+static gchar *prerelease_pics_dir = NULL;
+
+static guint16 read_le16(const guint8 *p) {
+    return (guint16)(p[0] | (p[1] << 8));
+}
+
+static guint32 read_le32(const guint8 *p) {
+    return (guint32)p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+}
+
+static int archive_entry_compare(gconstpointer a, gconstpointer b) {
+    gint32 ia = ((const PrereleaseArchiveEntry *)a)->id;
+    gint32 ib = ((const PrereleaseArchiveEntry *)b)->id;
+    return (ia > ib) - (ia < ib);
+}
+
+/**
+ * 解析归档内的文件名 "pics/<id>.<ext>"（不含子目录）
+ * @return 卡片ID，不是卡图时返回 0
+ */
+static int archive_name_to_card_id(const char *name, gsize len) {
+    if (len >= 2 && name[0] == '.' && name[1] == '/') {
+        name += 2;
+        len -= 2;
+    }
+    if (len <= 5 || memcmp(name, "pics/", 5) != 0) {
+        return 0;
+    }
+    
+    gsize i = 5;
+    gint64 id = 0;
+    while (i < len && g_ascii_isdigit(name[i]) && id < G_MAXINT32 / 10) {
+        id = id * 10 + (name[i] - '0');
+        i++;
+    }
+    if (i == 5 || i >= len || name[i] != '.' || memchr(name + i, '/', len - i)) {
+        return 0;
+    }
+    return (int)id;
+}
+
+static int image_id_compare(gconstpointer a, gconstpointer b) {
+    gint32 ia = *(const gint32 *)a;
+    gint32 ib = *(const gint32 *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+/**
+ * 扫描旧版本解压的 pics/ 目录，记录有卡图（<id>.jpg）的卡片ID
+ */
+static void prerelease_legacy_images_scan_locked(void) {
+    gchar *data_dir = get_prerelease_data_dir();
+    if (!data_dir) {
+        return;
+    }
+    gchar *pics_dir = g_build_filename(data_dir, "pics", NULL);
+    g_free(data_dir);
+    
+    GDir *dir = g_dir_open(pics_dir, 0, NULL);
+    if (!dir) {
+        g_free(pics_dir);
+        return;
+    }
+    
+    GArray *ids = g_array_new(FALSE, FALSE, sizeof(gint32));
+    const gchar *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        if (!g_ascii_isdigit(name[0])) continue;
+        gchar *end = NULL;
+        guint64 id = g_ascii_strtoull(name, &end, 10);
+        if (g_strcmp0(end, ".jpg") != 0 || id == 0 || id > G_MAXINT32) continue;
+        gint32 value = (gint32)id;
+        g_array_append_val(ids, value);
+    }
+    g_dir_close(dir);
+    g_array_sort(ids, image_id_compare);
+    
+    prerelease_legacy_image_ids = ids;
+    prerelease_pics_dir = pics_dir;
+    g_message("Pre-release pics/ indexed: %u images", ids->len);
+}
+
+static gboolean prerelease_legacy_has_image_locked(int card_id) {
+    if (!prerelease_legacy_image_ids || prerelease_legacy_image_ids->len == 0) {
+        return FALSE;
+    }
+    gint32 key = card_id;
+    return bsearch(&key, prerelease_legacy_image_ids->data, prerelease_legacy_image_ids->len,
+                   sizeof(gint32), image_id_compare) != NULL;
+}
+
+static void prerelease_archive_close_locked(void) {
+    PrereleaseImageCacheEntry *entry;
+    while ((entry = g_queue_pop_head(&prerelease_image_cache)) != NULL) {
+        g_bytes_unref(entry->bytes);
+        g_free(entry);
+    }
+    g_clear_pointer(&prerelease_image_cache_index, g_hash_table_destroy);
+    prerelease_image_cache_bytes = 0;
+    g_clear_pointer(&prerelease_archive_entries, g_array_unref);
+    g_clear_pointer(&prerelease_archive_map, g_mapped_file_unref);
+    g_clear_pointer(&prerelease_legacy_image_ids, g_array_unref);
+    g_clear_pointer(&prerelease_pics_dir, g_free);
+    prerelease_archive_loaded = FALSE;
+}
+
+static void prerelease_archive_ensure_loaded_locked(void) {
+    if (prerelease_archive_loaded) {
+        return;
+    }
+    // 没有归档（例如旧版本解压的数据）时也只尝试一次，下载完成后会重新加载
+    prerelease_archive_loaded = TRUE;
+    prerelease_legacy_images_scan_locked();
+    
+    gchar *ypk_path = get_prerelease_ypk_path();
+    if (!ypk_path || !g_file_test(ypk_path, G_FILE_TEST_EXISTS)) {
+        g_free(ypk_path);
+        return;
+    }
+    
+    GError *error = NULL;
+    GMappedFile *map = g_mapped_file_new(ypk_path, FALSE, &error);
+    if (!map) {
+        g_warning("Failed to map pre-release archive: %s", error->message);
+        g_error_free(error);
+        g_free(ypk_path);
+        return;
+    }
+    
+    const guint8 *data = (const guint8 *)g_mapped_file_get_contents(map);
+    gsize size = g_mapped_file_get_length(map);
+    
+    // 中央目录结束记录位于文件末尾，其后最多跟 64 KiB 的注释
+    const guint8 *eocd = NULL;
+    if (data && size >= 22) {
+        gsize stop = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+        for (gsize pos = size - 22; ; pos--) {
+            if (read_le32(data + pos) == 0x06054b50) {
+                eocd = data + pos;
+                break;
+            }
+            if (pos == stop) break;
+        }
+    }
+    guint32 cd_size = eocd ? read_le32(eocd + 12) : 0;
+    guint32 cd_offset = eocd ? read_le32(eocd + 16) : 0;
+    if (!eocd || cd_offset == 0xFFFFFFFF || (guint64)cd_offset + cd_size > size) {
+        // ZIP64 归档（超过 4 GiB）不支持
+        g_warning("Unsupported or truncated pre-release archive: %s", ypk_path);
+        g_mapped_file_unref(map);
+        g_free(ypk_path);
+        return;
+    }
+    
+    GArray *entries = g_array_new(FALSE, FALSE, sizeof(PrereleaseArchiveEntry));
+    const guint8 *p = data + cd_offset;
+    const guint8 *end = p + cd_size;
+    while (p + 46 <= end && read_le32(p) == 0x02014b50) {
+        guint16 flags = read_le16(p + 8);
+        guint16 method = read_le16(p + 10);
+        guint16 name_len = read_le16(p + 28);
+        gsize record_len = 46 + name_len + read_le16(p + 30) + read_le16(p + 32);
+        if (p + 46 + name_len > end) break;
+        
+        int id = archive_name_to_card_id((const char *)p + 46, name_len);
+        // 跳过加密条目和不支持的压缩方式
+        if (id > 0 && !(flags & 0x1) && (method == 0 || method == 8)) {
+            PrereleaseArchiveEntry entry = { id, method, read_le32(p + 42), read_le32(p + 20), read_le32(p + 24) };
+            g_array_append_val(entries, entry);
+        }
+        p += record_len;
+    }
+    g_array_sort(entries, archive_entry_compare);
+    
+    // 同一ID有多张图片（不同扩展名）时只保留一条
+    guint kept = 0;
+    for (guint i = 0; i < entries->len; i++) {
+        PrereleaseArchiveEntry *entry = &g_array_index(entries, PrereleaseArchiveEntry, i);
+        if (kept > 0 && g_array_index(entries, PrereleaseArchiveEntry, kept - 1).id == entry->id) continue;
+        g_array_index(entries, PrereleaseArchiveEntry, kept++) = *entry;
+    }
+    g_array_set_size(entries, kept);
+    
+    prerelease_archive_map = map;
+    prerelease_archive_entries = entries;
+    g_message("Pre-release archive indexed: %u images", entries->len);
+    g_free(ypk_path);
+}
+
+static const PrereleaseArchiveEntry *prerelease_archive_find_locked(int card_id) {
+    if (!prerelease_archive_entries || prerelease_archive_entries->len == 0) {
+        return NULL;
+    }
+    PrereleaseArchiveEntry key = { .id = card_id };
+    return bsearch(&key, prerelease_archive_entries->data, prerelease_archive_entries->len,
+                   sizeof(PrereleaseArchiveEntry), archive_entry_compare);
+}
+
+/**
+ * 解压 raw deflate 数据（ZIP 条目不带 zlib 头）
+ */
+static GBytes *inflate_raw(const guint8 *in, gsize in_size, gsize out_size) {
+    if (out_size == 0) {
+        return NULL;
+    }
+    
+    GConverter *conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW));
+    guint8 *out = g_malloc(out_size);
+    gsize in_pos = 0;
+    gsize out_pos = 0;
+    gboolean finished = FALSE;
+    GError *error = NULL;
+    while (!finished) {
+        gsize bytes_read = 0;
+        gsize bytes_written = 0;
+        GConverterResult res = g_converter_convert(conv, in + in_pos, in_size - in_pos,
+                                                   out + out_pos, out_size - out_pos,
+                                                   G_CONVERTER_INPUT_AT_END,
+                                                   &bytes_read, &bytes_written, &error);
+        if (res == G_CONVERTER_ERROR) break;
+        in_pos += bytes_read;
+        out_pos += bytes_written;
+        finished = (res == G_CONVERTER_FINISHED);
+        if (!finished && bytes_read == 0 && bytes_written == 0) break;
+    }
+    g_object_unref(conv);
+    
+    if (!finished || out_pos != out_size) {
+        g_warning("Failed to inflate pre-release image: %s", error ? error->message : "size mismatch");
+        g_clear_error(&error);
+        g_free(out);
+        return NULL;
+    }
+    return g_bytes_new_take(out, out_size);
+}
+
+/**
+ * 读取条目数据（不持有锁调用，map 由调用者持有引用）
+ */
+static GBytes *prerelease_archive_entry_bytes(GMappedFile *map, const PrereleaseArchiveEntry *entry) {
+    const guint8 *data = (const guint8 *)g_mapped_file_get_contents(map);
+    gsize size = g_mapped_file_get_length(map);
+    guint64 header = entry->local_offset;
+    if (header + 30 > size || read_le32(data + header) != 0x04034b50) {
+        return NULL;
+    }
+    
+    // 本地头的扩展字段长度可能与中央目录中的不同，以本地头为准
+    guint64 start = header + 30 + read_le16(data + header + 26) + read_le16(data + header + 28);
+    if (start + entry->compressed_size > size) {
+        return NULL;
+    }
+    
+    if (entry->method == 0) {
+        GBytes *all = g_mapped_file_get_bytes(map);
+        GBytes *slice = g_bytes_new_from_bytes(all, (gsize)start, entry->compressed_size);
+        g_bytes_unref(all);
+        return slice;
+    }
+    return inflate_raw(data + start, entry->compressed_size, entry->size);
+}
+
+static void prerelease_image_cache_insert_locked(int card_id, GBytes *bytes) {
+    gsize size = g_bytes_get_size(bytes);
+    // 过大的图片不缓存，避免一张图挤掉整个缓存
+    if (size > PRERELEASE_IMAGE_CACHE_BYTES / 4) {
+        return;
+    }
+    if (!prerelease_image_cache_index) {
+        prerelease_image_cache_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    if (g_hash_table_contains(prerelease_image_cache_index, GINT_TO_POINTER(card_id))) {
+        return;
+    }
+    
+    PrereleaseImageCacheEntry *entry = g_new0(PrereleaseImageCacheEntry, 1);
+    entry->id = card_id;
+    entry->bytes = g_bytes_ref(bytes);
+    g_queue_push_head(&prerelease_image_cache, entry);
+    g_hash_table_insert(prerelease_image_cache_index, GINT_TO_POINTER(card_id), prerelease_image_cache.head);
+    prerelease_image_cache_bytes += size;
+    
+    while (prerelease_image_cache_bytes > PRERELEASE_IMAGE_CACHE_BYTES) {
+        PrereleaseImageCacheEntry *old = g_queue_pop_tail(&prerelease_image_cache);
+        g_hash_table_remove(prerelease_image_cache_index, GINT_TO_POINTER(old->id));
+        prerelease_image_cache_bytes -= g_bytes_get_size(old->bytes);
+        g_bytes_unref(old->bytes);
+        g_free(old);
+    }
+}
+
+/**
+ * 从归档读取卡图的原始文件字节（可在任意线程调用）
+ * @return 图片字节，调用者需要 g_bytes_unref；归档中没有该卡图时返回 NULL
+ */
+static GBytes *prerelease_archive_read(int card_id) {
+    g_mutex_lock(&prerelease_archive_mutex);
+    prerelease_archive_ensure_loaded_locked();
+    const PrereleaseArchiveEntry *found = prerelease_archive_find_locked(card_id);
+    if (!found) {
+        g_mutex_unlock(&prerelease_archive_mutex);
+        return NULL;
+    }
+    
+    GList *link = prerelease_image_cache_index
+        ? g_hash_table_lookup(prerelease_image_cache_index, GINT_TO_POINTER(card_id)) : NULL;
+    if (link) {
+        g_queue_unlink(&prerelease_image_cache, link);
+        g_queue_push_head_link(&prerelease_image_cache, link);
+        GBytes *bytes = g_bytes_ref(((PrereleaseImageCacheEntry *)link->data)->bytes);
+        g_mutex_unlock(&prerelease_archive_mutex);
+        return bytes;
+    }
+    
+    // 解压在锁外进行，其他线程可以同时读取别的卡图
+    PrereleaseArchiveEntry entry = *found;
+    GMappedFile *map = g_mapped_file_ref(prerelease_archive_map);
+    g_mutex_unlock(&prerelease_archive_mutex);
+    
+    GBytes *bytes = prerelease_archive_entry_bytes(map, &entry);
+    if (bytes && entry.method != 0) {
+        g_mutex_lock(&prerelease_archive_mutex);
+        // 期间归档被重新下载时不再缓存旧数据
+        if (prerelease_archive_map == map) {
+            prerelease_image_cache_insert_locked(card_id, bytes);
+        }
+        g_mutex_unlock(&prerelease_archive_mutex);
+    }
+    g_mapped_file_unref(map);
+    
+    return bytes;
+}
+
 /**
  * 确保目录存在
  */
@@ -109,7 +767,7 @@ static void clear_prerelease_directory(void) {
 }
 
 /**
- * 解压YPK文件（ZIP格式），只保留pic目录和test-release.cdb
+ * 从YPK文件（ZIP格式）中解压test-release.cdb（卡图直接从归档读取，不再解压）
  */
 static gboolean extract_ypk_file(const char *ypk_path, const char *dest_dir) {
     struct archive *a;
@@ -132,18 +790,14 @@ static gboolean extract_ypk_file(const char *ypk_path, const char *dest_dir) {
     while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
         const char *current_file = archive_entry_pathname(entry);
         
-        // 只处理pics目录下的文件和test-release.cdb
+        // 只处理test-release.cdb
         gboolean should_extract = FALSE;
         gchar *output_path = NULL;
         
-        if (g_str_has_prefix(current_file, "pics/")) {
-            // 提取pics目录下的文件
-            output_path = g_build_filename(dest_dir, current_file, NULL);
-            should_extract = TRUE;
-        } else if (g_strcmp0(current_file, "test-release.cdb") == 0 ||
+        if (g_strcmp0(current_file, "test-release.cdb") == 0 ||
                    g_strcmp0(current_file, "./test-release.cdb") == 0) {
             // 提取test-release.cdb
-            output_path = g_build_filename(dest_dir, "test-release.cdb", NULL);
+            output_path = g_build_filename(dest_dir, PRERELEASE_CDB_FILENAME, NULL);
             should_extract = TRUE;
         }
         
@@ -191,6 +845,64 @@ static gboolean extract_ypk_file(const char *ypk_path, const char *dest_dir) {
     return TRUE;
 }
 
+/**
+ * 把 PRERELEASE_CARD_SELECT 查询的当前行转换为卡片对象
+ */
+static JsonObject *card_object_from_row(sqlite3_stmt *stmt) {
+    JsonObject *card = json_object_new();
+    
+    // id，cid 使用 id
+    int id = sqlite3_column_int(stmt, 0);
+    json_object_set_int_member(card, "id", id);
+    json_object_set_int_member(card, "cid", id);
+    
+    json_object_set_int_member(card, "ot", sqlite3_column_int(stmt, 1));
+    json_object_set_int_member(card, "alias", sqlite3_column_int(stmt, 2));
+    json_object_set_int_member(card, "setcode", sqlite3_column_int(stmt, 3));
+    
+    int type = sqlite3_column_int(stmt, 4);
+    json_object_set_int_member(card, "type", type);
+    json_object_set_int_member(card, "atk", sqlite3_column_int(stmt, 5));
+    json_object_set_int_member(card, "def", sqlite3_column_int(stmt, 6));
+    // level (包含等级/阶级/连接值等)
+    json_object_set_int_member(card, "level", sqlite3_column_int(stmt, 7));
+    json_object_set_int_member(card, "race", sqlite3_column_int(stmt, 8));
+    json_object_set_int_member(card, "attribute", sqlite3_column_int(stmt, 9));
+    
+    // text object with name and desc
+    JsonObject *text = json_object_new();
+    const char *name = (const char *)sqlite3_column_text(stmt, 10);
+    json_object_set_string_member(text, "name", name ? name : "");
+    const char *desc = (const char *)sqlite3_column_text(stmt, 11);
+    json_object_set_string_member(text, "desc", desc ? desc : "");
+    
+    // 根据类型生成types字段
+    GString *types_str = g_string_new("");
+    if (type & 0x1) g_string_append(types_str, "怪兽 ");
+    if (type & 0x2) g_string_append(types_str, "魔法 ");
+    if (type & 0x4) g_string_append(types_str, "陷阱 ");
+    if (type & 0x40) g_string_append(types_str, "效果 ");
+    if (type & 0x800) g_string_append(types_str, "特殊召唤 ");
+    json_object_set_string_member(text, "types", types_str->str);
+    g_string_free(types_str, TRUE);
+    
+    json_object_set_object_member(card, "text", text);
+    return card;
+}
+
+/**
+ * 执行已绑定参数的语句，收集所有结果行后重置语句以便复用
+ */
+static JsonArray *collect_card_rows(sqlite3_stmt *stmt) {
+    JsonArray *results = json_array_new();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        json_array_add_object_element(results, card_object_from_row(stmt));
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return results;
+}
+
 /**
  * 从SQLite CDB文件中提取卡片数据并转换为JSON
  */
@@ -199,118 +911,29 @@ static JsonNode *parse_cdb_to_json(const char *cdb_path) {
     sqlite3_stmt *stmt;
     int rc;
     
-    rc = sqlite3_open(cdb_path, &db);
+    rc = sqlite3_open_v2(cdb_path, &db, SQLITE_OPEN_READONLY, NULL);
     if (rc != SQLITE_OK) {
         g_warning("Cannot open database: %s", sqlite3_errmsg(db));
         sqlite3_close(db);
         return NULL;
     }
     
-    JsonBuilder *builder = json_builder_new();
-    json_builder_begin_array(builder);
-    
-    // 查询卡片数据
-    const char *sql = "SELECT d.id, d.ot, d.alias, d.setcode, d.type, d.atk, d.def, d.level, "
-                      "d.race, d.attribute, t.name, t.desc "
-                      "FROM datas d LEFT JOIN texts t ON d.id = t.id";
-    
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = sqlite3_prepare_v2(db, PRERELEASE_CARD_SELECT, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         g_warning("Failed to prepare statement: %s", sqlite3_errmsg(db));
         sqlite3_close(db);
-        g_object_unref(builder);
         return NULL;
     }
     
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        json_builder_begin_object(builder);
-        
-        // id
-        int id = sqlite3_column_int(stmt, 0);
-        json_builder_set_member_name(builder, "id");
-        json_builder_add_int_value(builder, id);
-        
-        // cid (使用id作为cid)
-        json_builder_set_member_name(builder, "cid");
-        json_builder_add_int_value(builder, id);
-        
-        // ot
-        json_builder_set_member_name(builder, "ot");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 1));
-        
-        // alias
-        json_builder_set_member_name(builder, "alias");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 2));
-        
-        // setcode
-        json_builder_set_member_name(builder, "setcode");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 3));
-        
-        // type
-        int type = sqlite3_column_int(stmt, 4);
-        json_builder_set_member_name(builder, "type");
-        json_builder_add_int_value(builder, type);
-        
-        // atk
-        json_builder_set_member_name(builder, "atk");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 5));
-        
-        // def
-        json_builder_set_member_name(builder, "def");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 6));
-        
-        // level (包含等级/阶级/连接值等)
-        json_builder_set_member_name(builder, "level");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 7));
-        
-        // race
-        json_builder_set_member_name(builder, "race");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 8));
-        
-        // attribute
-        json_builder_set_member_name(builder, "attribute");
-        json_builder_add_int_value(builder, sqlite3_column_int(stmt, 9));
-        
-        // text object with name and desc
-        json_builder_set_member_name(builder, "text");
-        json_builder_begin_object(builder);
-        
-        const char *name = (const char *)sqlite3_column_text(stmt, 10);
-        json_builder_set_member_name(builder, "name");
-        json_builder_add_string_value(builder, name ? name : "");
-        
-        const char *desc = (const char *)sqlite3_column_text(stmt, 11);
-        json_builder_set_member_name(builder, "desc");
-        json_builder_add_string_value(builder, desc ? desc : "");
-        
-        // 根据类型生成types字段
-        GString *types_str = g_string_new("");
-        if (type & 0x1) g_string_append(types_str, "怪兽 ");
-        if (type & 0x2) g_string_append(types_str, "魔法 ");
-        if (type & 0x4) g_string_append(types_str, "陷阱 ");
-        if (type & 0x40) g_string_append(types_str, "效果 ");
-        if (type & 0x800) g_string_append(types_str, "特殊召唤 ");
-        
-        json_builder_set_member_name(builder, "types");
-        json_builder_add_string_value(builder, types_str->str);
-        g_string_free(types_str, TRUE);
-        
-        json_builder_end_object(builder); // end text
-        
-        json_builder_end_object(builder); // end card
-        count++;
-    }
-    
-    json_builder_end_array(builder);
+    JsonArray *cards = collect_card_rows(stmt);
     
     sqlite3_finalize(stmt);
     sqlite3_close(db);
     
-    g_message("Parsed %d pre-release cards from CDB", count);
+    g_message("Parsed %u pre-release cards from CDB", json_array_get_length(cards));
     
-    JsonNode *root = json_builder_get_root(builder);
-    g_object_unref(builder);
+    JsonNode *root = json_node_new(JSON_NODE_ARRAY);
+    json_node_take_array(root, cards);
     
     return root;
 }
@@ -327,7 +950,13 @@ typedef struct {
 static gpointer download_prerelease_thread(gpointer data) {
     DownloadContext *ctx = (DownloadContext *)data;
     
-    // 首先清空先行卡目录，强制重新下载
+    // 首先关闭常开的 CDB 和归档并清空先行卡目录，强制重新下载
+    g_mutex_lock(&prerelease_cdb_mutex);
+    prerelease_cdb_close_locked();
+    g_mutex_unlock(&prerelease_cdb_mutex);
+    g_mutex_lock(&prerelease_archive_mutex);
+    prerelease_archive_close_locked();
+    g_mutex_unlock(&prerelease_archive_mutex);
     clear_prerelease_directory();
     
     gchar *data_dir = get_prerelease_data_dir();
@@ -343,7 +972,7 @@ static gpointer download_prerelease_thread(gpointer data) {
     ensure_directory_exists(data_dir);
     
     // 下载YPK文件
-    gchar *ypk_path = g_build_filename(data_dir, "ygopro-super-pre.ypk", NULL);
+    gchar *ypk_path = g_build_filename(data_dir, PRERELEASE_YPK_FILENAME, NULL);
     
     SoupSession *session = soup_session_new();
     SoupMessage *msg = soup_message_new("GET", PRERELEASE_URL);
@@ -429,13 +1058,31 @@ static gpointer download_prerelease_thread(gpointer data) {
     }
     
     g_message("YPK archive extracted successfully");
-    
-    // 删除YPK文件
-    remove(ypk_path);
     g_free(ypk_path);
     
+    // 保留YPK文件，卡图直接从中读取；在本线程建立归档索引
+    g_mutex_lock(&prerelease_archive_mutex);
+    prerelease_archive_close_locked();
+    prerelease_archive_ensure_loaded_locked();
+    g_mutex_unlock(&prerelease_archive_mutex);
+    
+    // CDB 后端直接查询解压出的数据库，不再转换为JSON
+    if (prerelease_cdb_lock()) {
+        g_mutex_unlock(&prerelease_cdb_mutex);
+        g_mutex_lock(&prerelease_cache_mutex);
+        prerelease_cache_clear_locked();
+        g_mutex_unlock(&prerelease_cache_mutex);
+        g_free(data_dir);
+        ctx->success = TRUE;
+        if (ctx->callback) {
+            g_idle_add(ctx->callback, ctx->user_data);
+        }
+        g_free(ctx);
+        return NULL;
+    }
+    
     // 解析CDB文件
-    gchar *cdb_path = g_build_filename(data_dir, "test-release.cdb", NULL);
+    gchar *cdb_path = get_prerelease_cdb_path();
     JsonNode *json_root = parse_cdb_to_json(cdb_path);
     g_free(cdb_path);
     
@@ -465,13 +1112,18 @@ static gpointer download_prerelease_thread(gpointer data) {
         } else {
             g_message("Pre-release JSON saved to %s", json_path);
             ctx->success = TRUE;
+            // 同一秒内重写文件时 mtime 可能不变，显式清空索引后在本线程重新建立
+            g_mutex_lock(&prerelease_cache_mutex);
+            prerelease_cache_clear_locked();
+            prerelease_cache_ensure_loaded_locked();
+            g_mutex_unlock(&prerelease_cache_mutex);
         }
         
         g_object_unref(gen);
         g_free(json_path);
     }
     
-    json_node_free(json_root);
+    json_node_unref(json_root);
     g_free(data_dir);
     
     // 回调通知完成
@@ -493,42 +1145,80 @@ void download_prerelease_cards(GSourceFunc callback, gpointer user_data) {
     g_thread_unref(thread);
 }
 
+// 深拷贝卡片对象：搜索结果会被交给其他线程并被修改（如标记 is_prerelease），
+// 不能与缓存中的对象共享
+static JsonObject *card_object_deep_copy(JsonObject *src) {
+    JsonObject *dst = json_object_new();
+    JsonObjectIter iter;
+    const gchar *member_name = NULL;
+    JsonNode *member_node = NULL;
+    json_object_iter_init(&iter, src);
+    while (json_object_iter_next(&iter, &member_name, &member_node)) {
+        if (JSON_NODE_HOLDS_OBJECT(member_node)) {
+            json_object_set_object_member(dst, member_name,
+                                          card_object_deep_copy(json_node_get_object(member_node)));
+        } else {
+            json_object_set_member(dst, member_name, json_node_copy(member_node));
+        }
+    }
+    return dst;
+}
+
 JsonArray* search_prerelease_cards(const char *search_query) {
     if (!search_query || *search_query == '\0') {
         return NULL;
     }
     
-    gchar *json_path = get_prerelease_json_path();
-    if (!json_path || !g_file_test(json_path, G_FILE_TEST_EXISTS)) {
-        g_free(json_path);
-        return NULL;
+    // 搜索词只折叠一次，卡片侧使用预先折叠好的搜索键
+    gchar *query_folded = search_key_fold(search_query);
+    gsize bytes_scanned = 0;
+    
+    // ID 查询（"id:xxx" 或以数字开头）
+    gboolean id_query = g_str_has_prefix(query_folded, "id:") || g_ascii_isdigit(search_query[0]);
+    int query_id = 0;
+    if (id_query) {
+        const char *id_str = strchr(search_query, ':');
+        if (id_str) id_str++; // 跳过冒号
+        else id_str = search_query;
+        query_id = atoi(id_str);
     }
     
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    
-    if (!json_parser_load_from_file(parser, json_path, &error)) {
-        g_warning("Failed to load pre-release JSON: %s", error->message);
-        g_error_free(error);
-        g_object_unref(parser);
-        g_free(json_path);
-        return NULL;
+    if (prerelease_cdb_lock()) {
+        // trigram 索引只能匹配 3 个字符及以上的子串，更短的搜索词扫描折叠后的临时表
+        sqlite3_stmt *stmt = prerelease_cdb_search_stmt;
+        gchar *match = NULL;
+        if (prerelease_cdb_fts_search_stmt && g_utf8_strlen(query_folded, -1) >= 3) {
+            // 作为 FTS 短语匹配（双引号转义），与 instr 子串匹配语义一致
+            gchar **parts = g_strsplit(query_folded, "\"", -1);
+            gchar *escaped = g_strjoinv("\"\"", parts);
+            match = g_strdup_printf("\"%s\"", escaped);
+            g_free(escaped);
+            g_strfreev(parts);
+            stmt = prerelease_cdb_fts_search_stmt;
+        }
+        sqlite3_bind_text(stmt, 1, match ? match : query_folded, -1, SQLITE_STATIC);
+        if (id_query) {
+            sqlite3_bind_int(stmt, 2, query_id);
+        }
+        JsonArray *results = collect_card_rows(stmt);
+        g_mutex_unlock(&prerelease_cdb_mutex);
+        g_free(match);
+        g_debug("Pre-release CDB search \"%s\": %u matches",
+                search_query, json_array_get_length(results));
+        g_free(query_folded);
+        return results;
     }
     
-    g_free(json_path);
-    
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
-        g_object_unref(parser);
+    g_mutex_lock(&prerelease_cache_mutex);
+    if (!prerelease_cache_ensure_loaded_locked()) {
+        g_mutex_unlock(&prerelease_cache_mutex);
+        g_free(query_folded);
         return NULL;
     }
     
-    JsonArray *all_cards = json_node_get_array(root);
+    JsonArray *all_cards = prerelease_cache_cards;
     JsonArray *results = json_array_new();
     
-    // 转换搜索词为小写以进行不区分大小写的搜索
-    gchar *query_lower = g_utf8_strdown(search_query, -1);
-    
     guint len = json_array_get_length(all_cards);
     for (guint i = 0; i < len; i++) {
         JsonObject *card = json_array_get_object_element(all_cards, i);
@@ -537,160 +1227,130 @@ JsonArray* search_prerelease_cards(const char *search_query) {
         gboolean match = FALSE;
         
         // 检查ID匹配
-        if (g_str_has_prefix(query_lower, "id:") || g_ascii_isdigit(search_query[0])) {
-            const char *id_str = strchr(search_query, ':');
-            if (id_str) id_str++; // 跳过冒号
-            else id_str = search_query;
-            
-            int query_id = atoi(id_str);
+        if (id_query && json_object_has_member(card, "id")) {
             int card_id = json_object_get_int_member(card, "id");
-            
             if (card_id == query_id) {
                 match = TRUE;
             }
         }
         
         // 检查名称和描述匹配
-        if (!match && json_object_has_member(card, "text")) {
-            JsonObject *text = json_object_get_object_member(card, "text");
-            
-            if (json_object_has_member(text, "name")) {
-                const char *name = json_object_get_string_member(text, "name");
-                gchar *name_lower = g_utf8_strdown(name, -1);
-                if (strstr(name_lower, query_lower)) {
-                    match = TRUE;
-                }
-                g_free(name_lower);
-            }
-            
-            if (!match && json_object_has_member(text, "desc")) {
-                const char *desc = json_object_get_string_member(text, "desc");
-                gchar *desc_lower = g_utf8_strdown(desc, -1);
-                if (strstr(desc_lower, query_lower)) {
-                    match = TRUE;
-                }
-                g_free(desc_lower);
-            }
+        if (!match) {
+            match = search_keys_match(prerelease_cache_keys, i, query_folded, &bytes_scanned);
         }
         
         if (match) {
-            json_array_add_object_element(results, json_object_ref(card));
+            json_array_add_object_element(results, card_object_deep_copy(card));
         }
     }
+    g_mutex_unlock(&prerelease_cache_mutex);
     
-    g_free(query_lower);
-    g_object_unref(parser);
+    g_debug("Pre-release search \"%s\": %u cards, %" G_GSIZE_FORMAT " key bytes scanned",
+            search_query, len, bytes_scanned);
+    g_free(query_folded);
     
     return results;
 }
 
 JsonArray* get_all_prerelease_cards(void) {
-    gchar *json_path = get_prerelease_json_path();
-    if (!json_path || !g_file_test(json_path, G_FILE_TEST_EXISTS)) {
-        g_free(json_path);
-        return NULL;
+    if (prerelease_cdb_lock()) {
+        JsonArray *results = collect_card_rows(prerelease_cdb_all_stmt);
+        g_mutex_unlock(&prerelease_cdb_mutex);
+        return results;
     }
     
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    
-    if (!json_parser_load_from_file(parser, json_path, &error)) {
-        g_warning("Failed to load pre-release JSON: %s", error->message);
-        g_error_free(error);
-        g_object_unref(parser);
-        g_free(json_path);
+    g_mutex_lock(&prerelease_cache_mutex);
+    if (!prerelease_cache_ensure_loaded_locked()) {
+        g_mutex_unlock(&prerelease_cache_mutex);
         return NULL;
     }
     
-    g_free(json_path);
-    
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
-        g_object_unref(parser);
-        return NULL;
-    }
-    
-    JsonArray *all_cards = json_node_get_array(root);
+    // 复制所有卡片到结果数组（独立副本，调用者会标记 is_prerelease）
     JsonArray *results = json_array_new();
-    
-    // 复制所有卡片到结果数组
-    guint len = json_array_get_length(all_cards);
+    guint len = json_array_get_length(prerelease_cache_cards);
     for (guint i = 0; i < len; i++) {
-        JsonObject *card = json_array_get_object_element(all_cards, i);
+        JsonObject *card = json_array_get_object_element(prerelease_cache_cards, i);
         if (card) {
-            json_array_add_object_element(results, json_object_ref(card));
+            json_array_add_object_element(results, card_object_deep_copy(card));
         }
     }
-    
-    g_object_unref(parser);
+    g_mutex_unlock(&prerelease_cache_mutex);
     
     return results;
 }
 
 JsonObject* find_prerelease_card_by_id(int card_id) {
-    gchar *json_path = get_prerelease_json_path();
-    if (!json_path || !g_file_test(json_path, G_FILE_TEST_EXISTS)) {
-        g_free(json_path);
-        return NULL;
-    }
-    
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    
-    if (!json_parser_load_from_file(parser, json_path, &error)) {
-        g_warning("Failed to load pre-release JSON: %s", error->message);
-        g_error_free(error);
-        g_object_unref(parser);
-        g_free(json_path);
-        return NULL;
+    if (prerelease_cdb_lock()) {
+        JsonObject *card = NULL;
+        sqlite3_bind_int(prerelease_cdb_by_id_stmt, 1, card_id);
+        if (sqlite3_step(prerelease_cdb_by_id_stmt) == SQLITE_ROW) {
+            card = card_object_from_row(prerelease_cdb_by_id_stmt);
+        }
+        sqlite3_reset(prerelease_cdb_by_id_stmt);
+        sqlite3_clear_bindings(prerelease_cdb_by_id_stmt);
+        g_mutex_unlock(&prerelease_cdb_mutex);
+        return card;
     }
     
-    g_free(json_path);
-    
-    JsonNode *root = json_parser_get_root(parser);
-    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) {
-        g_object_unref(parser);
+    g_mutex_lock(&prerelease_cache_mutex);
+    if (!prerelease_cache_ensure_loaded_locked()) {
+        g_mutex_unlock(&prerelease_cache_mutex);
         return NULL;
     }
     
-    JsonArray *all_cards = json_node_get_array(root);
     JsonObject *found_card = NULL;
-    
-    guint len = json_array_get_length(all_cards);
-    for (guint i = 0; i < len; i++) {
-        JsonObject *card = json_array_get_object_element(all_cards, i);
-        if (!card) continue;
-        
-        if (json_object_has_member(card, "id")) {
-            int id = json_object_get_int_member(card, "id");
-            if (id == card_id) {
-                found_card = json_object_ref(card);
-                break;
-            }
-        }
+    guint index = GPOINTER_TO_UINT(g_hash_table_lookup(prerelease_cache_by_id, GINT_TO_POINTER(card_id)));
+    if (index > 0) {
+        JsonObject *card = json_array_get_object_element(prerelease_cache_cards, index - 1);
+        if (card) found_card = card_object_deep_copy(card);
     }
-    
-    g_object_unref(parser);
+    g_mutex_unlock(&prerelease_cache_mutex);
     
     return found_card;
 }
 
 gchar* get_prerelease_card_image_path(int card_id) {
-    gchar *data_dir = get_prerelease_data_dir();
-    if (!data_dir) {
-        return NULL;
+    gchar *image_path = NULL;
+    
+    g_mutex_lock(&prerelease_archive_mutex);
+    prerelease_archive_ensure_loaded_locked();
+    if (prerelease_legacy_has_image_locked(card_id)) {
+        gchar name[32];
+        g_snprintf(name, sizeof name, "%d.jpg", card_id);
+        image_path = g_build_filename(prerelease_pics_dir, name, NULL);
     }
+    g_mutex_unlock(&prerelease_archive_mutex);
     
-    gchar *image_path = g_build_filename(data_dir, "pics", g_strdup_printf("%d.jpg", card_id), NULL);
-    g_free(data_dir);
+    return image_path;
+}
+
+gboolean prerelease_card_has_image(int card_id) {
+    g_mutex_lock(&prerelease_archive_mutex);
+    prerelease_archive_ensure_loaded_locked();
+    gboolean found = prerelease_archive_find_locked(card_id) != NULL ||
+                     prerelease_legacy_has_image_locked(card_id);
+    g_mutex_unlock(&prerelease_archive_mutex);
+    return found;
+}
+
+GdkPixbuf* load_prerelease_card_image(int card_id, GError **error) {
+    GBytes *bytes = prerelease_archive_read(card_id);
+    if (bytes) {
+        GInputStream *stream = g_memory_input_stream_new_from_bytes(bytes);
+        GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream(stream, NULL, error);
+        g_object_unref(stream);
+        g_bytes_unref(bytes);
+        return pixbuf;
+    }
     
-    // 检查文件是否存在
-    if (!g_file_test(image_path, G_FILE_TEST_EXISTS)) {
-        g_free(image_path);
+    gchar *image_path = get_prerelease_card_image_path(card_id);
+    if (!image_path) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No image for pre-release card %d", card_id);
         return NULL;
     }
-    
-    return image_path;
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(image_path, error);
+    g_free(image_path);
+    return pixbuf;
 }
 
 /**
@@ -702,12 +1362,13 @@ gboolean is_prerelease_id(int card_id) {
 
 gboolean prerelease_data_exists(void) {
     gchar *json_path = get_prerelease_json_path();
-    if (!json_path) {
-        return FALSE;
-    }
+    gchar *cdb_path = get_prerelease_cdb_path();
     
-    gboolean exists = g_file_test(json_path, G_FILE_TEST_EXISTS);
+    // CDB 后端下载时只有 test-release.cdb，没有JSON
+    gboolean exists = (json_path && g_file_test(json_path, G_FILE_TEST_EXISTS)) ||
+                      (cdb_path && g_file_test(cdb_path, G_FILE_TEST_EXISTS));
     g_free(json_path);
+    g_free(cdb_path);
     
     return exists;
 }
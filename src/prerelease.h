@@ -3,6 +3,11 @@
 
 #include <glib.h>
 #include <json-glib/json-glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+// 先行卡数据默认读取由 CDB 转换的 pre-release.json 并建立常驻索引；
+// 设置 YGO_PRERELEASE_BACKEND=cdb 时改为只读常开 test-release.cdb，用预编译语句查询，
+// 下载时也不再生成 JSON。
 
 /**
  * 下载并处理先行卡数据
@@ -13,35 +18,51 @@
 void download_prerelease_cards(GSourceFunc callback, gpointer user_data);
 
 /**
- * 从先行卡JSON文件中搜索卡片
+ * 按ID或卡名/效果描述搜索先行卡（可在后台线程调用）
  * @param search_query 搜索关键词
- * @return JSON数组，包含匹配的卡片数据，需要调用者使用json_array_unref释放
+ * @return JSON数组，包含匹配卡片的独立副本，需要调用者使用json_array_unref释放
  */
 JsonArray* search_prerelease_cards(const char *search_query);
 
 /**
- * 获取所有先行卡
- * @return JSON数组，包含所有先行卡数据，需要调用者使用json_array_unref释放；如果失败返回NULL
+ * 获取所有先行卡（读取常驻索引或枚举 CDB，可在后台线程调用）
+ * @return JSON数组，包含所有先行卡的独立副本，需要调用者使用json_array_unref释放；如果失败返回NULL
  */
 JsonArray* get_all_prerelease_cards(void);
 
 /**
- * 根据ID查找先行卡
+ * 根据ID查找先行卡（常驻索引中的哈希表查找，或 CDB 主键查找）
  * @param card_id 卡片ID
- * @return JSON对象，包含卡片数据，需要调用者使用json_object_unref释放；如果未找到返回NULL
+ * @return JSON对象，包含卡片数据的独立副本，需要调用者使用json_object_unref释放；如果未找到返回NULL
  */
 JsonObject* find_prerelease_card_by_id(int card_id);
 
 /**
- * 获取先行卡图片路径
+ * 获取先行卡图片路径（旧版本解压在 pics/ 下的卡图；新下载的卡图保留在YPK归档中）
+ * 查内存中的ID表，不访问文件系统
  * @param card_id 卡片ID
- * @return 图片文件路径，需要调用者使用g_free释放；如果文件不存在返回NULL
+ * @return 图片文件路径，需要调用者使用g_free释放；如果没有该卡图返回NULL
  */
 gchar* get_prerelease_card_image_path(int card_id);
 
+/**
+ * 判断先行卡是否有卡图（查YPK归档索引与 pics/ 的ID表，不访问文件系统）
+ * @param card_id 卡片ID
+ * @return TRUE如果有卡图
+ */
+gboolean prerelease_card_has_image(int card_id);
+
+/**
+ * 加载先行卡卡图（直接解压YPK归档中的条目，可在后台线程调用）
+ * @param card_id 卡片ID
+ * @param error 错误输出，可为NULL
+ * @return GdkPixbuf，调用者需要unref；失败返回NULL
+ */
+GdkPixbuf* load_prerelease_card_image(int card_id, GError **error);
+
 /**
  * 检查先行卡数据是否存在
- * @return TRUE如果数据已下载，否则FALSE
+ * @return TRUE如果数据已下载（JSON 或 CDB 存在），否则FALSE
  */
 gboolean prerelease_data_exists(void);
 
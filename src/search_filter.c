@@ -6,25 +6,17 @@
 #include "dnd_manager.h"
 #include "deck_slot.h"
 #include "card_info.h"
+#include "search_results.h"
 #include <string.h>
 
 // 全局变量：是否在搜索结果中显示先行卡（默认显示）
 extern gboolean show_prerelease_cards;
 
-// 外部函数声明
-extern void list_clear(GtkListBox *list);
-extern void draw_pixbuf_scaled(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer user_data);
-extern void on_drawing_area_destroy(GtkWidget *widget, gpointer user_data);
-extern void free_card_preview(gpointer data);
-extern void on_result_row_pressed(GtkGestureClick *gesture, int n_press, double x, double y, gpointer user_data);
-extern void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, double y, gpointer user_data);
-extern void on_result_row_enter(GtkEventControllerMotion *controller, double x, double y, gpointer user_data);
-
 // 先行卡异步加载的数据结构
 typedef struct {
     GtkWidget *target;
     GtkStack *stack;
-    gchar *path;
+    int img_id;
 } PreloadData;
 
 // 先行卡加载完成回调
@@ -36,7 +28,11 @@ static void preload_finished(GObject *source, GAsyncResult *res, gpointer user_d
     
     if (err) g_error_free(err);
     
-    if (pb && pd->target && GTK_IS_DRAWING_AREA(pd->target)) {
+    // 行控件可能已被回收给其他卡片，此时丢弃结果
+    gboolean still_bound = pd->target &&
+        GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pd->target), "bound_img_id")) == pd->img_id;
+
+    if (pb && still_bound && GTK_IS_DRAWING_AREA(pd->target)) {
         // 清空缓存的 surface（触发 destroy notify 如果有的话）
         g_object_set_data_full(G_OBJECT(pd->target), "cached_surface", NULL, NULL);
 
@@ -56,7 +52,6 @@ static void preload_finished(GObject *source, GAsyncResult *res, gpointer user_d
     if (pd->stack && G_IS_OBJECT(pd->stack)) {
         g_object_remove_weak_pointer(G_OBJECT(pd->stack), (gpointer*)&pd->stack);
     }
-    g_free(pd->path);
     g_free(pd);
 }
 
@@ -72,7 +67,7 @@ static void preload_thread(GTask *task, gpointer source_object, gpointer task_da
     }
     
     GError *err = NULL;
-    GdkPixbuf *pb = gdk_pixbuf_new_from_file(pd->path, &err);
+    GdkPixbuf *pb = load_prerelease_card_image(pd->img_id, &err);
     if (err) {
         g_error_free(err);
         g_task_return_pointer(task, NULL, NULL);
@@ -81,6 +76,75 @@ static void preload_thread(GTask *task, gpointer source_object, gpointer task_da
     }
 }
 
+// 磁盘上已有原图时在解码线程池中生成缩略图的数据（持有控件引用，工作线程可以读取绑定状态）
+typedef struct {
+    SearchUI *ui;
+    GtkWidget *target;
+    GtkStack *stack;
+    int img_id;
+    int scale_factor;
+    int priority;
+} ThumbDiskData;
+
+static gboolean thumb_target_bound_to(GtkWidget *target, int img_id) {
+    return GPOINTER_TO_INT(g_object_get_data(G_OBJECT(target), "bound_img_id")) == img_id;
+}
+
+// 在线下载普通卡片图片，缩放为缩略图并写入缓存
+static void start_thumb_download(SearchUI *ui, GtkWidget *target, GtkStack *stack, int img_id, int priority) {
+    char url[128];
+    g_snprintf(url, sizeof url, "https://cdn.233.momobako.com/ygoimg/jp/%d.webp", img_id);
+    ImageLoadCtx *ctx = g_new0(ImageLoadCtx, 1);
+    ctx->stack = stack;
+    ctx->target = target;
+    ctx->scale_to_thumb = TRUE;
+    ctx->cache_id = img_id;
+    ctx->add_to_thumb_cache = TRUE;
+    ctx->url = g_strdup(url);
+    ctx->priority = priority;
+    load_image_async(ui->session, url, ctx);
+}
+
+static void thumb_disk_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    (void)source_object;
+    (void)cancellable;
+    ThumbDiskData *td = (ThumbDiskData*)task_data;
+    // 排队期间行已被回收给其他卡片：不再解码，重新绑定时会再次入队
+    if (!thumb_target_bound_to(td->target, td->img_id)) {
+        g_task_return_pointer(task, NULL, NULL);
+        return;
+    }
+    // 由原图解码到缩略图尺寸并写回 thumbs.pack，之后绑定直接命中缩略图缓存
+    g_task_return_pointer(task, load_thumb_from_disk_cache(td->img_id, td->scale_factor), g_object_unref);
+}
+
+static void thumb_disk_finished(GObject *source, GAsyncResult *res, gpointer user_data) {
+    (void)source;
+    ThumbDiskData *td = (ThumbDiskData*)user_data;
+    GdkPixbuf *pb = (GdkPixbuf*)g_task_propagate_pointer(G_TASK(res), NULL);
+
+    if (thumb_target_bound_to(td->target, td->img_id)) {
+        if (pb) {
+            add_thumb_to_cache(td->img_id, pb);
+            g_object_set_data(G_OBJECT(td->target), "img_id", GINT_TO_POINTER(td->img_id));
+            g_object_set_data_full(G_OBJECT(td->target), "pixbuf", pb, (GDestroyNotify)g_object_unref);
+            g_object_set_data_full(G_OBJECT(td->target), "cached_surface", NULL, NULL);
+            g_object_set_data_full(G_OBJECT(td->target), "cached_render", NULL, NULL);
+            gtk_widget_queue_draw(td->target);
+            gtk_stack_set_visible_child_name(td->stack, "picture");
+            pb = NULL;
+        } else {
+            // 磁盘上的原图无法解码，改为在线下载
+            start_thumb_download(td->ui, td->target, td->stack, td->img_id, td->priority);
+        }
+    }
+    if (pb) g_object_unref(pb);
+
+    g_object_unref(td->target);
+    g_object_unref(td->stack);
+    g_free(td);
+}
+
 // 逐个加载搜索结果图片，避免同时加载太多导致UI卡顿
 gboolean search_load_next_image(gpointer user_data) {
     SearchUI *ui = (SearchUI*)user_data;
@@ -94,11 +158,19 @@ gboolean search_load_next_image(gpointer user_data) {
         return G_SOURCE_REMOVE;
     }
     
+    // 视口内的行先加载，其次是视口附近的预取范围，滚出视口的条目直接丢弃
+    if (ui->image_queue_dirty) {
+        search_results_sort_image_queue(ui);
+    }
+
     // 每次加载 8 张图片以加快显示速度（适度增加批次避免过度占用带宽）
     int batch_size = 8;
     int loaded = 0;
     
     while (loaded < batch_size && ui->search_image_queue && ui->search_image_queue->len > 0) {
+        // 解码线程池积压时暂停，剩余条目留到之后的回调
+        if (image_loader_decode_pool_busy()) break;
+
         SearchImageToLoad *item = (SearchImageToLoad*)g_ptr_array_index(ui->search_image_queue, 0);
         
         if (!item) {
@@ -108,41 +180,14 @@ gboolean search_load_next_image(gpointer user_data) {
         
         int img_id = item->img_id;
         gboolean is_prerelease = item->is_prerelease;
+        int priority = item->priority;
         
         // 移除队列项（g_ptr_array_new_with_free_func 会自动释放 item）
         g_ptr_array_remove_index(ui->search_image_queue, 0);
         
-        // 遍历搜索结果列表，查找对应的控件
-        GtkWidget *list_child = gtk_widget_get_first_child(ui->list);
+        // 查找当前绑定该卡片的可见行（已滚出视口的卡片不再加载，重新绑定时会再次入队）
         GtkStack *stack = NULL;
-        GtkWidget *target = NULL;
-        
-        while (list_child) {
-            if (GTK_IS_LIST_BOX_ROW(list_child)) {
-                GtkWidget *row_child = gtk_list_box_row_get_child(GTK_LIST_BOX_ROW(list_child));
-                if (row_child && GTK_IS_BOX(row_child)) {
-                    // 查找行中的 stack
-                    GtkWidget *box_child = gtk_widget_get_first_child(row_child);
-                    while (box_child) {
-                        if (GTK_IS_STACK(box_child)) {
-                            // 找到 stack，检查其中的 picture
-                            GtkWidget *picture = gtk_stack_get_child_by_name(GTK_STACK(box_child), "picture");
-                            if (picture && GTK_IS_DRAWING_AREA(picture)) {
-                                int stored_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(picture), "pending_img_id"));
-                                if (stored_id == img_id) {
-                                    stack = GTK_STACK(box_child);
-                                    target = picture;
-                                    break;
-                                }
-                            }
-                        }
-                        box_child = gtk_widget_get_next_sibling(box_child);
-                    }
-                }
-            }
-            if (target) break;
-            list_child = gtk_widget_get_next_sibling(list_child);
-        }
+        GtkWidget *target = search_results_find_pending_picture(ui, img_id, &stack);
         
         // 如果找到了对应的控件，加载图片
         if (target && stack) {
@@ -150,38 +195,40 @@ gboolean search_load_next_image(gpointer user_data) {
             g_object_set_data(G_OBJECT(target), "pending_img_id", GINT_TO_POINTER(0));
             
             if (is_prerelease) {
-                // 先行卡：直接在后台线程加载本地文件（不使用libsoup）
-                gchar *local_path = get_prerelease_card_image_path(img_id);
-                if (local_path && g_file_test(local_path, G_FILE_TEST_EXISTS)) {
+                // 先行卡：直接在后台线程从本地归档加载（不使用libsoup）
+                if (prerelease_card_has_image(img_id)) {
                     // 使用GTask在后台线程加载，避免阻塞UI
                     // 注意：不能使用libsoup的file:// URL，libsoup不支持本地文件
                     PreloadData *pdata = g_new0(PreloadData, 1);
                     pdata->target = target;
                     pdata->stack = stack;
-                    pdata->path = local_path;  // 转移所有权
+                    pdata->img_id = img_id;
                     
                     g_object_add_weak_pointer(G_OBJECT(target), (gpointer*)&pdata->target);
                     g_object_add_weak_pointer(G_OBJECT(stack), (gpointer*)&pdata->stack);
                     
                     GTask *task = g_task_new(NULL, NULL, preload_finished, pdata);
                     g_task_set_task_data(task, pdata, NULL);
-                    g_task_run_in_thread(task, preload_thread);
+                    image_loader_run_in_decode_pool(task, preload_thread);
                     g_object_unref(task);
-                } else {
-                    g_free(local_path);
                 }
+            } else if (disk_cache_has_image(img_id)) {
+                // 磁盘缓存中已有原图（只是缺少缩略图）：在解码线程池中生成，不需要下载
+                ThumbDiskData *td = g_new0(ThumbDiskData, 1);
+                td->ui = ui;
+                td->target = g_object_ref(target);
+                td->stack = g_object_ref(stack);
+                td->img_id = img_id;
+                td->scale_factor = gtk_widget_get_scale_factor(target);
+                td->priority = priority;
+
+                GTask *task = g_task_new(NULL, NULL, thumb_disk_finished, td);
+                g_task_set_task_data(task, td, NULL);
+                image_loader_run_in_decode_pool(task, thumb_disk_thread);
+                g_object_unref(task);
             } else {
                 // 从在线加载普通卡片图片
-                char url[128];
-                g_snprintf(url, sizeof url, "https://cdn.233.momobako.com/ygoimg/jp/%d.webp", img_id);
-                ImageLoadCtx *ctx = g_new0(ImageLoadCtx, 1);
-                ctx->stack = stack;
-                ctx->target = target;
-                ctx->scale_to_thumb = TRUE;
-                ctx->cache_id = img_id;
-                ctx->add_to_thumb_cache = TRUE;
-                ctx->url = g_strdup(url);
-                load_image_async(ui->session, url, ctx);
+                start_thumb_download(ui, target, stack, img_id, priority);
             }
             loaded++;
         }
@@ -190,7 +237,7 @@ gboolean search_load_next_image(gpointer user_data) {
     return G_SOURCE_CONTINUE;
 }
 
-// 批量渲染回调：每次处理一批结果（10个）
+// 批量渲染回调：每次把一批结果转换为列表条目并一次性追加
 gboolean batch_render_results(gpointer user_data) {
     SearchUI *ui = (SearchUI*)user_data;
     
@@ -201,32 +248,23 @@ gboolean batch_render_results(gpointer user_data) {
         return G_SOURCE_REMOVE;
     }
     
-    // 每次处理50个结果，加快大量结果的渲染速度
-    const int BATCH_SIZE = 50;
-    int processed = 0;
+    // 条目只是轻量数据，行控件由 GtkListView 按可见范围创建，因此每批可以处理较多结果
+    const guint BATCH_SIZE = 500;
+    guint n = MIN(BATCH_SIZE, ui->pending_results->len);
     
-    while (processed < BATCH_SIZE && ui->pending_results && ui->pending_results->len > 0) {
-        JsonObject *obj = g_ptr_array_index(ui->pending_results, 0);
-        
-        if (obj) {
-            add_result_row_immediate(ui, obj);
-        }
-        
-        // 移除队列项（g_ptr_array_new_with_free_func 会自动调用 json_object_unref）
-        g_ptr_array_remove_index(ui->pending_results, 0);
-        
-        processed++;
+    GPtrArray *items = g_ptr_array_new_full(n, g_object_unref);
+    for (guint i = 0; i < n; i++) {
+        JsonObject *obj = g_ptr_array_index(ui->pending_results, i);
+        if (obj) g_ptr_array_add(items, ygo_card_item_new_from_json(obj));
     }
+    // 移除队列项（g_ptr_array_new_with_free_func 会自动调用 json_object_unref）
+    g_ptr_array_remove_range(ui->pending_results, 0, n);
+    search_results_append(ui, items);
+    g_ptr_array_unref(items);
     
-    // 如果队列已空，停止定时器并启动图片加载器
-    if (!ui->pending_results || ui->pending_results->len == 0) {
+    // 如果队列已空，停止批量渲染
+    if (ui->pending_results->len == 0) {
         ui->batch_render_id = 0;
-        
-        // 批量渲染完成后，启动图片加载器
-        if (ui->search_image_queue && ui->search_image_queue->len > 0 && ui->search_image_loader_id == 0) {
-            ui->search_image_loader_id = g_timeout_add(20, search_load_next_image, ui);
-        }
-        
         return G_SOURCE_REMOVE;
     }
     
@@ -251,302 +289,27 @@ void queue_result_for_render(SearchUI *ui, JsonObject *obj) {
     }
 }
 
-// 立即渲染单个结果行（原 add_result_row 函数）
+// 立即把单个结果追加到列表
 void add_result_row_immediate(SearchUI *ui, JsonObject *obj) {
-    const char *name = NULL;
-    
-    // 先检查是否有 text.name（先行卡格式）
-    if (json_object_has_member(obj, "text")) {
-        JsonObject *text = json_object_get_object_member(obj, "text");
-        if (text && json_object_has_member(text, "name")) {
-            name = json_object_get_string_member(text, "name");
-        }
-    }
-    
-    // 如果没有 text.name，按原顺序查找其他名称
-    if (!name) name = json_object_get_string_member(obj, "cn_name");
-    if (!name) name = json_object_get_string_member(obj, "sc_name");
-    if (!name) name = json_object_get_string_member(obj, "jp_name");
-    if (!name) name = json_object_get_string_member(obj, "en_name");
-    
-    int id = 0;
-    if (json_object_has_member(obj, "id")) id = json_object_get_int_member(obj, "id");
-    
-    // 获取cid用于禁限卡表查询
-    int cid = 0;
-    if (json_object_has_member(obj, "cid")) {
-        cid = json_object_get_int_member(obj, "cid");
-    }
-
-    GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
-    gtk_widget_set_margin_top(row, 6);
-    gtk_widget_set_margin_bottom(row, 6);
-    gtk_widget_set_margin_start(row, 8);
-    gtk_widget_set_margin_end(row, 8);
-
-    // 缩略图栈：占位与图片（强制 68x99 尺寸，避免单条结果时放大）
-    GtkWidget *thumb_stack = gtk_stack_new();
-    gtk_stack_set_transition_type(GTK_STACK(thumb_stack), GTK_STACK_TRANSITION_TYPE_CROSSFADE);
-    gtk_stack_set_transition_duration(GTK_STACK(thumb_stack), 150);
-    gtk_widget_set_size_request(thumb_stack, 68, 99);
-    gtk_widget_set_halign(thumb_stack, GTK_ALIGN_START);
-    gtk_widget_set_valign(thumb_stack, GTK_ALIGN_CENTER);
-    gtk_widget_set_hexpand(thumb_stack, FALSE);
-    gtk_widget_set_vexpand(thumb_stack, FALSE);
-    gtk_widget_add_css_class(thumb_stack, "thumb-fixed");
-    // 占位框 68x99，居中Spinner
-    GtkWidget *placeholder = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-    gtk_widget_set_size_request(placeholder, 68, 99);
-    gtk_widget_set_valign(placeholder, GTK_ALIGN_CENTER);
-    gtk_widget_set_halign(placeholder, GTK_ALIGN_CENTER);
-    gtk_widget_add_css_class(placeholder, "thumb-fixed");
-    GtkWidget *spinner = gtk_spinner_new();
-    gtk_spinner_start(GTK_SPINNER(spinner));
-    gtk_box_append(GTK_BOX(placeholder), spinner);
-    gtk_stack_add_named(GTK_STACK(thumb_stack), placeholder, "placeholder");
-    // 图片控件：使用 GtkDrawingArea + Cairo 高质量缩放绘制
-    GtkWidget *picture = gtk_drawing_area_new();
-    gtk_widget_set_size_request(picture, 68, 99);
-    gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(picture), draw_pixbuf_scaled, NULL, NULL);
-    g_signal_connect(picture, "destroy", G_CALLBACK(on_drawing_area_destroy), NULL);
-    gtk_widget_set_halign(picture, GTK_ALIGN_CENTER);
-    gtk_widget_set_valign(picture, GTK_ALIGN_CENTER);
-    gtk_widget_set_hexpand(picture, FALSE);
-    gtk_widget_set_vexpand(picture, FALSE);
-    gtk_widget_add_css_class(picture, "thumb-fixed");
-    gtk_stack_add_named(GTK_STACK(thumb_stack), picture, "picture");
-    gtk_stack_set_visible_child_name(GTK_STACK(thumb_stack), "placeholder");
-    
-    // 检查是否是先行卡（优先通过ID位数判断，9位数=先行卡）
-    gboolean is_prerelease = (id > 0 && is_prerelease_id(id));
-    
-    // 如果不是9位数，检查JSON中的标记（向后兼容）
-    if (!is_prerelease && json_object_has_member(obj, "is_prerelease")) {
-        is_prerelease = json_object_get_boolean_member(obj, "is_prerelease");
-    }
-    
-    if (id > 0) {
-        // 不立即加载图片，而是添加到队列中
-        // 先检查内存缓存，如果有则直接使用
-        gboolean loaded_from_cache = FALSE;
-        
-        if (!is_prerelease) {
-            GdkPixbuf *cached = get_thumb_from_cache(id);
-            if (cached) {
-                g_object_set_data(G_OBJECT(picture), "img_id", GINT_TO_POINTER(id));
-                g_object_set_data_full(G_OBJECT(picture), "pixbuf", g_object_ref(cached), (GDestroyNotify)g_object_unref);
-                g_object_set_data_full(G_OBJECT(picture), "cached_surface", NULL, NULL);
-                g_object_set_data_full(G_OBJECT(picture), "cached_render", NULL, NULL);
-                gtk_widget_queue_draw(picture);
-                gtk_stack_set_visible_child_name(GTK_STACK(thumb_stack), "picture");
-                loaded_from_cache = TRUE;
-            }
-        }
-
-        // 内存缓存未命中时，也尝试从磁盘缓存读取（左栏预览会复用磁盘缓存）
-        if (!loaded_from_cache && !is_prerelease) {
-            GdkPixbuf *disk_cached = load_from_disk_cache(id);
-            if (disk_cached) {
-                g_object_set_data(G_OBJECT(picture), "img_id", GINT_TO_POINTER(id));
-                // 磁盘缓存通常是原图；这里缩放成固定缩略图，避免每行持有大图导致内存暴涨
-                int sf = gtk_widget_get_scale_factor(picture);
-                if (sf < 1) sf = 1;
-                int tw = 68 * sf;
-                int th = 99 * sf;
-
-                GdkPixbuf *thumb = disk_cached;
-                if (gdk_pixbuf_get_width(disk_cached) != tw || gdk_pixbuf_get_height(disk_cached) != th) {
-                    GdkPixbuf *scaled = gdk_pixbuf_scale_simple(disk_cached, tw, th, GDK_INTERP_HYPER);
-                    if (scaled) {
-                        g_object_unref(disk_cached);
-                        thumb = scaled;
-                    }
-                }
-                g_object_set_data_full(G_OBJECT(picture), "pixbuf", thumb, (GDestroyNotify)g_object_unref);
-                g_object_set_data_full(G_OBJECT(picture), "cached_surface", NULL, NULL);
-                g_object_set_data_full(G_OBJECT(picture), "cached_render", NULL, NULL);
-                gtk_widget_queue_draw(picture);
-                gtk_stack_set_visible_child_name(GTK_STACK(thumb_stack), "picture");
-                loaded_from_cache = TRUE;
-                // thumb 的引用已转移到 picture 的 data 中，不需要额外 unref
-            }
-        }
-        
-        // 如果没有从缓存加载，添加到加载队列
-        if (!loaded_from_cache) {
-            if (!ui->search_image_queue) {
-                ui->search_image_queue = g_ptr_array_new_with_free_func(g_free);
-            }
-            
-            // 在 picture 控件上存储待加载标记，用于后续查找
-            g_object_set_data(G_OBJECT(picture), "pending_img_id", GINT_TO_POINTER(id));
-            
-            SearchImageToLoad *item = g_new0(SearchImageToLoad, 1);
-            item->img_id = id;
-            item->is_prerelease = is_prerelease;
-            g_ptr_array_add(ui->search_image_queue, item);
-        }
-    }
-
-    // 文字容器：固定宽度 208px（右栏300 - 左右边距16 - 图片68 - 间距8）
-    // 防止文字区域扩展导致整行被拉伸
-    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
-    gtk_widget_set_size_request(vbox, 208, -1);
-    gtk_widget_set_hexpand(vbox, FALSE);
-    gtk_widget_set_vexpand(vbox, FALSE);
-    gtk_widget_set_halign(vbox, GTK_ALIGN_START);
-    gtk_widget_set_valign(vbox, GTK_ALIGN_CENTER);
-
-    GtkWidget *title = gtk_label_new(name ? name : "(无名)" );
-    gtk_label_set_xalign(GTK_LABEL(title), 0.0);
-    gtk_label_set_ellipsize(GTK_LABEL(title), PANGO_ELLIPSIZE_END);
-    gtk_label_set_max_width_chars(GTK_LABEL(title), 20);
-
-    // 从 text.types 获取类型字符串用于显示
-    const char *types = NULL;
-    if (json_object_has_member(obj, "text")) {
-        JsonObject *text = json_object_get_object_member(obj, "text");
-        if (text && json_object_has_member(text, "types")) types = json_object_get_string_member(text, "types");
-    }
-    GtkWidget *subtitle = gtk_label_new(types ? types : "");
-    gtk_label_set_xalign(GTK_LABEL(subtitle), 0.0);
-    gtk_label_set_ellipsize(GTK_LABEL(subtitle), PANGO_ELLIPSIZE_END);
-    gtk_label_set_max_width_chars(GTK_LABEL(subtitle), 20);
-    gtk_widget_add_css_class(subtitle, "dim-label");
-
-    gtk_box_append(GTK_BOX(vbox), title);
-    gtk_box_append(GTK_BOX(vbox), subtitle);
-    
-    // 显示禁限状态（使用cid而非id）
-    if (cid > 0 && ui->forbidden_dropdown) {
-        guint selected = gtk_drop_down_get_selected(ui->forbidden_dropdown);
-        GHashTable *forbidden_table = NULL;
-        
-        if (selected == 0 && ui->ocg_forbidden) {
-            forbidden_table = ui->ocg_forbidden;
-        } else if (selected == 1 && ui->tcg_forbidden) {
-            forbidden_table = ui->tcg_forbidden;
-        } else if (selected == 2 && ui->sc_forbidden) {
-            forbidden_table = ui->sc_forbidden;
-        }
-        
-        if (forbidden_table) {
-            char cid_str[32];
-            g_snprintf(cid_str, sizeof(cid_str), "%d", cid);
-            const char *status = g_hash_table_lookup(forbidden_table, cid_str);
-            
-            if (status) {
-                // 创建带背景色的禁限状态标签
-                GtkWidget *forbidden_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
-                gtk_widget_set_halign(forbidden_box, GTK_ALIGN_START);
-                
-                GtkWidget *forbidden_label = gtk_label_new(NULL);
-                char *markup = g_strdup_printf("<b>[%s]</b>", status);
-                gtk_label_set_markup(GTK_LABEL(forbidden_label), markup);
-                g_free(markup);
-                
-                gtk_label_set_xalign(GTK_LABEL(forbidden_label), 0.0);
-                
-                // 根据不同状态设置不同样式
-                if (g_strcmp0(status, "禁止") == 0) {
-                    gtk_widget_add_css_class(forbidden_label, "error");
-                } else if (g_strcmp0(status, "限制") == 0) {
-                    gtk_widget_add_css_class(forbidden_label, "warning");
-                } else if (g_strcmp0(status, "准限制") == 0) {
-                    gtk_widget_add_css_class(forbidden_label, "accent");
-                }
-                
-                gtk_box_append(GTK_BOX(forbidden_box), forbidden_label);
-                gtk_box_append(GTK_BOX(vbox), forbidden_box);
-            }
-        }
-    }
-
-    // 防止 row 扩展
-    gtk_widget_set_hexpand(row, FALSE);
-    gtk_widget_set_halign(row, GTK_ALIGN_START);
-
-    gtk_box_append(GTK_BOX(row), thumb_stack);
-    gtk_box_append(GTK_BOX(row), vbox);
-
-    GtkWidget *list_row = gtk_list_box_row_new();
-    gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(list_row), row);
-    // 绑定悬停事件
-    GtkEventController *motion = GTK_EVENT_CONTROLLER(gtk_event_controller_motion_new());
-    g_signal_connect(motion, "enter", G_CALLBACK(on_result_row_enter), ui);
-    gtk_widget_add_controller(list_row, motion);
-    // 绑定点击事件（与中栏一致：pressed 记录、released 判定点击）
-    GtkGesture *click = gtk_gesture_click_new();
-    g_signal_connect(click, "pressed", G_CALLBACK(on_result_row_pressed), ui);
-    g_signal_connect(click, "released", G_CALLBACK(on_result_row_released), ui);
-    gtk_widget_add_controller(list_row, GTK_EVENT_CONTROLLER(click));
-    // 存储预览数据
-    CardPreview *pv = g_new0(CardPreview, 1);
-    pv->id = id;
-    pv->cid = cid;
-    pv->cn_name = name ? g_strdup(name) : NULL;
-    pv->is_prerelease = is_prerelease;  // 设置是否是先行卡
-    
-    // 获取类型和其他 data 字段：先行卡的字段在顶层，普通卡的在 data 对象中
-    if (is_prerelease) {
-        // 先行卡的数据字段直接在顶层
-        pv->type = json_object_has_member(obj, "type") ? (uint32_t)json_object_get_int_member(obj, "type") : 0;
-        pv->ot = json_object_has_member(obj, "ot") ? json_object_get_int_member(obj, "ot") : -1;
-        pv->setcode = json_object_has_member(obj, "setcode") ? json_object_get_int_member(obj, "setcode") : -1;
-        pv->atk = json_object_has_member(obj, "atk") ? json_object_get_int_member(obj, "atk") : -1;
-        pv->def = json_object_has_member(obj, "def") ? json_object_get_int_member(obj, "def") : -1;
-        pv->level = json_object_has_member(obj, "level") ? json_object_get_int_member(obj, "level") : -1;
-        pv->race = json_object_has_member(obj, "race") ? json_object_get_int_member(obj, "race") : -1;
-        pv->attribute = json_object_has_member(obj, "attribute") ? json_object_get_int_member(obj, "attribute") : -1;
-    } else if (json_object_has_member(obj, "data")) {
-        // 普通卡的数据字段在 data 对象中
-        JsonObject *data = json_object_get_object_member(obj, "data");
-        if (data) {
-            // 提取所有 data 字段
-            if (json_object_has_member(data, "type")) {
-                pv->type = (uint32_t)json_object_get_int_member(data, "type");
-            }
-            pv->ot = json_object_has_member(data, "ot") ? json_object_get_int_member(data, "ot") : -1;
-            pv->setcode = json_object_has_member(data, "setcode") ? json_object_get_int_member(data, "setcode") : -1;
-            pv->atk = json_object_has_member(data, "atk") ? json_object_get_int_member(data, "atk") : -1;
-            pv->def = json_object_has_member(data, "def") ? json_object_get_int_member(data, "def") : -1;
-            pv->level = json_object_has_member(data, "level") ? json_object_get_int_member(data, "level") : -1;
-            pv->race = json_object_has_member(data, "race") ? json_object_get_int_member(data, "race") : -1;
-            pv->attribute = json_object_has_member(data, "attribute") ? json_object_get_int_member(data, "attribute") : -1;
-        }
-    }
-    
-    if (json_object_has_member(obj, "text")) {
-        JsonObject *text = json_object_get_object_member(obj, "text");
-        if (text) {
-            if (json_object_has_member(text, "types")) pv->types = g_strdup(json_object_get_string_member(text, "types"));
-            if (json_object_has_member(text, "pdesc")) pv->pdesc = g_strdup(json_object_get_string_member(text, "pdesc"));
-            if (json_object_has_member(text, "desc"))  pv->desc  = g_strdup(json_object_get_string_member(text, "desc"));
-        }
-    }
-    g_object_set_data_full(G_OBJECT(list_row), "preview", pv, free_card_preview);
-    // 右栏行支持拖拽到中栏：提供字符串 payload "search:<id>:<isExtra>"
-    GtkDragSource *ds = gtk_drag_source_new();
-    // 与中栏一致，采用 MOVE 动作，确保目标接受
-    gtk_drag_source_set_actions(ds, GDK_ACTION_MOVE);
-    g_signal_connect(ds, "prepare", G_CALLBACK(on_drag_prepare), NULL);
-    g_signal_connect(ds, "drag-begin", G_CALLBACK(on_drag_begin), NULL);
-    // 在行上存储一个标记供 prepare 使用
-    g_object_set_data(G_OBJECT(list_row), "drag_kind", (gpointer)"search_row");
-    // 为拖拽预览使用行内缩略图的 pixbuf（若可用）
-    gtk_widget_add_controller(list_row, GTK_EVENT_CONTROLLER(ds));
-    gtk_list_box_append(GTK_LIST_BOX(ui->list), list_row);
+    if (!ui || !obj) return;
+    GPtrArray *items = g_ptr_array_new_with_free_func(g_object_unref);
+    g_ptr_array_add(items, ygo_card_item_new_from_json(obj));
+    search_results_append(ui, items);
+    g_ptr_array_unref(items);
 }
 
 void search_response_cb(GObject *source, GAsyncResult *res, gpointer user_data) {
     SoupSession *session = SOUP_SESSION(source);
     SearchUI *ui = (SearchUI*)user_data;
     GError *err = NULL;
+    SoupMessage *msg = soup_session_get_async_result_message(session, res);
+    guint64 generation = msg ? (guint64)GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(msg), "search_generation")) : 0;
     GInputStream *in = soup_session_send_finish(session, res, &err);
     
     // 如果请求被取消（例如新搜索开始），直接返回
     if (err && g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
         g_error_free(err);
+        if (in) g_object_unref(in);
         return;
     }
     
@@ -554,6 +317,13 @@ void search_response_cb(GObject *source, GAsyncResult *res, gpointer user_data)
         if (err) g_error_free(err); 
         return; 
     }
+    if (err) g_error_free(err);
+
+    // 已有更新的搜索，丢弃本次结果
+    if (generation != ui->search_generation) {
+        g_object_unref(in);
+        return;
+    }
     GByteArray *ba = g_byte_array_new();
     guint8 bufread[4096];
     gssize n;
@@ -610,22 +380,162 @@ void on_trap_filter_toggled(GtkCheckButton *btn, gpointer user_data) {
     ui->filter_by_trap = gtk_check_button_get_active(btn);
 }
 
+// 搜索结果分块投递到主线程的大小
+#define SEARCH_CHUNK_SIZE 200
+
+// 后台搜索任务：先行卡 + 离线数据的扫描和筛选都在工作线程中执行，
+// 结果按块通过主循环投递给 queue_result_for_render
+typedef struct {
+    SearchUI *ui;
+    guint64 generation;        // 发起搜索时的 ui->search_generation
+    gchar *query;
+    gboolean search_all;
+    gboolean show_prerelease;
+    gboolean offline_enabled;
+    FilterPredicate filter;    // 编译好的筛选谓词快照（共享只读的字段代码数组）
+    GCancellable *cancellable;
+    GPtrArray *chunk;          // 当前尚未投递的结果
+    guint result_count;
+} SearchJob;
+
+// 投递到主线程的一块结果
 typedef struct {
     SearchUI *ui;
-    const FilterState *filter;
-    guint *result_count;
-} OfflineCollectCtx;
+    guint64 generation;
+    GPtrArray *items;          // JsonObject*，free func 为 json_object_unref
+} SearchChunk;
+
+static void search_job_free(gpointer data) {
+    SearchJob *job = (SearchJob*)data;
+    if (!job) return;
+    g_free(job->query);
+    filter_predicate_clear(&job->filter);
+    g_clear_object(&job->cancellable);
+    if (job->chunk) g_ptr_array_unref(job->chunk);
+    g_free(job);
+}
+
+static void search_chunk_free(gpointer data) {
+    SearchChunk *chunk = (SearchChunk*)data;
+    if (!chunk) return;
+    g_ptr_array_unref(chunk->items);
+    g_free(chunk);
+}
+
+// 主线程：把一块结果加入渲染队列；过期（已有新搜索）的块直接丢弃
+static gboolean search_chunk_deliver(gpointer user_data) {
+    SearchChunk *chunk = (SearchChunk*)user_data;
+    SearchUI *ui = chunk->ui;
+    if (!ui || chunk->generation != ui->search_generation) {
+        return G_SOURCE_REMOVE;
+    }
+    for (guint i = 0; i < chunk->items->len; i++) {
+        queue_result_for_render(ui, g_ptr_array_index(chunk->items, i));
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// 工作线程：把当前块投递到主线程
+static void search_job_flush(SearchJob *job) {
+    if (!job->chunk || job->chunk->len == 0) return;
+    if (g_cancellable_is_cancelled(job->cancellable)) {
+        g_ptr_array_set_size(job->chunk, 0);
+        return;
+    }
+    SearchChunk *chunk = g_new0(SearchChunk, 1);
+    chunk->ui = job->ui;
+    chunk->generation = job->generation;
+    chunk->items = job->chunk;
+    job->chunk = g_ptr_array_new_with_free_func((GDestroyNotify)json_object_unref);
+    g_idle_add_full(G_PRIORITY_HIGH_IDLE, search_chunk_deliver, chunk, search_chunk_free);
+}
+
+// 工作线程：收集一条结果（接管 obj 的一个引用）
+static void search_job_push(SearchJob *job, JsonObject *obj) {
+    g_ptr_array_add(job->chunk, obj);
+    job->result_count++;
+    if (job->chunk->len >= SEARCH_CHUNK_SIZE) {
+        search_job_flush(job);
+    }
+}
+
+// offline_foreach_card 的 filter_cb：直接用数值列求值，未通过的卡片不会构建 JSON
+static gboolean offline_filter_cb(const CardNumericFields *fields, gpointer user_data) {
+    SearchJob *job = (SearchJob*)user_data;
+    return filter_predicate_eval(&job->filter, fields);
+}
 
 // offline_foreach_card 的 match_cb：返回 TRUE 表示“接受并计数”
 static gboolean offline_collect_match_cb(JsonObject *item, gpointer user_data) {
-    OfflineCollectCtx *c = (OfflineCollectCtx*)user_data;
-    if (!item || !c || !c->ui || !c->filter || !c->result_count) return FALSE;
-    if (!apply_filter(item, c->filter)) return FALSE;
-    queue_result_for_render(c->ui, item);
-    (*c->result_count)++;
+    SearchJob *job = (SearchJob*)user_data;
+    if (!item || !job) return FALSE;
+    search_job_push(job, json_object_ref(item));
     return TRUE;
 }
 
+static void search_task_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
+    (void)source_object;
+    SearchJob *job = (SearchJob*)task_data;
+
+    // 如果启用了先行卡显示，先添加先行卡搜索结果
+    if (job->show_prerelease && !g_cancellable_is_cancelled(cancellable)) {
+        JsonArray *prerelease_results = job->search_all ? get_all_prerelease_cards() : search_prerelease_cards(job->query);
+        if (prerelease_results) {
+            guint len = json_array_get_length(prerelease_results);
+            for (guint i = 0; i < len; i++) {
+                if (g_cancellable_is_cancelled(cancellable)) break;
+                JsonObject *item = json_array_get_object_element(prerelease_results, i);
+                // 应用筛选条件
+                if (item && filter_predicate_match_json(&job->filter, item)) {
+                    // 添加一个标记表示这是先行卡（结果数组中的对象为独立副本，可以修改）
+                    json_object_set_boolean_member(item, "is_prerelease", TRUE);
+                    search_job_push(job, json_object_ref(item));
+                }
+            }
+            json_array_unref(prerelease_results);
+        }
+    }
+
+    if (job->offline_enabled && !g_cancellable_is_cancelled(cancellable)) {
+        // 使用离线数据搜索：流式遍历 + 过滤；结果列表是虚拟化的，不再限制条数
+        g_message("Searching in offline data...");
+        (void)offline_foreach_card(job->query, job->search_all, offline_filter_cb,
+                                   offline_collect_match_cb, job, 0, cancellable);
+    }
+
+    search_job_flush(job);
+    g_task_return_boolean(task, TRUE);
+}
+
+// 主线程：搜索结束
+static void search_task_finished(GObject *source, GAsyncResult *res, gpointer user_data) {
+    (void)source;
+    (void)user_data;
+    SearchJob *job = (SearchJob*)g_task_get_task_data(G_TASK(res));
+    (void)g_task_propagate_boolean(G_TASK(res), NULL);
+    SearchUI *ui = job->ui;
+    if (!ui || job->generation != ui->search_generation || g_cancellable_is_cancelled(job->cancellable)) {
+        return;
+    }
+    g_message("Search finished: %u results", job->result_count);
+}
+
+// 取消正在进行的搜索：后台扫描立即停止，尚未投递的结果块会因代次变化被丢弃
+void search_cancel_pending(SearchUI *ui) {
+    if (!ui) return;
+    ui->search_generation++;
+    if (ui->search_cancellable) {
+        g_cancellable_cancel(ui->search_cancellable);
+        g_clear_object(&ui->search_cancellable);
+    }
+}
+
+void on_search_entry_changed(GtkEditable *editable, gpointer user_data) {
+    (void)editable;
+    // 输入新的关键词时立即打断仍在进行的扫描，不必等它跑完
+    search_cancel_pending((SearchUI*)user_data);
+}
+
 void on_search_clicked(GtkButton *btn, gpointer user_data) {
     (void)btn;
     SearchUI *ui = (SearchUI*)user_data;
@@ -636,6 +546,9 @@ void on_search_clicked(GtkButton *btn, gpointer user_data) {
         return;
     }
 
+    // 打断上一次仍在进行的后台搜索，并使其已排队的结果失效
+    search_cancel_pending(ui);
+
     // 首先停止图片加载定时器，防止它在清理过程中访问数据
     if (ui->search_image_loader_id > 0) {
         g_source_remove(ui->search_image_loader_id);
@@ -648,9 +561,6 @@ void on_search_clicked(GtkButton *btn, gpointer user_data) {
         ui->batch_render_id = 0;
     }
     
-    // 注意：移除 g_main_context_iteration 调用，因为它可能导致重入问题
-    // 我们依赖于弱引用和 row_invalid 标记来防止访问已销毁的对象
-    
     // 清理待渲染队列
     GPtrArray *old_pending = ui->pending_results;
     ui->pending_results = NULL;
@@ -669,87 +579,37 @@ void on_search_clicked(GtkButton *btn, gpointer user_data) {
     // 取消所有未完成的下载任务（通过递增代次）
     cancel_all_pending();
     
-    // 在清空UI列表之前，标记所有现有行为"无效"
-    // 这样即使有待处理的事件回调，它们也会检测到标记并跳过处理
-    GtkWidget *list_child = gtk_widget_get_first_child(ui->list);
-    while (list_child) {
-        if (GTK_IS_LIST_BOX_ROW(list_child)) {
-            g_object_set_data(G_OBJECT(list_child), "row_invalid", GINT_TO_POINTER(1));
-        }
-        list_child = gtk_widget_get_next_sibling(list_child);
-    }
-    
-    // 最后清空UI列表（这会销毁widget并触发弱引用清理）
-    list_clear(GTK_LIST_BOX(ui->list));
+    // 清空结果列表（行控件由 GtkListView 解绑回收，解绑后事件回调取不到卡片信息）
+    search_results_clear(ui);
 
-    // 获取当前筛选状态（在搜索先行卡之前就获取）
-    const FilterState *filter = get_current_filter_state();
-    
     // 判断是否需要搜索所有卡片（搜索框为空但有筛选条件）
     gboolean search_all = (!q || *q == '\0') && has_active_filter();
-    
-    // 设置最大结果数限制，避免UI卡死
-    const guint MAX_RESULTS = 500;
-    guint result_count = 0;
-
-    // 如果启用了先行卡显示，先添加先行卡搜索结果
-    if (show_prerelease_cards && result_count < MAX_RESULTS) {
-        JsonArray *prerelease_results = search_all ? get_all_prerelease_cards() : search_prerelease_cards(q);
-        if (prerelease_results) {
-            guint len = json_array_get_length(prerelease_results);
-            for (guint i = 0; i < len && result_count < MAX_RESULTS; i++) {
-                JsonObject *item = json_array_get_object_element(prerelease_results, i);
-                if (item) {
-                    // 应用筛选条件
-                    if (apply_filter(item, filter)) {
-                        // 添加一个标记表示这是先行卡
-                        JsonObject *marked_item = json_object_ref(item);
-                        json_object_set_boolean_member(marked_item, "is_prerelease", TRUE);
-                        queue_result_for_render(ui, marked_item);
-                        json_object_unref(marked_item);
-                        result_count++;
-                    }
-                }
-            }
-            json_array_unref(prerelease_results);
-            
-            // 如果先行卡就达到最大结果数，显示警告
-            if (result_count >= MAX_RESULTS) {
-                g_message("Reached maximum result limit (%u) with prerelease cards", MAX_RESULTS);
-                if (ui->toast_overlay) {
-                    AdwToast *toast = adw_toast_new("搜索结果过多，已限制为 500 条。请缩小搜索范围。");
-                    adw_toast_set_timeout(toast, 3);
-                    adw_toast_overlay_add_toast(ui->toast_overlay, toast);
-                }
-            }
-        }
-    }
 
     // 检查是否启用离线数据
-    gboolean offline_enabled = load_offline_data_switch_state();
-    
-    if (offline_enabled && offline_data_exists() && result_count < MAX_RESULTS) {
-        // 使用离线数据搜索：改为流式遍历 + 过滤 + 达到上限即停止
-        g_message("Searching in offline data...");
-
-        OfflineCollectCtx ctx = {
-            .ui = ui,
-            .filter = filter,
-            .result_count = &result_count,
-        };
-
-        guint remaining = (MAX_RESULTS > result_count) ? (MAX_RESULTS - result_count) : 0;
-        (void)offline_foreach_card(q, search_all, offline_collect_match_cb, &ctx, remaining);
-
-        if (result_count >= MAX_RESULTS) {
-            g_message("Reached maximum result limit (%u), stopping search", MAX_RESULTS);
-            if (ui->toast_overlay) {
-                AdwToast *toast = adw_toast_new("搜索结果过多，已限制为 500 条。请缩小搜索范围。");
-                adw_toast_set_timeout(toast, 3);
-                adw_toast_overlay_add_toast(ui->toast_overlay, toast);
-            }
-        }
-    } else if (!search_all && result_count < MAX_RESULTS) {
+    gboolean offline_enabled = load_offline_data_switch_state() && offline_data_exists();
+
+    ui->search_cancellable = g_cancellable_new();
+
+    if (show_prerelease_cards || offline_enabled) {
+        // 先行卡与离线数据的扫描/筛选放到后台线程，结果分块流式投递
+        SearchJob *job = g_new0(SearchJob, 1);
+        job->ui = ui;
+        job->generation = ui->search_generation;
+        job->query = g_strdup(q ? q : "");
+        job->search_all = search_all;
+        job->show_prerelease = show_prerelease_cards;
+        job->offline_enabled = offline_enabled;
+        filter_predicate_copy(&job->filter, get_current_filter_predicate());
+        job->cancellable = g_object_ref(ui->search_cancellable);
+        job->chunk = g_ptr_array_new_with_free_func((GDestroyNotify)json_object_unref);
+
+        GTask *task = g_task_new(NULL, job->cancellable, search_task_finished, NULL);
+        g_task_set_task_data(task, job, search_job_free);
+        g_task_run_in_thread(task, search_task_thread);
+        g_object_unref(task);
+    }
+
+    if (!offline_enabled && !search_all) {
         // 仅在有搜索关键词时进行在线API搜索
         // 如果搜索框为空但有筛选条件，不进行在线搜索
         char *escaped = g_uri_escape_string(q, NULL, TRUE);
@@ -759,357 +619,292 @@ void on_search_clicked(GtkButton *btn, gpointer user_data) {
         SoupMessage *msg = soup_message_new("GET", url);
         g_free(url);
         if (!msg) return;
-        // 搜索请求不使用 cancellable，让请求自然完成
-        // 回调中会检查是否应该处理结果
-        soup_session_send_async(ui->session, msg, G_PRIORITY_DEFAULT, NULL, search_response_cb, ui);
+        // 记录发起时的搜索代次，回调中据此丢弃过期结果；新搜索会取消该请求
+        g_object_set_data(G_OBJECT(msg), "search_generation", GSIZE_TO_POINTER((gsize)ui->search_generation));
+        soup_session_send_async(ui->session, msg, G_PRIORITY_DEFAULT, ui->search_cancellable, search_response_cb, ui);
         g_object_unref(msg);  // soup_session_send_async 会内部增加引用
-    } else {
+    } else if (search_all && !offline_enabled) {
         // 搜索框为空但有筛选条件，且离线数据未启用
         // 在这种情况下，只显示先行卡的筛选结果（如果有）
         g_message("Search query is empty with active filters, but offline data is not enabled");
     }
 }
-// 应用筛选条件到搜索结果
-// 返回值：TRUE 表示卡片通过筛选，FALSE 表示应该被过滤掉
-gboolean apply_filter(JsonObject *card, const FilterState *filter_state) {
-    if (!card || !filter_state) {
-        return TRUE;
-    }
-    
-    // 判断卡片数据结构类型并缓存data对象（如果是离线数据）
-    gboolean is_prerelease = json_object_has_member(card, "type");
-    JsonObject *data = NULL;
-    
-    if (!is_prerelease) {
-        if (json_object_has_member(card, "data")) {
-            data = json_object_get_object_member(card, "data");
-        }
-    }
-    
-    // 定义辅助宏来获取卡片字段（先行卡或离线数据）
-    #define GET_CARD_INT_FIELD(field_name, default_value) \
-        (is_prerelease \
-            ? (json_object_has_member(card, field_name) ? json_object_get_int_member(card, field_name) : (default_value)) \
-            : (data && json_object_has_member(data, field_name) ? json_object_get_int_member(data, field_name) : (default_value)))
-    
-    // 首先检查字段筛选（不依赖卡片类型选择）
+
+// 怪兽类别对应的type位（按照UI中的顺序）
+// "通常", "效果", "仪式", "融合", "同调", "超量", "灵摆", "连接", "调整",
+// "灵魂", "同盟", "二重", "反转", "卡通", "特殊召唤"
+static const uint32_t monster_type_flags[15] = {
+    0x10,       // 通常 TYPE_NORMAL
+    0x20,       // 效果 TYPE_EFFECT
+    0x80,       // 仪式 TYPE_RITUAL
+    0x40,       // 融合 TYPE_FUSION
+    0x2000,     // 同调 TYPE_SYNCHRO
+    0x800000,   // 超量 TYPE_XYZ
+    0x1000000,  // 灵摆 TYPE_PENDULUM
+    0x4000000,  // 连接 TYPE_LINK
+    0x1000,     // 调整 TYPE_TUNER
+    0x200,      // 灵魂 TYPE_SPIRIT
+    0x400,      // 同盟 TYPE_UNION
+    0x800,      // 二重 TYPE_DUAL
+    0x200000,   // 反转 TYPE_FLIP
+    0x400000,   // 卡通 TYPE_TOON
+    0x2000000   // 特殊召唤 TYPE_SPSUMMON
+};
+
+// 连接箭头顺序：↖ ↑ ↗ ← → ↙ ↓ ↘
+static const uint32_t link_marker_flags[8] = {
+    0x040,  // ↖ LINK_MARKER_TOP_LEFT
+    0x080,  // ↑ LINK_MARKER_TOP
+    0x100,  // ↗ LINK_MARKER_TOP_RIGHT
+    0x008,  // ← LINK_MARKER_LEFT
+    0x020,  // → LINK_MARKER_RIGHT
+    0x001,  // ↙ LINK_MARKER_BOTTOM_LEFT
+    0x002,  // ↓ LINK_MARKER_BOTTOM
+    0x004   // ↘ LINK_MARKER_BOTTOM_RIGHT
+};
+
+// 属性列表：全部(0), 地(1), 水(2), 炎(3), 风(4), 光(5), 暗(6), 神(7)
+static const char *const attribute_names[] = {
+    "全部", "地", "水", "炎", "风", "光", "暗", "神"
+};
+
+// 种族列表按UI顺序
+static const char *const race_names[] = {
+    "全部", "战士", "魔法师", "天使", "恶魔", "不死", "机械",
+    "水", "炎", "岩石", "鸟兽", "植物", "昆虫", "雷", "龙", "兽",
+    "兽战士", "恐龙", "鱼", "海龙", "爬虫类", "念动力",
+    "幻神兽", "创造神", "幻龙", "电子界", "幻想魔"
+};
+
+static const char *const spell_category_names[] = {
+    "全部", "通常", "仪式", "速攻", "永续", "装备", "场地"
+};
+
+static const char *const trap_category_names[] = {
+    "全部", "通常", "永续", "反击"
+};
+
+#define TYPE_MONSTER_FLAG   0x1
+#define TYPE_PENDULUM_FLAG  0x1000000
+#define TYPE_LINK_FLAG      0x4000000
+
+// 下拉框选项下标 -> 名称，越界时视为"全部"
+static const char* filter_option_name(const char *const *names, guint n_names, guint selected) {
+    return selected < n_names ? names[selected] : "全部";
+}
+
+// 解析筛选文本中的整数；空文本表示不筛选
+static gint32 filter_parse_number(const gchar *text) {
+    if (!text || text[0] == '\0') return FILTER_ANY;
+    return (gint32)atoi(text);
+}
+
+void filter_predicate_compile(FilterPredicate *pred, const FilterState *filter_state) {
+    memset(pred, 0, sizeof(*pred));
+    pred->left_scale = FILTER_ANY;
+    pred->right_scale = FILTER_ANY;
+    pred->atk = FILTER_ANY;
+    pred->def = FILTER_ANY;
+    pred->level = FILTER_ANY;
+    if (!filter_state) return;
+
+    pred->card_type_selected = filter_state->card_type_selected;
+
+    // 字段名只在这里解析一次，之后逐卡只做整数比较
     if (filter_state->field_text && filter_state->field_text[0] != '\0') {
-        // 获取卡片的setcode字段
-        gint64 card_setcode = GET_CARD_INT_FIELD("setcode", 0);
-        
-        // 使用card_info中的函数检查字段匹配
-        if (!match_setcode_with_field(card_setcode, filter_state->field_text)) {
-            return FALSE;
-        }
-    }
-    
-    // 如果卡片类型选择是"全部"，不进行类型筛选
-    if (filter_state->card_type_selected == 0) {
-        return TRUE;
+        pred->has_field = TRUE;
+        pred->field_setcodes = resolve_setcodes_for_field(filter_state->field_text);
     }
-    
-    // 获取卡片的type字段
-    gint64 card_type = 0;
-    
-    if (is_prerelease) {
-        // 先行卡结构：直接有type字段
-        card_type = json_object_get_int_member(card, "type");
-    } else if (data && json_object_has_member(data, "type")) {
-        // 离线数据结构：type在data对象中
-        card_type = json_object_get_int_member(data, "type");
-    } else {
-        return FALSE;
-    }
-    
-    // 怪兽卡筛选
-    if (filter_state->card_type_selected == 1) {
-        // 首先检查是否是怪兽卡
-        if (!(card_type & 0x1)) {  // TYPE_MONSTER = 0x1
-            return FALSE;
-        }
-        
-        // 检查是否有任何怪兽类别被选中
-        gboolean any_toggle_active = FALSE;
+
+    switch (filter_state->card_type_selected) {
+    case 1:
+        pred->required_type = TYPE_MONSTER_FLAG;
         for (int i = 0; i < 15; i++) {
             if (filter_state->monster_type_toggles[i]) {
-                any_toggle_active = TRUE;
-                break;
+                pred->required_type |= monster_type_flags[i];
             }
         }
-        
-        // 如果有类别被选中，检查类别匹配
-        if (any_toggle_active) {
-            // 怪兽类别对应的type位（按照UI中的顺序）
-            // "通常", "效果", "仪式", "融合", "同调", "超量", "灵摆", "连接", "调整",
-            // "灵魂", "同盟", "二重", "反转", "卡通", "特殊召唤"
-            const uint32_t type_flags[15] = {
-                0x10,       // 通常 TYPE_NORMAL
-                0x20,       // 效果 TYPE_EFFECT
-                0x80,       // 仪式 TYPE_RITUAL
-                0x40,       // 融合 TYPE_FUSION
-                0x2000,     // 同调 TYPE_SYNCHRO
-                0x800000,   // 超量 TYPE_XYZ
-                0x1000000,  // 灵摆 TYPE_PENDULUM
-                0x4000000,  // 连接 TYPE_LINK
-                0x1000,     // 调整 TYPE_TUNER
-                0x200,      // 灵魂 TYPE_SPIRIT
-                0x400,      // 同盟 TYPE_UNION
-                0x800,      // 二重 TYPE_DUAL
-                0x200000,   // 反转 TYPE_FLIP
-                0x400000,   // 卡通 TYPE_TOON
-                0x2000000   // 特殊召唤 TYPE_SPSUMMON
-            };
-            
-            // 构建目标type：所有选中的类别的OR组合
-            uint32_t required_types = 0x1;  // 必须是怪兽
-            for (int i = 0; i < 15; i++) {
-                if (filter_state->monster_type_toggles[i]) {
-                    required_types |= type_flags[i];
-                }
-            }
-            
-            // 检查卡片是否包含所有选中的类别
-            gboolean match = ((card_type & required_types) == required_types);
-            
-            // 如果不匹配类别，直接返回
-            if (!match) {
-                return FALSE;
-            }
-        }
-        
-        // 检查连接箭头筛选（仅对连接怪兽有效）
-        // 检查是否有连接箭头被选中
-        gboolean any_link_marker_active = FALSE;
         for (int i = 0; i < 8; i++) {
             if (filter_state->link_marker_toggles[i]) {
-                any_link_marker_active = TRUE;
-                break;
-            }
-        }
-        
-        // 如果有连接箭头被选中，且卡片是连接怪兽，则检查箭头匹配
-        if (any_link_marker_active && (card_type & 0x4000000)) {  // TYPE_LINK = 0x4000000
-            // 连接箭头顺序：↖ ↑ ↗ ← → ↙ ↓ ↘
-            const uint32_t link_marker_flags[8] = {
-                0x040,  // ↖ LINK_MARKER_TOP_LEFT
-                0x080,  // ↑ LINK_MARKER_TOP
-                0x100,  // ↗ LINK_MARKER_TOP_RIGHT
-                0x008,  // ← LINK_MARKER_LEFT
-                0x020,  // → LINK_MARKER_RIGHT
-                0x001,  // ↙ LINK_MARKER_BOTTOM_LEFT
-                0x002,  // ↓ LINK_MARKER_BOTTOM
-                0x004   // ↘ LINK_MARKER_BOTTOM_RIGHT
-            };
-            
-            // 构建所需的连接箭头值
-            uint32_t required_markers = 0;
-            for (int i = 0; i < 8; i++) {
-                if (filter_state->link_marker_toggles[i]) {
-                    required_markers |= link_marker_flags[i];
-                }
-            }
-            
-            // 获取卡片的def字段（连接怪兽的def存储连接箭头）
-            gint64 card_def = GET_CARD_INT_FIELD("def", 0);
-            
-            // 检查连接箭头是否完全匹配
-            gboolean link_match = ((card_def & required_markers) == required_markers);
-            
-            return link_match;
-        }
-        
-        // 检查灵摆刻度筛选（仅对灵摆怪兽有效）
-        if (card_type & 0x1000000) {  // TYPE_PENDULUM = 0x1000000
-            // 检查是否有左刻度或右刻度筛选条件
-            gboolean has_left_scale_filter = (filter_state->left_scale_text && 
-                                               filter_state->left_scale_text[0] != '\0');
-            gboolean has_right_scale_filter = (filter_state->right_scale_text && 
-                                                filter_state->right_scale_text[0] != '\0');
-            
-            if (has_left_scale_filter || has_right_scale_filter) {
-                // 获取卡片的level字段
-                gint64 card_level_field = GET_CARD_INT_FIELD("level", 0);
-                
-                // 解析灵摆刻度
-                // level字段格式：第0-7位为等级，第16-23位为右刻度，第24-31位为左刻度
-                int card_left_scale = (card_level_field >> 24) & 0xFF;
-                int card_right_scale = (card_level_field >> 16) & 0xFF;
-                
-                // 检查左刻度
-                if (has_left_scale_filter) {
-                    int required_left_scale = atoi(filter_state->left_scale_text);
-                    if (card_left_scale != required_left_scale) {
-                        return FALSE;
-                    }
-                }
-                
-                // 检查右刻度
-                if (has_right_scale_filter) {
-                    int required_right_scale = atoi(filter_state->right_scale_text);
-                    if (card_right_scale != required_right_scale) {
-                        return FALSE;
-                    }
-                }
+                pred->link_markers |= link_marker_flags[i];
             }
         }
-        
-        // 检查属性筛选
         if (filter_state->attribute_selected != 0) {
-            // 属性列表：全部(0), 地(1), 水(2), 炎(3), 风(4), 光(5), 暗(6), 神(7)
-            const char *attributes[] = {
-                "全部", "地", "水", "炎", "风", "光", "暗", "神"
-            };
-            
-            const char *selected_attribute = NULL;
-            if (filter_state->attribute_selected < 8) {
-                selected_attribute = attributes[filter_state->attribute_selected];
-            } else {
-                selected_attribute = "全部";
-            }
-            
-            uint32_t required_attribute = get_attribute_from_string(selected_attribute);
-            
-            if (required_attribute != 0) {
-                // 获取卡片的attribute字段
-                gint64 card_attribute = GET_CARD_INT_FIELD("attribute", 0);
-                
-                // 检查属性是否匹配
-                if (card_attribute != required_attribute) {
-                    return FALSE;
-                }
-            }
+            pred->attribute = get_attribute_from_string(filter_option_name(
+                attribute_names, G_N_ELEMENTS(attribute_names), filter_state->attribute_selected));
         }
-        
-        // 检查种族筛选
         if (filter_state->race_selected != 0) {
-            // 种族列表按UI顺序
-            const char *races[] = {
-                "全部", "战士", "魔法师", "天使", "恶魔", "不死", "机械",
-                "水", "炎", "岩石", "鸟兽", "植物", "昆虫", "雷", "龙", "兽",
-                "兽战士", "恐龙", "鱼", "海龙", "爬虫类", "念动力",
-                "幻神兽", "创造神", "幻龙", "电子界", "幻想魔"
-            };
-            
-            const char *selected_race = NULL;
-            if (filter_state->race_selected < 27) {
-                selected_race = races[filter_state->race_selected];
-            } else {
-                selected_race = "全部";
-            }
-            
-            uint32_t required_race = get_race_from_string(selected_race);
-            
-            if (required_race != 0) {
-                // 获取卡片的race字段
-                gint64 card_race = GET_CARD_INT_FIELD("race", 0);
-                
-                // 检查种族是否匹配
-                if (card_race != required_race) {
-                    return FALSE;
-                }
-            }
-        }
-        
-        // 检查攻击力筛选
-        if (filter_state->atk_text && filter_state->atk_text[0] != '\0') {
-            int required_atk = atoi(filter_state->atk_text);
-            
-            // 获取卡片的atk字段
-            gint64 card_atk = GET_CARD_INT_FIELD("atk", -1);
-            
-            // 检查攻击力是否匹配
-            if (card_atk != required_atk) {
-                return FALSE;
-            }
-        }
-        
-        // 检查守备力筛选
-        // 注意：连接怪兽的def字段存储连接箭头，所以如果是连接怪兽则跳过守备力筛选
-        gboolean is_link_monster = (card_type & 0x4000000) != 0;  // TYPE_LINK = 0x4000000
-        
-        if (!is_link_monster && filter_state->def_text && filter_state->def_text[0] != '\0') {
-            int required_def = atoi(filter_state->def_text);
-            
-            // 获取卡片的def字段
-            gint64 card_def = GET_CARD_INT_FIELD("def", -1);
-            
-            // 检查守备力是否匹配
-            if (card_def != required_def) {
-                return FALSE;
-            }
-        }
-        
-        // 检查等级筛选
-        if (filter_state->level_text && filter_state->level_text[0] != '\0') {
-            int required_level = atoi(filter_state->level_text);
-            
-            // 获取卡片的level字段
-            gint64 card_level_field = GET_CARD_INT_FIELD("level", 0);
-            
-            // 从level字段中提取真正的等级（第0-7位）
-            // 灵摆怪兽的level字段包含灵摆刻度信息：
-            // 第0-7位为等级，第16-23位为右刻度，第24-31位为左刻度
-            int card_level = card_level_field & 0xFF;
-            
-            // 检查等级是否匹配
-            if (card_level != required_level) {
-                return FALSE;
-            }
-        }
-        
+            pred->race = get_race_from_string(filter_option_name(
+                race_names, G_N_ELEMENTS(race_names), filter_state->race_selected));
+        }
+        pred->left_scale = filter_parse_number(filter_state->left_scale_text);
+        pred->right_scale = filter_parse_number(filter_state->right_scale_text);
+        pred->atk = filter_parse_number(filter_state->atk_text);
+        pred->def = filter_parse_number(filter_state->def_text);
+        pred->level = filter_parse_number(filter_state->level_text);
+        break;
+    case 2:
+        pred->required_type = get_spell_type_from_category(filter_option_name(
+            spell_category_names, G_N_ELEMENTS(spell_category_names), filter_state->spell_type_selected));
+        break;
+    case 3:
+        pred->required_type = get_trap_type_from_category(filter_option_name(
+            trap_category_names, G_N_ELEMENTS(trap_category_names), filter_state->trap_type_selected));
+        break;
+    default:
+        break;
+    }
+}
+
+void filter_predicate_copy(FilterPredicate *dst, const FilterPredicate *src) {
+    *dst = *src;
+    if (src->field_setcodes) dst->field_setcodes = g_array_ref(src->field_setcodes);
+}
+
+void filter_predicate_clear(FilterPredicate *pred) {
+    if (!pred) return;
+    if (pred->field_setcodes) g_array_unref(pred->field_setcodes);
+    pred->field_setcodes = NULL;
+    pred->has_field = FALSE;
+}
+
+gboolean filter_predicate_eval(const FilterPredicate *pred, const CardNumericFields *fields) {
+    if (!pred || !fields) return TRUE;
+
+    // 字段筛选不依赖卡片类型选择
+    if (pred->has_field && !match_setcode_with_codes((uint64_t)fields->setcode, pred->field_setcodes)) {
+        return FALSE;
+    }
+
+    switch (pred->card_type_selected) {
+    case 0:
+        return TRUE;
+    case 1: {
+        guint32 type = fields->type;
+        if ((type & pred->required_type) != pred->required_type) return FALSE;
+
+        gboolean is_link = (type & TYPE_LINK_FLAG) != 0;
+        // 连接怪兽的def存储连接箭头，选中箭头时只比较箭头
+        if (pred->link_markers && is_link) {
+            return ((guint32)fields->def & pred->link_markers) == pred->link_markers;
+        }
+
+        // level字段格式：第0-7位为等级，第16-23位为右刻度，第24-31位为左刻度
+        guint32 level_field = (guint32)fields->level;
+        if (type & TYPE_PENDULUM_FLAG) {
+            if (pred->left_scale != FILTER_ANY && (gint32)((level_field >> 24) & 0xFF) != pred->left_scale) return FALSE;
+            if (pred->right_scale != FILTER_ANY && (gint32)((level_field >> 16) & 0xFF) != pred->right_scale) return FALSE;
+        }
+        if (pred->attribute != 0 && (guint32)fields->attribute != pred->attribute) return FALSE;
+        if (pred->race != 0 && (guint32)fields->race != pred->race) return FALSE;
+        if (pred->atk != FILTER_ANY && fields->atk != pred->atk) return FALSE;
+        if (!is_link && pred->def != FILTER_ANY && fields->def != pred->def) return FALSE;
+        if (pred->level != FILTER_ANY && (gint32)(level_field & 0xFF) != pred->level) return FALSE;
         return TRUE;
     }
-    
-    // 魔法卡筛选
-    if (filter_state->card_type_selected == 2) {
-        // 获取魔法类别对应的字符串
-        const char *spell_categories[] = {
-            "全部", "通常", "仪式", "速攻", "永续", "装备", "场地"
-        };
-        
-        const char *selected_category = NULL;
-        if (filter_state->spell_type_selected < 7) {
-            selected_category = spell_categories[filter_state->spell_type_selected];
-        } else {
-            selected_category = "全部";
-        }
-        
-        // 获取目标type值
-        guint32 target_type = get_spell_type_from_category(selected_category);
-        
-        // 检查卡片type是否匹配
-        // 使用精确匹配：卡片的type必须包含所有目标type的位
-        gboolean match = ((card_type & target_type) == target_type);
-        
-        return match;
+    case 2:
+    case 3:
+        return (fields->type & pred->required_type) == pred->required_type;
+    default:
+        return TRUE;
     }
-    
-    // 陷阱卡筛选
-    if (filter_state->card_type_selected == 3) {
-        // 获取陷阱类别对应的字符串
-        const char *trap_categories[] = {
-            "全部", "通常", "永续", "反击"
-        };
-        
-        const char *selected_category = NULL;
-        if (filter_state->trap_type_selected < 4) {
-            selected_category = trap_categories[filter_state->trap_type_selected];
-        } else {
-            selected_category = "全部";
-        }
-        
-        // 获取目标type值
-        guint32 target_type = get_trap_type_from_category(selected_category);
-        
-        // 检查卡片type是否匹配
-        gboolean match = ((card_type & target_type) == target_type);
-        
-        return match;
+}
+
+// 从 JSON 卡片中提取数值字段（先行卡字段在顶层，离线/在线数据在 data 中）
+// 返回卡片是否带有 type 字段
+static gboolean card_numeric_fields_from_json(JsonObject *card, CardNumericFields *out) {
+    gboolean is_prerelease = json_object_has_member(card, "type");
+    JsonObject *src = is_prerelease ? card
+        : (json_object_has_member(card, "data") ? json_object_get_object_member(card, "data") : NULL);
+
+    #define GET_INT(field_name, default_value) \
+        ((src && json_object_has_member(src, field_name)) ? json_object_get_int_member(src, field_name) : (default_value))
+    out->type = (guint32)GET_INT("type", 0);
+    out->atk = (gint32)GET_INT("atk", -1);
+    out->def = (gint32)GET_INT("def", -1);
+    out->level = (gint32)GET_INT("level", 0);
+    out->race = (gint32)GET_INT("race", 0);
+    out->attribute = (gint32)GET_INT("attribute", 0);
+    out->setcode = GET_INT("setcode", 0);
+    #undef GET_INT
+
+    return src && json_object_has_member(src, "type");
+}
+
+gboolean filter_predicate_match_json(const FilterPredicate *pred, JsonObject *card) {
+    if (!card || !pred) return TRUE;
+    CardNumericFields fields;
+    gboolean has_type = card_numeric_fields_from_json(card, &fields);
+    // 选择了卡片类型但缺少 type 字段的卡片不通过
+    if (!has_type && pred->card_type_selected != 0) {
+        return FALSE;
     }
-    
-    // 清理宏定义
-    #undef GET_CARD_INT_FIELD
-    
-    // 其他类型暂不实现
+    return filter_predicate_eval(pred, &fields);
+}
+
+// ===== 筛选性能对比（YGO_FILTER_BENCH） =====
+
+typedef struct {
+    FilterPredicate pred;
+    GPtrArray *cards;   // JsonObject*
+    GArray *fields;     // CardNumericFields，与 cards 一一对应
+} FilterBenchJob;
+
+static gboolean filter_bench_collect_fields(const CardNumericFields *fields, gpointer user_data) {
+    FilterBenchJob *job = (FilterBenchJob*)user_data;
+    g_array_append_val(job->fields, *fields);
+    return TRUE;
+}
+
+static gboolean filter_bench_collect_card(JsonObject *card, gpointer user_data) {
+    FilterBenchJob *job = (FilterBenchJob*)user_data;
+    g_ptr_array_add(job->cards, json_object_ref(card));
     return TRUE;
 }
+
+static gpointer filter_bench_thread(gpointer data) {
+    FilterBenchJob *job = (FilterBenchJob*)data;
+    job->cards = g_ptr_array_new_with_free_func((GDestroyNotify)json_object_unref);
+    job->fields = g_array_new(FALSE, FALSE, sizeof(CardNumericFields));
+
+    // 同一批卡片：JSON 对象与 cards.bin 数值列一一对应
+    (void)offline_foreach_card(NULL, TRUE, filter_bench_collect_fields, filter_bench_collect_card, job, 0, NULL);
+    guint n = job->cards->len;
+
+    if (n > 0) {
+        guint matched_json = 0, matched_columns = 0;
+
+        gint64 t0 = g_get_monotonic_time();
+        for (guint i = 0; i < n; i++) {
+            if (filter_predicate_match_json(&job->pred, g_ptr_array_index(job->cards, i))) matched_json++;
+        }
+        gint64 t1 = g_get_monotonic_time();
+        for (guint i = 0; i < n; i++) {
+            if (filter_predicate_eval(&job->pred, &g_array_index(job->fields, CardNumericFields, i))) matched_columns++;
+        }
+        gint64 t2 = g_get_monotonic_time();
+
+        #define CARDS_PER_SEC(us) ((double)n * G_USEC_PER_SEC / (double)MAX((us), 1))
+        g_message("Filter benchmark (%u cards): JSON path %.0f cards/s (%u matched), "
+                  "cards.bin columns %.0f cards/s (%u matched)%s",
+                  n, CARDS_PER_SEC(t1 - t0), matched_json,
+                  CARDS_PER_SEC(t2 - t1), matched_columns,
+                  matched_json == matched_columns ? "" : " [MISMATCH]");
+        #undef CARDS_PER_SEC
+    }
+
+    g_ptr_array_unref(job->cards);
+    g_array_unref(job->fields);
+    filter_predicate_clear(&job->pred);
+    g_free(job);
+    return NULL;
+}
+
+void filter_benchmark_maybe_run(const FilterPredicate *pred) {
+    if (!pred || !g_getenv("YGO_FILTER_BENCH")) return;
+    if (!offline_data_exists()) return;
+
+    FilterBenchJob *job = g_new0(FilterBenchJob, 1);
+    filter_predicate_copy(&job->pred, pred);
+    g_thread_unref(g_thread_new("filter-bench", filter_bench_thread, job));
+}
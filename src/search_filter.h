@@ -4,15 +4,22 @@
 #include <gtk/gtk.h>
 #include <json-glib/json-glib.h>
 #include "app_types.h"
+#include "card_store.h"
 
 // 搜索结果图片加载数据结构
 typedef struct {
     int img_id;
     gboolean is_prerelease;
+    int priority;  // ImageLoadPriority，按视口位置计算
+    guint seq;     // 入队序号，同优先级按入队顺序加载
 } SearchImageToLoad;
 
 // 搜索与过滤相关回调
 void on_search_clicked(GtkButton *btn, gpointer user_data);
+void on_search_entry_changed(GtkEditable *editable, gpointer user_data);
+
+// 取消正在进行的后台搜索（递增搜索代次，已排队但未渲染的结果块将被丢弃）
+void search_cancel_pending(SearchUI *ui);
 void on_monster_filter_toggled(GtkCheckButton *btn, gpointer user_data);
 void on_spell_filter_toggled(GtkCheckButton *btn, gpointer user_data);
 void on_trap_filter_toggled(GtkCheckButton *btn, gpointer user_data);
@@ -49,13 +56,62 @@ typedef struct {
     gchar *field_text;  // 卡片字段文本
 } FilterState;
 
-// 应用筛选条件到搜索结果
-// 返回值：TRUE 表示卡片通过筛选，FALSE 表示应该被过滤掉
-gboolean apply_filter(JsonObject *card, const FilterState *filter_state);
+// 数值条件的“不筛选”标记
+#define FILTER_ANY G_MININT32
+
+// 编译后的筛选谓词：筛选对话框关闭时由 FilterState 编译一次，
+// 类别/属性/种族/文本条件全部预先换算为位掩码和整数，逐卡判断时不再做任何字符串处理
+typedef struct {
+    guint card_type_selected;  // 同 FilterState (0=全部, 1=怪兽, 2=魔法, 3=陷阱)
+    guint32 required_type;     // 怪兽：0x1 | 选中类别位；魔法/陷阱：目标 type 位
+    guint32 link_markers;      // 需要包含的连接箭头位，0 表示不筛选
+    guint32 attribute;         // 0 表示不筛选
+    guint32 race;              // 0 表示不筛选
+    gint32 left_scale;         // FILTER_ANY 表示不筛选，下同
+    gint32 right_scale;
+    gint32 atk;
+    gint32 def;
+    gint32 level;
+    gboolean has_field;        // 是否有字段筛选
+    GArray *field_setcodes;    // 字段代码（guint16），has_field 为 TRUE 时有效
+} FilterPredicate;
+
+/**
+ * 将筛选状态编译为谓词（会解析字段名，应在主线程调用）
+ * @param pred 输出谓词，旧内容需先用 filter_predicate_clear 释放
+ */
+void filter_predicate_compile(FilterPredicate *pred, const FilterState *filter_state);
+
+/**
+ * 复制谓词（共享字段代码数组的引用），供后台搜索持有快照
+ */
+void filter_predicate_copy(FilterPredicate *dst, const FilterPredicate *src);
+
+void filter_predicate_clear(FilterPredicate *pred);
+
+/**
+ * 用卡片的数值字段判断是否通过筛选
+ */
+gboolean filter_predicate_eval(const FilterPredicate *pred, const CardNumericFields *fields);
+
+/**
+ * 对 JSON 卡片（先行卡/离线/在线结构）求值：先提取数值字段再调用 filter_predicate_eval
+ */
+gboolean filter_predicate_match_json(const FilterPredicate *pred, JsonObject *card);
 
 // 获取当前筛选状态（从main.c中）
 const FilterState* get_current_filter_state(void);
 
+// 获取当前编译好的筛选谓词（从main.c中，主线程调用；字段名缓存失效后会重新编译）
+const FilterPredicate* get_current_filter_predicate(void);
+
+/**
+ * 筛选性能对比：设置环境变量 YGO_FILTER_BENCH 后，每次编译筛选条件时在后台线程
+ * 对同一批离线卡片分别用 JSON 路径（filter_predicate_match_json）和 cards.bin 数值列
+ * （filter_predicate_eval）求值，输出每秒处理卡片数；未设置时直接返回
+ */
+void filter_benchmark_maybe_run(const FilterPredicate *pred);
+
 // 检查是否有活动的筛选条件
 gboolean has_active_filter(void);
 
@@ -0,0 +1,79 @@
+#include "search_keys.h"
+#include <string.h>
+
+struct SearchKeys {
+    GString *arena;     // 所有记录的折叠键，每条以 '\0' 结尾
+    GArray *offsets;    // guint32，第 i 条记录在 arena 中的起始位置
+};
+
+gchar* search_key_fold(const char *text) {
+    if (!text) return NULL;
+    // NFKC：全角英数/符号 -> 半角，半角片假名 -> 全角，合成浊音符
+    gchar *normalized = g_utf8_normalize(text, -1, G_NORMALIZE_ALL_COMPOSE);
+    if (!normalized) {
+        // 非法 UTF-8，退化为仅做大小写折叠
+        return g_utf8_strdown(text, -1);
+    }
+    gchar *folded = g_utf8_casefold(normalized, -1);
+    g_free(normalized);
+    return folded;
+}
+
+SearchKeys* search_keys_new(guint capacity_hint) {
+    SearchKeys *keys = g_new0(SearchKeys, 1);
+    keys->arena = g_string_sized_new((gsize)capacity_hint * 256);
+    keys->offsets = g_array_sized_new(FALSE, FALSE, sizeof(guint32), capacity_hint);
+    return keys;
+}
+
+void search_keys_free(SearchKeys *keys) {
+    if (!keys) return;
+    g_string_free(keys->arena, TRUE);
+    g_array_unref(keys->offsets);
+    g_free(keys);
+}
+
+void search_keys_append(SearchKeys *keys, const char * const *fields, guint n_fields) {
+    if (!keys) return;
+    guint32 start = (guint32)keys->arena->len;
+    g_array_append_val(keys->offsets, start);
+
+    gboolean first = TRUE;
+    for (guint i = 0; i < n_fields; i++) {
+        if (!fields[i] || fields[i][0] == '\0') continue;
+        gchar *folded = search_key_fold(fields[i]);
+        if (!folded) continue;
+        if (!first) g_string_append_c(keys->arena, SEARCH_KEY_FIELD_SEP);
+        g_string_append(keys->arena, folded);
+        g_free(folded);
+        first = FALSE;
+    }
+    // 每条键以 '\0' 结尾，GString 自身的结尾 '\0' 不计入 len
+    g_string_append_c(keys->arena, '\0');
+}
+
+guint search_keys_get_count(const SearchKeys *keys) {
+    return keys ? keys->offsets->len : 0;
+}
+
+const char* search_keys_get(const SearchKeys *keys, guint index, gsize *length) {
+    if (!keys || index >= keys->offsets->len) {
+        if (length) *length = 0;
+        return NULL;
+    }
+    guint32 start = g_array_index(keys->offsets, guint32, index);
+    guint32 end = (index + 1 < keys->offsets->len)
+        ? g_array_index(keys->offsets, guint32, index + 1)
+        : (guint32)keys->arena->len;
+    if (length) *length = end - start - 1;
+    return keys->arena->str + start;
+}
+
+gboolean search_keys_match(const SearchKeys *keys, guint index, const char *query_folded, gsize *bytes_scanned) {
+    if (!query_folded || query_folded[0] == '\0') return TRUE;
+    gsize length = 0;
+    const char *key = search_keys_get(keys, index, &length);
+    if (!key) return FALSE;
+    if (bytes_scanned) *bytes_scanned += length;
+    return strstr(key, query_folded) != NULL;
+}
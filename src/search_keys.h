@@ -0,0 +1,53 @@
+#ifndef SEARCH_KEYS_H
+#define SEARCH_KEYS_H
+
+#include <glib.h>
+
+// 预计算的搜索键：每条记录的可搜索字段（卡名、效果描述等）在加载时统一折叠
+// （NFKC 全角/半角归一 + 大小写折叠），以 SEARCH_KEY_FIELD_SEP 分隔后
+// 连续存放在同一块内存中，下标与卡片顺序一致。搜索时只需对查询串折叠一次，
+// 之后直接在键上做子串匹配，不再产生任何分配。
+
+// 字段分隔符（查询串中不会出现，保证匹配不会跨字段）
+#define SEARCH_KEY_FIELD_SEP '\x1f'
+
+typedef struct SearchKeys SearchKeys;
+
+/**
+ * 折叠字符串用于搜索（NFKC 归一化 + 大小写折叠）
+ * @param text 原始字符串
+ * @return 新分配的折叠后字符串，调用者需要 g_free 释放；text 为 NULL 时返回 NULL
+ */
+gchar* search_key_fold(const char *text);
+
+/**
+ * 创建空的搜索键集合
+ * @param capacity_hint 预计记录数
+ */
+SearchKeys* search_keys_new(guint capacity_hint);
+void search_keys_free(SearchKeys *keys);
+
+/**
+ * 追加一条记录（字段会被折叠后拼接）
+ * @param fields 字段数组，元素可以为 NULL（视为空）
+ * @param n_fields 字段数量
+ */
+void search_keys_append(SearchKeys *keys, const char * const *fields, guint n_fields);
+
+guint search_keys_get_count(const SearchKeys *keys);
+
+/**
+ * 获取第 index 条记录的折叠键
+ * @param length 输出键的字节长度（不含结尾 '\0'），可为 NULL
+ * @return 指向内部内存的字符串，不需要释放
+ */
+const char* search_keys_get(const SearchKeys *keys, guint index, gsize *length);
+
+/**
+ * 判断第 index 条记录是否包含查询串
+ * @param query_folded 已用 search_key_fold 折叠的查询串
+ * @param bytes_scanned 累加本次扫描的键字节数，可为 NULL
+ */
+gboolean search_keys_match(const SearchKeys *keys, guint index, const char *query_folded, gsize *bytes_scanned);
+
+#endif // SEARCH_KEYS_H
@@ -0,0 +1,568 @@
+#include "search_results.h"
+#include "search_filter.h"
+#include "image_loader.h"
+#include "prerelease.h"
+#include "dnd_manager.h"
+#include <string.h>
+
+// 外部函数声明
+extern void draw_pixbuf_scaled(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer user_data);
+extern void on_drawing_area_destroy(GtkWidget *widget, gpointer user_data);
+extern void on_result_row_pressed(GtkGestureClick *gesture, int n_press, double x, double y, gpointer user_data);
+extern void on_result_row_released(GtkGestureClick *gesture, int n_press, double x, double y, gpointer user_data);
+extern void on_result_row_enter(GtkEventControllerMotion *controller, double x, double y, gpointer user_data);
+
+// ===== YgoCardItem =====
+
+struct _YgoCardItem {
+    GObject parent_instance;
+    CardPreview preview;
+};
+
+G_DEFINE_TYPE(YgoCardItem, ygo_card_item, G_TYPE_OBJECT)
+
+static void ygo_card_item_finalize(GObject *object) {
+    YgoCardItem *item = YGO_CARD_ITEM(object);
+    g_free(item->preview.cn_name);
+    g_free(item->preview.types);
+    g_free(item->preview.pdesc);
+    g_free(item->preview.desc);
+    G_OBJECT_CLASS(ygo_card_item_parent_class)->finalize(object);
+}
+
+static void ygo_card_item_class_init(YgoCardItemClass *klass) {
+    G_OBJECT_CLASS(klass)->finalize = ygo_card_item_finalize;
+}
+
+static void ygo_card_item_init(YgoCardItem *item) {
+    (void)item;
+}
+
+YgoCardItem* ygo_card_item_new_from_json(JsonObject *obj) {
+    YgoCardItem *item = g_object_new(YGO_TYPE_CARD_ITEM, NULL);
+    if (!obj) return item;
+    CardPreview *pv = &item->preview;
+
+    const char *name = NULL;
+    JsonObject *text = json_object_has_member(obj, "text") ? json_object_get_object_member(obj, "text") : NULL;
+
+    // 先检查是否有 text.name（先行卡格式）
+    if (text && json_object_has_member(text, "name")) {
+        name = json_object_get_string_member(text, "name");
+    }
+
+    // 如果没有 text.name，按原顺序查找其他名称
+    if (!name) name = json_object_get_string_member(obj, "cn_name");
+    if (!name) name = json_object_get_string_member(obj, "sc_name");
+    if (!name) name = json_object_get_string_member(obj, "jp_name");
+    if (!name) name = json_object_get_string_member(obj, "en_name");
+
+    if (json_object_has_member(obj, "id")) pv->id = json_object_get_int_member(obj, "id");
+    // cid 用于禁限卡表查询
+    if (json_object_has_member(obj, "cid")) pv->cid = json_object_get_int_member(obj, "cid");
+    pv->cn_name = name ? g_strdup(name) : NULL;
+
+    // 检查是否是先行卡（优先通过ID位数判断，9位数=先行卡）
+    pv->is_prerelease = (pv->id > 0 && is_prerelease_id(pv->id));
+    // 如果不是9位数，检查JSON中的标记（向后兼容）
+    if (!pv->is_prerelease && json_object_has_member(obj, "is_prerelease")) {
+        pv->is_prerelease = json_object_get_boolean_member(obj, "is_prerelease");
+    }
+
+    // 获取类型和其他 data 字段：先行卡的字段在顶层，普通卡的在 data 对象中
+    JsonObject *data = NULL;
+    if (pv->is_prerelease) {
+        data = obj;
+    } else if (json_object_has_member(obj, "data")) {
+        data = json_object_get_object_member(obj, "data");
+    }
+    if (data) {
+        if (json_object_has_member(data, "type")) {
+            pv->type = (uint32_t)json_object_get_int_member(data, "type");
+        }
+        pv->ot = json_object_has_member(data, "ot") ? json_object_get_int_member(data, "ot") : -1;
+        pv->setcode = json_object_has_member(data, "setcode") ? json_object_get_int_member(data, "setcode") : -1;
+        pv->atk = json_object_has_member(data, "atk") ? json_object_get_int_member(data, "atk") : -1;
+        pv->def = json_object_has_member(data, "def") ? json_object_get_int_member(data, "def") : -1;
+        pv->level = json_object_has_member(data, "level") ? json_object_get_int_member(data, "level") : -1;
+        pv->race = json_object_has_member(data, "race") ? json_object_get_int_member(data, "race") : -1;
+        pv->attribute = json_object_has_member(data, "attribute") ? json_object_get_int_member(data, "attribute") : -1;
+    }
+
+    if (text) {
+        if (json_object_has_member(text, "types")) pv->types = g_strdup(json_object_get_string_member(text, "types"));
+        if (json_object_has_member(text, "pdesc")) pv->pdesc = g_strdup(json_object_get_string_member(text, "pdesc"));
+        if (json_object_has_member(text, "desc"))  pv->desc  = g_strdup(json_object_get_string_member(text, "desc"));
+    }
+    return item;
+}
+
+const CardPreview* ygo_card_item_get_preview(YgoCardItem *item) {
+    return item ? &item->preview : NULL;
+}
+
+// ===== 行控件 =====
+
+const CardPreview* search_result_row_get_preview(GtkWidget *row) {
+    if (!row) return NULL;
+    YgoCardItem *item = (YgoCardItem*)g_object_get_data(G_OBJECT(row), "item");
+    return item ? &item->preview : NULL;
+}
+
+GtkWidget* search_result_row_get_picture(GtkWidget *row) {
+    if (!row) return NULL;
+    return (GtkWidget*)g_object_get_data(G_OBJECT(row), "picture");
+}
+
+// ===== 待加载缩略图索引 =====
+
+// img_id -> 等待加载该卡片缩略图的控件数组（同一张卡可能同时绑定在多行上；
+// 弱引用，控件销毁后自动置空）
+typedef struct {
+    GtkWidget *picture;
+    GtkStack *stack;
+} ThumbTarget;
+
+static void thumb_target_free(gpointer data) {
+    ThumbTarget *t = (ThumbTarget*)data;
+    if (!t) return;
+    if (t->picture) g_object_remove_weak_pointer(G_OBJECT(t->picture), (gpointer*)&t->picture);
+    if (t->stack) g_object_remove_weak_pointer(G_OBJECT(t->stack), (gpointer*)&t->stack);
+    g_free(t);
+}
+
+static void thumb_targets_add(SearchUI *ui, int img_id, GtkWidget *picture, GtkStack *stack) {
+    if (!ui->pending_thumb_targets) return;
+    GPtrArray *targets = g_hash_table_lookup(ui->pending_thumb_targets, GINT_TO_POINTER(img_id));
+    if (!targets) {
+        targets = g_ptr_array_new_with_free_func(thumb_target_free);
+        g_hash_table_insert(ui->pending_thumb_targets, GINT_TO_POINTER(img_id), targets);
+    }
+    ThumbTarget *t = g_new0(ThumbTarget, 1);
+    t->picture = picture;
+    t->stack = stack;
+    g_object_add_weak_pointer(G_OBJECT(picture), (gpointer*)&t->picture);
+    g_object_add_weak_pointer(G_OBJECT(stack), (gpointer*)&t->stack);
+    g_ptr_array_add(targets, t);
+}
+
+// 行解绑时移除该控件的登记，同时清理已销毁的控件
+static void thumb_targets_remove(SearchUI *ui, int img_id, GtkWidget *picture) {
+    if (!ui->pending_thumb_targets || img_id <= 0) return;
+    GPtrArray *targets = g_hash_table_lookup(ui->pending_thumb_targets, GINT_TO_POINTER(img_id));
+    if (!targets) return;
+    for (guint i = targets->len; i-- > 0;) {
+        ThumbTarget *t = g_ptr_array_index(targets, i);
+        if (!t->picture || t->picture == picture) g_ptr_array_remove_index_fast(targets, i);
+    }
+    if (targets->len == 0) g_hash_table_remove(ui->pending_thumb_targets, GINT_TO_POINTER(img_id));
+}
+
+// 行被回收时清空缩略图，避免显示上一张卡的图片
+static void row_reset_thumbnail(GtkWidget *row) {
+    GtkWidget *picture = search_result_row_get_picture(row);
+    GtkStack *stack = (GtkStack*)g_object_get_data(G_OBJECT(row), "thumb_stack");
+    if (picture) {
+        g_object_set_data(G_OBJECT(picture), "pending_img_id", GINT_TO_POINTER(0));
+        g_object_set_data(G_OBJECT(picture), "bound_img_id", GINT_TO_POINTER(0));
+        g_object_set_data(G_OBJECT(picture), "img_id", GINT_TO_POINTER(0));
+        g_object_set_data_full(G_OBJECT(picture), "pixbuf", NULL, NULL);
+        g_object_set_data_full(G_OBJECT(picture), "cached_surface", NULL, NULL);
+        g_object_set_data_full(G_OBJECT(picture), "cached_render", NULL, NULL);
+    }
+    if (stack) gtk_stack_set_visible_child_name(stack, "placeholder");
+}
+
+static void row_show_thumbnail(GtkWidget *row, GdkPixbuf *thumb) {
+    GtkWidget *picture = search_result_row_get_picture(row);
+    GtkStack *stack = (GtkStack*)g_object_get_data(G_OBJECT(row), "thumb_stack");
+    g_object_set_data_full(G_OBJECT(picture), "pixbuf", thumb, (GDestroyNotify)g_object_unref);
+    g_object_set_data_full(G_OBJECT(picture), "cached_surface", NULL, NULL);
+    g_object_set_data_full(G_OBJECT(picture), "cached_render", NULL, NULL);
+    gtk_widget_queue_draw(picture);
+    gtk_stack_set_visible_child_name(stack, "picture");
+}
+
+// 缩略图入队序号：同优先级的条目按入队顺序加载
+static guint image_queue_seq = 0;
+
+// 绑定行的缩略图：先查内存/磁盘缩略图缓存，未命中时加入加载队列
+static void row_bind_thumbnail(SearchUI *ui, GtkWidget *row, const CardPreview *pv) {
+    GtkWidget *picture = search_result_row_get_picture(row);
+    int id = pv->id;
+    // 记录行当前绑定的卡片；异步加载完成时据此判断控件是否已被回收给其他卡片
+    g_object_set_data(G_OBJECT(picture), "bound_img_id", GINT_TO_POINTER(id));
+    if (id <= 0) return;
+
+    if (!pv->is_prerelease) {
+        GdkPixbuf *cached = get_thumb_from_cache(id);
+        if (cached) {
+            g_object_set_data(G_OBJECT(picture), "img_id", GINT_TO_POINTER(id));
+            row_show_thumbnail(row, g_object_ref(cached));
+            return;
+        }
+
+        // 内存缓存未命中时，从磁盘缩略图缓存读取（按 HiDPI 倍率保存的小图，无需解码原图再缩放）；
+        // 只有原图时由加载队列按视口优先级交给解码线程生成，不在主线程解码原图
+        GdkPixbuf *thumb = load_thumb_from_thumb_pack(id, gtk_widget_get_scale_factor(picture));
+        if (thumb) {
+            g_object_set_data(G_OBJECT(picture), "img_id", GINT_TO_POINTER(id));
+            add_thumb_to_cache(id, thumb);
+            row_show_thumbnail(row, thumb);
+            return;
+        }
+    }
+
+    // 缓存未命中：加入加载队列（只有绑定在可见行上的卡片才会真正加载）
+    if (!ui->search_image_queue) {
+        ui->search_image_queue = g_ptr_array_new_with_free_func(g_free);
+    }
+    g_object_set_data(G_OBJECT(picture), "pending_img_id", GINT_TO_POINTER(id));
+    thumb_targets_add(ui, id, picture, (GtkStack*)g_object_get_data(G_OBJECT(row), "thumb_stack"));
+
+    SearchImageToLoad *load = g_new0(SearchImageToLoad, 1);
+    load->img_id = id;
+    load->is_prerelease = pv->is_prerelease;
+    load->seq = ++image_queue_seq;
+    g_ptr_array_add(ui->search_image_queue, load);
+    ui->image_queue_dirty = TRUE;
+
+    if (ui->search_image_loader_id == 0) {
+        ui->search_image_loader_id = g_timeout_add(20, search_load_next_image, ui);
+    }
+}
+
+static void row_bind_forbidden(SearchUI *ui, GtkWidget *row, const CardPreview *pv) {
+    GtkWidget *label = (GtkWidget*)g_object_get_data(G_OBJECT(row), "forbidden_label");
+    gtk_widget_remove_css_class(label, "error");
+    gtk_widget_remove_css_class(label, "warning");
+    gtk_widget_remove_css_class(label, "accent");
+
+    // 显示禁限状态（使用cid而非id）
+    const char *status = NULL;
+    if (pv->cid > 0 && ui->forbidden_dropdown) {
+        guint selected = gtk_drop_down_get_selected(ui->forbidden_dropdown);
+        GHashTable *forbidden_table = NULL;
+
+        if (selected == 0 && ui->ocg_forbidden) {
+            forbidden_table = ui->ocg_forbidden;
+        } else if (selected == 1 && ui->tcg_forbidden) {
+            forbidden_table = ui->tcg_forbidden;
+        } else if (selected == 2 && ui->sc_forbidden) {
+            forbidden_table = ui->sc_forbidden;
+        }
+
+        if (forbidden_table) {
+            char cid_str[32];
+            g_snprintf(cid_str, sizeof(cid_str), "%d", pv->cid);
+            status = g_hash_table_lookup(forbidden_table, cid_str);
+        }
+    }
+
+    if (!status) {
+        gtk_widget_set_visible(label, FALSE);
+        return;
+    }
+
+    char *markup = g_strdup_printf("<b>[%s]</b>", status);
+    gtk_label_set_markup(GTK_LABEL(label), markup);
+    g_free(markup);
+
+    // 根据不同状态设置不同样式
+    if (g_strcmp0(status, "禁止") == 0) {
+        gtk_widget_add_css_class(label, "error");
+    } else if (g_strcmp0(status, "限制") == 0) {
+        gtk_widget_add_css_class(label, "warning");
+    } else if (g_strcmp0(status, "准限制") == 0) {
+        gtk_widget_add_css_class(label, "accent");
+    }
+    gtk_widget_set_visible(label, TRUE);
+}
+
+// 创建行控件（只在 GtkListView 需要新行时调用，之后反复绑定不同条目）
+static void on_row_setup(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpointer user_data) {
+    (void)factory;
+    SearchUI *ui = (SearchUI*)user_data;
+
+    GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_set_margin_top(row, 6);
+    gtk_widget_set_margin_bottom(row, 6);
+    gtk_widget_set_margin_start(row, 8);
+    gtk_widget_set_margin_end(row, 8);
+
+    // 缩略图栈：占位与图片（强制 68x99 尺寸，避免单条结果时放大）
+    GtkWidget *thumb_stack = gtk_stack_new();
+    gtk_stack_set_transition_type(GTK_STACK(thumb_stack), GTK_STACK_TRANSITION_TYPE_CROSSFADE);
+    gtk_stack_set_transition_duration(GTK_STACK(thumb_stack), 150);
+    gtk_widget_set_size_request(thumb_stack, 68, 99);
+    gtk_widget_set_halign(thumb_stack, GTK_ALIGN_START);
+    gtk_widget_set_valign(thumb_stack, GTK_ALIGN_CENTER);
+    gtk_widget_set_hexpand(thumb_stack, FALSE);
+    gtk_widget_set_vexpand(thumb_stack, FALSE);
+    gtk_widget_add_css_class(thumb_stack, "thumb-fixed");
+    // 占位框 68x99，居中Spinner
+    GtkWidget *placeholder = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_widget_set_size_request(placeholder, 68, 99);
+    gtk_widget_set_valign(placeholder, GTK_ALIGN_CENTER);
+    gtk_widget_set_halign(placeholder, GTK_ALIGN_CENTER);
+    gtk_widget_add_css_class(placeholder, "thumb-fixed");
+    GtkWidget *spinner = gtk_spinner_new();
+    gtk_spinner_start(GTK_SPINNER(spinner));
+    gtk_box_append(GTK_BOX(placeholder), spinner);
+    gtk_stack_add_named(GTK_STACK(thumb_stack), placeholder, "placeholder");
+    // 图片控件：使用 GtkDrawingArea + Cairo 高质量缩放绘制
+    GtkWidget *picture = gtk_drawing_area_new();
+    gtk_widget_set_size_request(picture, 68, 99);
+    gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(picture), draw_pixbuf_scaled, NULL, NULL);
+    g_signal_connect(picture, "destroy", G_CALLBACK(on_drawing_area_destroy), NULL);
+    gtk_widget_set_halign(picture, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign(picture, GTK_ALIGN_CENTER);
+    gtk_widget_set_hexpand(picture, FALSE);
+    gtk_widget_set_vexpand(picture, FALSE);
+    gtk_widget_add_css_class(picture, "thumb-fixed");
+    // 标记为搜索结果缩略图，下载队列按视口位置为其排序
+    g_object_set_data(G_OBJECT(picture), "search_thumb", GINT_TO_POINTER(1));
+    gtk_stack_add_named(GTK_STACK(thumb_stack), picture, "picture");
+    gtk_stack_set_visible_child_name(GTK_STACK(thumb_stack), "placeholder");
+
+    // 文字容器：固定宽度 208px（右栏300 - 左右边距16 - 图片68 - 间距8）
+    // 防止文字区域扩展导致整行被拉伸
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+    gtk_widget_set_size_request(vbox, 208, -1);
+    gtk_widget_set_hexpand(vbox, FALSE);
+    gtk_widget_set_vexpand(vbox, FALSE);
+    gtk_widget_set_halign(vbox, GTK_ALIGN_START);
+    gtk_widget_set_valign(vbox, GTK_ALIGN_CENTER);
+
+    GtkWidget *title = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(title), 0.0);
+    gtk_label_set_ellipsize(GTK_LABEL(title), PANGO_ELLIPSIZE_END);
+    gtk_label_set_max_width_chars(GTK_LABEL(title), 20);
+
+    GtkWidget *subtitle = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(subtitle), 0.0);
+    gtk_label_set_ellipsize(GTK_LABEL(subtitle), PANGO_ELLIPSIZE_END);
+    gtk_label_set_max_width_chars(GTK_LABEL(subtitle), 20);
+    gtk_widget_add_css_class(subtitle, "dim-label");
+
+    // 禁限状态标签（绑定时按当前禁限卡表更新）
+    GtkWidget *forbidden_label = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(forbidden_label), 0.0);
+    gtk_widget_set_halign(forbidden_label, GTK_ALIGN_START);
+    gtk_widget_set_visible(forbidden_label, FALSE);
+
+    gtk_box_append(GTK_BOX(vbox), title);
+    gtk_box_append(GTK_BOX(vbox), subtitle);
+    gtk_box_append(GTK_BOX(vbox), forbidden_label);
+
+    // 防止 row 扩展
+    gtk_widget_set_hexpand(row, FALSE);
+    gtk_widget_set_halign(row, GTK_ALIGN_START);
+
+    gtk_box_append(GTK_BOX(row), thumb_stack);
+    gtk_box_append(GTK_BOX(row), vbox);
+
+    g_object_set_data(G_OBJECT(row), "thumb_stack", thumb_stack);
+    g_object_set_data(G_OBJECT(row), "picture", picture);
+    g_object_set_data(G_OBJECT(row), "title", title);
+    g_object_set_data(G_OBJECT(row), "subtitle", subtitle);
+    g_object_set_data(G_OBJECT(row), "forbidden_label", forbidden_label);
+
+    // 绑定悬停事件
+    GtkEventController *motion = GTK_EVENT_CONTROLLER(gtk_event_controller_motion_new());
+    g_signal_connect(motion, "enter", G_CALLBACK(on_result_row_enter), ui);
+    gtk_widget_add_controller(row, motion);
+    // 绑定点击事件（与中栏一致：pressed 记录、released 判定点击）
+    GtkGesture *click = gtk_gesture_click_new();
+    g_signal_connect(click, "pressed", G_CALLBACK(on_result_row_pressed), ui);
+    g_signal_connect(click, "released", G_CALLBACK(on_result_row_released), ui);
+    gtk_widget_add_controller(row, GTK_EVENT_CONTROLLER(click));
+    // 右栏行支持拖拽到中栏：提供字符串 payload "search:<id>:<isExtra>"
+    GtkDragSource *ds = gtk_drag_source_new();
+    // 与中栏一致，采用 MOVE 动作，确保目标接受
+    gtk_drag_source_set_actions(ds, GDK_ACTION_MOVE);
+    g_signal_connect(ds, "prepare", G_CALLBACK(on_drag_prepare), NULL);
+    g_signal_connect(ds, "drag-begin", G_CALLBACK(on_drag_begin), NULL);
+    // 在行上存储一个标记供 prepare 使用
+    g_object_set_data(G_OBJECT(row), "drag_kind", (gpointer)"search_row");
+    gtk_widget_add_controller(row, GTK_EVENT_CONTROLLER(ds));
+
+    gtk_list_item_set_child(list_item, row);
+}
+
+static void on_row_bind(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpointer user_data) {
+    (void)factory;
+    SearchUI *ui = (SearchUI*)user_data;
+    GtkWidget *row = gtk_list_item_get_child(list_item);
+    YgoCardItem *item = YGO_CARD_ITEM(gtk_list_item_get_item(list_item));
+    if (!row || !item) return;
+    const CardPreview *pv = &item->preview;
+
+    // 行持有条目引用，事件回调通过 search_result_row_get_preview 读取
+    g_object_set_data_full(G_OBJECT(row), "item", g_object_ref(item), g_object_unref);
+
+    gtk_label_set_text(GTK_LABEL(g_object_get_data(G_OBJECT(row), "title")), pv->cn_name ? pv->cn_name : "(无名)");
+    gtk_label_set_text(GTK_LABEL(g_object_get_data(G_OBJECT(row), "subtitle")), pv->types ? pv->types : "");
+    row_bind_forbidden(ui, row, pv);
+    row_bind_thumbnail(ui, row, pv);
+}
+
+static void on_row_unbind(GtkSignalListItemFactory *factory, GtkListItem *list_item, gpointer user_data) {
+    (void)factory;
+    SearchUI *ui = (SearchUI*)user_data;
+    GtkWidget *row = gtk_list_item_get_child(list_item);
+    if (!row) return;
+
+    GtkWidget *picture = search_result_row_get_picture(row);
+    if (picture) {
+        int pending_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(picture), "pending_img_id"));
+        thumb_targets_remove(ui, pending_id, picture);
+    }
+    row_reset_thumbnail(row);
+    g_object_set_data_full(G_OBJECT(row), "press_xy", NULL, NULL);
+    g_object_set_data_full(G_OBJECT(row), "item", NULL, NULL);
+}
+
+// ===== 视口优先级 =====
+
+int search_results_thumb_priority(SearchUI *ui, GtkWidget *picture, int img_id) {
+    if (!ui || !ui->list || !picture) return IMAGE_LOAD_PRIORITY_DROP;
+    // 行已被回收给其他卡片（或已解绑）
+    if (GPOINTER_TO_INT(g_object_get_data(G_OBJECT(picture), "bound_img_id")) != img_id) {
+        return IMAGE_LOAD_PRIORITY_DROP;
+    }
+    // 加载完成前显示的是占位页，图片控件本身没有分配位置，按所在的缩略图栈计算
+    GtkWidget *stack = gtk_widget_get_parent(picture);
+    int view_h = gtk_widget_get_height(ui->list);
+    graphene_rect_t bounds;
+    if (!stack || view_h <= 0 || !gtk_widget_compute_bounds(stack, ui->list, &bounds)) {
+        return IMAGE_LOAD_PRIORITY_BACKGROUND;
+    }
+    float top = graphene_rect_get_y(&bounds);
+    float bottom = top + graphene_rect_get_height(&bounds);
+    if (bottom > 0 && top < view_h) return IMAGE_LOAD_PRIORITY_VISIBLE;
+    // 预取范围：视口上下各一屏
+    if (bottom > -view_h && top < 2 * view_h) return IMAGE_LOAD_PRIORITY_PREFETCH;
+    return IMAGE_LOAD_PRIORITY_BACKGROUND;
+}
+
+static gint compare_image_to_load(gconstpointer a, gconstpointer b) {
+    const SearchImageToLoad *x = *(SearchImageToLoad* const*)a;
+    const SearchImageToLoad *y = *(SearchImageToLoad* const*)b;
+    if (x->priority != y->priority) return x->priority - y->priority;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+void search_results_sort_image_queue(SearchUI *ui) {
+    if (!ui || !ui->search_image_queue) return;
+    ui->image_queue_dirty = FALSE;
+
+    GPtrArray *queue = ui->search_image_queue;
+    for (guint i = queue->len; i-- > 0;) {
+        SearchImageToLoad *item = g_ptr_array_index(queue, i);
+        GPtrArray *targets = ui->pending_thumb_targets ?
+            g_hash_table_lookup(ui->pending_thumb_targets, GINT_TO_POINTER(item->img_id)) : NULL;
+        // 同一张卡绑定在多行上时，取其中最高的优先级
+        item->priority = IMAGE_LOAD_PRIORITY_DROP;
+        for (guint j = 0; targets && j < targets->len; j++) {
+            ThumbTarget *t = g_ptr_array_index(targets, j);
+            if (!t->picture) continue;
+            item->priority = MIN(item->priority, search_results_thumb_priority(ui, t->picture, item->img_id));
+        }
+        if (item->priority >= IMAGE_LOAD_PRIORITY_DROP) {
+            // 行已滚出并被回收，重新绑定时会再次入队（顺序随后重新排序，可以直接与末尾交换）
+            g_ptr_array_remove_index_fast(queue, i);
+        }
+    }
+    g_ptr_array_sort(queue, compare_image_to_load);
+}
+
+// 下载队列中搜索结果缩略图的优先级；卡组槽位、预览等其他目标保持原优先级
+static int search_thumb_load_priority(const ImageLoadCtx *ctx, gpointer user_data) {
+    if (!g_object_get_data(G_OBJECT(ctx->target), "search_thumb")) return ctx->priority;
+    return search_results_thumb_priority((SearchUI*)user_data, ctx->target, ctx->cache_id);
+}
+
+// 滚动停顿后的一次性重排：加载队列和 image_loader 中排队的下载
+static gboolean reprioritize_thumbs_idle(gpointer user_data) {
+    SearchUI *ui = (SearchUI*)user_data;
+    ui->thumb_reprioritize_id = 0;
+    ui->image_queue_dirty = TRUE;
+    image_loader_reprioritize(search_thumb_load_priority, ui);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_results_scrolled(GtkAdjustment *adj, gpointer user_data) {
+    (void)adj;
+    SearchUI *ui = (SearchUI*)user_data;
+    // 连续滚动时合并为一次重排
+    if (ui->thumb_reprioritize_id == 0) {
+        ui->thumb_reprioritize_id = g_idle_add(reprioritize_thumbs_idle, ui);
+    }
+}
+
+// 列表放入 GtkScrolledWindow 后才会拿到纵向 adjustment
+static void on_list_vadjustment_changed(GObject *list, GParamSpec *pspec, gpointer user_data) {
+    (void)pspec;
+    GtkAdjustment *adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(list));
+    if (adj) g_signal_connect(adj, "value-changed", G_CALLBACK(on_results_scrolled), user_data);
+}
+
+// ===== 列表 =====
+
+void search_results_init(SearchUI *ui) {
+    ui->results_store = g_list_store_new(YGO_TYPE_CARD_ITEM);
+    ui->pending_thumb_targets = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                                      (GDestroyNotify)g_ptr_array_unref);
+
+    GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
+    g_signal_connect(factory, "setup", G_CALLBACK(on_row_setup), ui);
+    g_signal_connect(factory, "bind", G_CALLBACK(on_row_bind), ui);
+    g_signal_connect(factory, "unbind", G_CALLBACK(on_row_unbind), ui);
+
+    // 结果行不需要选中状态；GtkListView 接管模型和工厂的引用
+    GtkNoSelection *selection = gtk_no_selection_new(G_LIST_MODEL(g_object_ref(ui->results_store)));
+    ui->list = gtk_list_view_new(GTK_SELECTION_MODEL(selection), factory);
+    g_signal_connect(ui->list, "notify::vadjustment", G_CALLBACK(on_list_vadjustment_changed), ui);
+}
+
+void search_results_clear(SearchUI *ui) {
+    if (!ui || !ui->results_store) return;
+    if (ui->pending_thumb_targets) g_hash_table_remove_all(ui->pending_thumb_targets);
+    g_list_store_remove_all(ui->results_store);
+}
+
+void search_results_append(SearchUI *ui, GPtrArray *items) {
+    if (!ui || !ui->results_store || !items || items->len == 0) return;
+    guint n = g_list_model_get_n_items(G_LIST_MODEL(ui->results_store));
+    g_list_store_splice(ui->results_store, n, 0, items->pdata, items->len);
+}
+
+guint search_results_get_count(SearchUI *ui) {
+    if (!ui || !ui->results_store) return 0;
+    return g_list_model_get_n_items(G_LIST_MODEL(ui->results_store));
+}
+
+GtkWidget* search_results_find_pending_picture(SearchUI *ui, int img_id, GtkStack **stack_out) {
+    if (stack_out) *stack_out = NULL;
+    if (!ui || !ui->pending_thumb_targets || img_id <= 0) return NULL;
+
+    GPtrArray *targets = g_hash_table_lookup(ui->pending_thumb_targets, GINT_TO_POINTER(img_id));
+    if (!targets) return NULL;
+
+    // 每个加载队列项取出一行（每次绑定各入队一次），优先取最近绑定的行
+    GtkWidget *picture = NULL;
+    while (targets->len > 0 && !picture) {
+        ThumbTarget *t = g_ptr_array_index(targets, targets->len - 1);
+        // 控件已销毁或已不再等待该卡片（例如已从缓存显示）的登记直接丢弃
+        if (t->picture && t->stack &&
+            GPOINTER_TO_INT(g_object_get_data(G_OBJECT(t->picture), "pending_img_id")) == img_id) {
+            picture = t->picture;
+            if (stack_out) *stack_out = t->stack;
+        }
+        // 已取出加载，不再需要登记
+        g_ptr_array_remove_index(targets, targets->len - 1);
+    }
+    if (targets->len == 0) g_hash_table_remove(ui->pending_thumb_targets, GINT_TO_POINTER(img_id));
+    return picture;
+}
@@ -0,0 +1,69 @@
+#ifndef SEARCH_RESULTS_H
+#define SEARCH_RESULTS_H
+
+#include <gtk/gtk.h>
+#include <json-glib/json-glib.h>
+#include "app_types.h"
+
+// 右栏搜索结果列表：GListStore 中存放轻量的卡片条目（YgoCardItem），
+// 由 GtkListView 按需创建并回收行控件。无论结果有多少条，控件数量只与可见行数有关。
+
+#define YGO_TYPE_CARD_ITEM (ygo_card_item_get_type())
+G_DECLARE_FINAL_TYPE(YgoCardItem, ygo_card_item, YGO, CARD_ITEM, GObject)
+
+/**
+ * 从搜索结果 JSON（先行卡/离线/在线结构）创建卡片条目
+ * @return 新的条目，调用者需要 g_object_unref 释放
+ */
+YgoCardItem* ygo_card_item_new_from_json(JsonObject *obj);
+
+/**
+ * 获取条目中的卡片信息（由条目持有，不需要释放）
+ */
+const CardPreview* ygo_card_item_get_preview(YgoCardItem *item);
+
+/**
+ * 创建结果列表（模型、行工厂和 GtkListView），并赋值给 ui->list
+ */
+void search_results_init(SearchUI *ui);
+
+/**
+ * 清空结果列表
+ */
+void search_results_clear(SearchUI *ui);
+
+/**
+ * 批量追加条目（一次 items-changed）
+ * @param items YgoCardItem* 数组，不会被修改
+ */
+void search_results_append(SearchUI *ui, GPtrArray *items);
+
+guint search_results_get_count(SearchUI *ui);
+
+/**
+ * 取出一个当前绑定到 img_id 且仍在等待加载图片的行（哈希表查找）
+ * 同一张卡可能绑定在多行上，每次取出其中最近绑定的一行；
+ * 行绑定时登记、解绑或清空列表时移除；取出后登记即被移除
+ * @param stack_out 输出行内的缩略图栈
+ * @return 行内的图片控件；该卡片当前没有绑定到任何可见行时返回 NULL
+ */
+GtkWidget* search_results_find_pending_picture(SearchUI *ui, int img_id, GtkStack **stack_out);
+
+/**
+ * 按缩略图所在行相对结果列表视口的位置计算加载优先级
+ * @param picture 行内的图片控件
+ * @param img_id 要加载的卡片ID
+ * @return ImageLoadPriority：视口内、上下各一屏的预取范围、其余；行已不再绑定该卡片时返回 DROP
+ */
+int search_results_thumb_priority(SearchUI *ui, GtkWidget *picture, int img_id);
+
+/**
+ * 按视口位置重新排列缩略图加载队列（视口内优先，其次预取范围），并移除已失效的条目
+ */
+void search_results_sort_image_queue(SearchUI *ui);
+
+// 行控件访问（row 为事件控制器所在的行控件；行未绑定条目时返回 NULL）
+const CardPreview* search_result_row_get_preview(GtkWidget *row);
+GtkWidget* search_result_row_get_picture(GtkWidget *row);
+
+#endif // SEARCH_RESULTS_H